@@ -3,8 +3,6 @@
 #include <QPainter>
 #include <QPainterPath>
 #include <QLayout>
-#include <QEvent>
-#include <QMoveEvent>
 #include "bubble_tool_button.h"
 
 namespace {
@@ -17,11 +15,10 @@ constexpr int g_bubbleButtonTipTime = 1500;
 constexpr int g_bubbleWidgetContentMargin = 7;
 } // namespace
 
-BubbleWidget::BubbleWidget(QWidget* const anchor)
-    : QDialog(anchor), _anchor(anchor), _label(new QLabel(this))
+BubbleWidget::BubbleWidget(QWidget* anchor, QWidget* boundary)
+    : QWidget(boundary), _anchor(anchor), _label(new QLabel(this))
 {
-    setModal(false);
-    setWindowFlags(windowFlags() | Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
     auto* layout = new QHBoxLayout(this);
     layout->addSpacing(g_arrowWidth);
     layout->addWidget(_label);
@@ -29,17 +26,25 @@ BubbleWidget::BubbleWidget(QWidget* const anchor)
                                         g_bubbleWidgetContentMargin, g_bubbleWidgetContentMargin));
     _label->setText(g_defaultBubbleText);
     setLayout(layout);
-    setAttribute(Qt::WA_TranslucentBackground);
-    move(_anchor->mapToGlobal(QPoint(_anchor->width(), _anchor->height() / 2 - height() / 2)));
+    hide();
+}
 
-    auto* current = _anchor;
-    while (current) {
-        current->installEventFilter(this);
-        current = current->parentWidget();
-    }
+void BubbleWidget::setText(const QString& text)
+{
+    _label->setText(text);
+    adjustSize();
 }
 
-void BubbleWidget::setText(const QString& text) { _label->setText(text); }
+void BubbleWidget::follow()
+{
+    const QPoint tip =
+        _anchor->mapTo(parentWidget(), QPoint(_anchor->width(), _anchor->height() / 2));
+    if (!parentWidget()->rect().contains(tip)) {
+        hide();
+        return;
+    }
+    move(tip.x(), tip.y() - height() / 2);
+}
 
 void BubbleWidget::paintEvent(QPaintEvent* event)
 {
@@ -63,75 +68,94 @@ void BubbleWidget::paintEvent(QPaintEvent* event)
     path.closeSubpath();
     painter.drawPath(path);
 
-    QDialog::paintEvent(event);
+    QWidget::paintEvent(event);
 }
 
-bool BubbleWidget::eventFilter(QObject* watched, QEvent* event)
+BubbleToolButton::BubbleToolButton(QWidget* parent) : QToolButton(parent)
 {
-    if (event->type() == QEvent::Move) {
-        auto* moveEvent = static_cast<QMoveEvent*>(event);
-        auto* movingWidget = static_cast<QWidget*>(watched);
-        if (movingWidget == _anchor) {
-            move(_anchor->mapToGlobal(
-                QPoint(_anchor->width(), _anchor->height() / 2 - height() / 2)));
-        } else {
-            move(pos() + moveEvent->pos() - moveEvent->oldPos());
-        }
-        return false;
-    } else if (event->type() == QEvent::Hide) {
-        hide();
-        return false;
-    }
-    return QObject::eventFilter(watched, event);
+    connect(this, &QToolButton::clicked, this, &BubbleToolButton::onClicked);
+    _timer.setSingleShot(true);
+    _timer.setInterval(g_bubbleButtonTipTime);
+    connect(&_timer, &QTimer::timeout, this, &BubbleToolButton::onTimeOut, Qt::QueuedConnection);
 }
 
-void BubbleWidget::moveEvent(QMoveEvent* event)
+BubbleToolButton::~BubbleToolButton() { delete _bubbleWidget; }
+
+void BubbleToolButton::setClickedIcon(const QIcon& icon)
 {
-    if (!_boundary) {
-        return QDialog::moveEvent(event);
-    }
-    if (!_boundary->rect()
-             .translated(_boundary->mapToGlobal(QPoint(0, 0)))
-             .contains(event->pos())) {
-        hide();
-    }
-    return QDialog::moveEvent(event);
+    _clickedIcon = icon;
+    _clickedIconReady = false;
 }
 
-BubbleToolButton::BubbleToolButton(QWidget* parent)
-    : QToolButton(parent), _bubbleWidget(new BubbleWidget(this))
+void BubbleToolButton::setBubbleText(const QString& text)
 {
-    connect(this, &QToolButton::clicked, this, &BubbleToolButton::onClicked);
-    _timer.setSingleShot(true);
-    _timer.setInterval(g_bubbleButtonTipTime);
-    connect(&_timer, &QTimer::timeout, this, &BubbleToolButton::onTimeOut, Qt::QueuedConnection);
+    _bubbleText = text;
+    if (_bubbleWidget)
+        _bubbleWidget->setText(text);
 }
 
-void BubbleToolButton::setClickedIcon(const QIcon& icon)
+void BubbleToolButton::setBubbleBoundary(QWidget* widget)
 {
-    QIcon copy = icon;
-    copy.addPixmap(icon.pixmap(200), QIcon::Disabled);
-    _clickedIcon = copy;
+    _bubbleBoundary = widget;
+    delete _bubbleWidget;
+}
+
+void BubbleToolButton::followBubble()
+{
+    if (_bubbleWidget && _bubbleWidget->isVisible())
+        _bubbleWidget->follow();
+}
+
+void BubbleToolButton::raiseBubble()
+{
+    if (_bubbleWidget && _bubbleWidget->isVisible())
+        _bubbleWidget->raise();
+}
+
+void BubbleToolButton::hideEvent(QHideEvent* event)
+{
+    if (_bubbleWidget)
+        _bubbleWidget->hide();
+    QToolButton::hideEvent(event);
+}
+
+BubbleWidget* BubbleToolButton::bubbleWidget()
+{
+    if (!_bubbleWidget) {
+        _bubbleWidget = new BubbleWidget(this, _bubbleBoundary ? _bubbleBoundary.data() : window());
+        if (!_bubbleText.isNull())
+            _bubbleWidget->setText(_bubbleText);
+    }
+    return _bubbleWidget;
 }
 
 void BubbleToolButton::onClicked()
 {
     if (_clickedIcon.isNull())
         return;
+    // The button is disabled while the clicked icon shows, which would gray it out otherwise.
+    if (!_clickedIconReady) {
+        _clickedIcon.addPixmap(_clickedIcon.pixmap(200), QIcon::Disabled);
+        _clickedIconReady = true;
+    }
     _previousIcon = icon();
     setIcon(_clickedIcon);
     setEnabled(false);
 
     _timer.start();
-    _bubbleWidget->show();
-    _bubbleWidget->setEnabled(true);
+    BubbleWidget* bubble = bubbleWidget();
+    bubble->adjustSize();
+    bubble->show();
+    bubble->raise();
+    bubble->follow();
 }
 
 void BubbleToolButton::onTimeOut()
 {
     setIcon(_previousIcon);
     setEnabled(true);
-    _bubbleWidget->hide();
+    if (_bubbleWidget)
+        _bubbleWidget->hide();
 }
 
 #include "moc_bubble_tool_button.cpp"
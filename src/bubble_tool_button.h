@@ -3,48 +3,65 @@
 
 #include <QToolButton>
 #include <QTimer>
-#include <QDialog>
 #include <QPointer>
 
 class QLabel;
 
-class BubbleWidget : public QDialog
+// A bubble pointing at the right edge of its anchor, painted as a child of a boundary widget that
+// contains the anchor, so it needs neither a native window nor event filters. It is clipped to
+// the boundary and costs nothing while hidden.
+class BubbleWidget : public QWidget
 {
     Q_OBJECT
 public:
-    explicit BubbleWidget(QWidget* const anchor);
+    BubbleWidget(QWidget* anchor, QWidget* boundary);
     void setText(const QString& text);
-    void setBoundary(QWidget* widget) { _boundary = widget; }
+    // Moves next to the anchor, or hides when the anchor has left the boundary.
+    void follow();
 
 protected:
     void paintEvent(QPaintEvent* event) override;
-    bool eventFilter(QObject* watched, QEvent* event) override;
-    void moveEvent(QMoveEvent* event) override;
 
 private:
     QWidget* const _anchor;
-    QPointer<QWidget> _boundary;
     QLabel* const _label;
 };
 
+// Shows the clicked icon and a bubble for a moment after each click. The bubble and the
+// disabled form of the clicked icon are only created on the first click. The bubble is drawn
+// within the bubble boundary, the window when none is set, and whoever moves the button within
+// it calls followBubble().
 class BubbleToolButton : public QToolButton
 {
     Q_OBJECT
 public:
     explicit BubbleToolButton(QWidget* parent);
+    ~BubbleToolButton();
     void setClickedIcon(const QIcon& icon);
     void setBubbleText(const QString& text);
-    BubbleWidget* const bubbleWidget() const { return _bubbleWidget; }
+    void setBubbleBoundary(QWidget* widget);
+    void followBubble();
+    // Raises the bubble, if shown, above the widgets in its boundary.
+    void raiseBubble();
+
+protected:
+    void hideEvent(QHideEvent* event) override;
 
 protected slots:
     void onClicked();
     void onTimeOut();
 
 private:
+    BubbleWidget* bubbleWidget();
+
     QIcon _clickedIcon;
     QIcon _previousIcon;
+    bool _clickedIconReady = false;
     QTimer _timer;
-    BubbleWidget* const _bubbleWidget;
+    QString _bubbleText;
+    QPointer<QWidget> _bubbleBoundary;
+    // Owned by the boundary, which may be destroyed first.
+    QPointer<BubbleWidget> _bubbleWidget;
 };
 
 #endif // BUBBLE_TOOL_BUTTON_H
@@ -0,0 +1,119 @@
+#include <QPromise>
+#include <QtConcurrent>
+
+#include "core/number_text.h"
+#include "bulk_evaluator.h"
+
+namespace {
+constexpr int g_progressStep = 1024;
+
+// Numbers keep 15 significant digits like typed ones.
+bool parseColumnValue(const QString& line, double* value)
+{
+    if (!core::parseNumber(line.trimmed().toStdString(), value))
+        return false;
+    *value = core::roundToDisplayPrecision(*value);
+    return true;
+}
+
+// Whether line is a single number as the arithmetic reads it, "0xFF" in programmer mode.
+bool isPlainNumber(const QString& line, core::Arithmetic arithmetic)
+{
+    double value = 0;
+    if (arithmetic != core::Arithmetic::Integer)
+        return parseColumnValue(line, &value);
+    int64_t integer = 0;
+    return core::parseInteger(line.trimmed().toStdString(), &integer);
+}
+
+void evaluateLines(QPromise<PastedLines>& promise, const QStringList& lines,
+                   core::Arithmetic arithmetic, core::Base base,
+                   const std::shared_ptr<int>& invalidLines)
+{
+    promise.setProgressRange(0, lines.size());
+    int firstLine = 0;
+    while (firstLine < lines.size() && lines[firstLine].trimmed().isEmpty())
+        ++firstLine;
+    double value = 0;
+    const bool column = firstLine < lines.size() && isPlainNumber(lines[firstLine], arithmetic);
+    PastedLines pasted;
+    if (column && arithmetic == core::Arithmetic::Integer) {
+        pasted.unsupportedColumn = true;
+        promise.addResult(std::move(pasted));
+        return;
+    }
+    if (column)
+        pasted.column.reserve(lines.size());
+    else
+        pasted.equations.reserve(lines.size());
+    for (int i = 0; i < lines.size(); ++i) {
+        if (i % g_progressStep == 0) {
+            if (promise.isCanceled())
+                return;
+            promise.setProgressValue(i);
+        }
+        if (lines[i].trimmed().isEmpty())
+            continue;
+        if (column) {
+            if (parseColumnValue(lines[i], &value))
+                pasted.column.push_back(value);
+            else
+                ++*invalidLines;
+            continue;
+        }
+        core::Equation equation;
+        if (!core::Equation::parse(lines[i].toStdString(), &equation, arithmetic, base)) {
+            ++*invalidLines;
+            continue;
+        }
+        pasted.equations.push_back(std::move(equation));
+    }
+    if (promise.isCanceled())
+        return;
+    promise.setProgressValue(lines.size());
+    promise.addResult(std::move(pasted));
+}
+} // namespace
+
+BulkEvaluator::BulkEvaluator(QObject* parent) : QObject(parent)
+{
+    connect(&_watcher, &QFutureWatcherBase::progressRangeChanged, this,
+            &BulkEvaluator::progressRangeChanged);
+    connect(&_watcher, &QFutureWatcherBase::progressValueChanged, this,
+            &BulkEvaluator::progressValueChanged);
+    connect(&_watcher, &QFutureWatcherBase::finished, this, &BulkEvaluator::onFinished);
+}
+
+BulkEvaluator::~BulkEvaluator()
+{
+    _watcher.cancel();
+    _watcher.waitForFinished();
+}
+
+void BulkEvaluator::start(const QString& text, core::Arithmetic arithmetic, core::Base base)
+{
+    if (isRunning())
+        return;
+    _invalidLines = std::make_shared<int>(0);
+    const QStringList lines = text.split(QChar('\n'));
+    _watcher.setFuture(QtConcurrent::run(evaluateLines, lines, arithmetic, base, _invalidLines));
+}
+
+void BulkEvaluator::cancel() { _watcher.cancel(); }
+
+void BulkEvaluator::onFinished()
+{
+    if (_watcher.isCanceled() || _watcher.future().resultCount() == 0) {
+        emit canceled();
+        return;
+    }
+    PastedLines pasted = _watcher.result();
+    if (pasted.unsupportedColumn)
+        emit columnUnsupported();
+    else if (!pasted.column.empty())
+        emit columnFinished(std::move(pasted.column), *_invalidLines);
+    else
+        emit finished(std::move(pasted.equations), *_invalidLines);
+}
+
+#include "moc_bulk_evaluator.cpp"
@@ -0,0 +1,56 @@
+#ifndef BULK_EVALUATOR_H
+#define BULK_EVALUATOR_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <vector>
+
+#include "core/equation.h"
+
+// What pasted text turns into: an equation per line, or a column of numbers when the first
+// non-empty line is a plain number, see EquationQueue::appendColumn().
+struct PastedLines
+{
+    std::vector<core::Equation> equations;
+    std::vector<double> column;
+    // A column pasted in programmer mode, which has no column mode.
+    bool unsupportedColumn = false;
+};
+
+// Parses and evaluates pasted multi-line text on a worker thread. Only the finished equations
+// are handed to the GUI thread, in one piece.
+class BulkEvaluator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BulkEvaluator(QObject* parent = nullptr);
+    ~BulkEvaluator();
+
+    bool isRunning() const { return _watcher.isRunning(); }
+    // Lines are read with the arithmetic and base of the line being typed.
+    void start(const QString& text, core::Arithmetic arithmetic = core::Arithmetic::Double,
+               core::Base base = core::Base::Decimal);
+
+public slots:
+    void cancel();
+
+signals:
+    void progressRangeChanged(int minimum, int maximum);
+    void progressValueChanged(int value);
+    // invalidLines counts non-empty lines that could not be evaluated.
+    void finished(std::vector<core::Equation> equations, int invalidLines);
+    // Instead of finished() for a column, invalidLines counts lines that are not numbers.
+    void columnFinished(std::vector<double> values, int invalidLines);
+    // Instead of finished() for a column pasted in programmer mode.
+    void columnUnsupported();
+    void canceled();
+
+private slots:
+    void onFinished();
+
+private:
+    QFutureWatcher<PastedLines> _watcher;
+    std::shared_ptr<int> _invalidLines;
+};
+
+#endif // BULK_EVALUATOR_H
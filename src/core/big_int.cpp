@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "core/big_int.h"
+
+namespace {
+constexpr uint64_t g_limbBase = uint64_t(1) << 32;
+constexpr uint32_t g_decimalChunk = 1000000000;
+constexpr size_t g_decimalChunkDigits = 9;
+
+int leadingZeroBits(uint32_t value)
+{
+    int count = 0;
+    for (uint32_t bit = uint32_t(1) << 31; bit && !(value & bit); bit >>= 1)
+        ++count;
+    return count;
+}
+
+void multiplyAddSmall(std::vector<uint32_t>& limbs, uint32_t factor, uint32_t addend)
+{
+    uint64_t carry = addend;
+    for (uint32_t& limb : limbs) {
+        const uint64_t product = uint64_t(limb) * factor + carry;
+        limb = uint32_t(product);
+        carry = product >> 32;
+    }
+    if (carry)
+        limbs.push_back(uint32_t(carry));
+}
+} // namespace
+
+namespace core {
+BigInt::BigInt(int64_t value) : _negative(value < 0)
+{
+    uint64_t magnitude = value < 0 ? ~uint64_t(value) + 1 : uint64_t(value);
+    for (; magnitude; magnitude >>= 32)
+        _limbs.push_back(uint32_t(magnitude));
+}
+
+BigInt::BigInt(Limbs limbs, bool negative) : _limbs(std::move(limbs)), _negative(negative)
+{
+    trim();
+}
+
+BigInt BigInt::fromDecimal(std::string_view digits)
+{
+    BigInt result;
+    size_t i = 0;
+    // The first chunk takes the remainder so that all others have exactly nine digits.
+    size_t chunkLength = digits.size() % g_decimalChunkDigits;
+    if (chunkLength == 0)
+        chunkLength = g_decimalChunkDigits;
+    while (i < digits.size()) {
+        uint32_t chunk = 0;
+        uint32_t scale = 1;
+        for (size_t end = i + chunkLength; i < end; ++i) {
+            chunk = chunk * 10 + uint32_t(digits[i] - '0');
+            scale *= 10;
+        }
+        multiplyAddSmall(result._limbs, scale, chunk);
+        chunkLength = g_decimalChunkDigits;
+    }
+    result.trim();
+    return result;
+}
+
+BigInt BigInt::powerOfTen(unsigned exponent)
+{
+    BigInt result(1);
+    for (; exponent >= g_decimalChunkDigits; exponent -= g_decimalChunkDigits)
+        multiplyAddSmall(result._limbs, g_decimalChunk, 0);
+    uint32_t rest = 1;
+    for (; exponent > 0; --exponent)
+        rest *= 10;
+    multiplyAddSmall(result._limbs, rest, 0);
+    return result;
+}
+
+bool BigInt::fitsInt64() const
+{
+    if (_limbs.size() > 2)
+        return false;
+    const uint64_t magnitude = low64();
+    // INT64_MIN is left out so that every fitting value can be negated.
+    return magnitude <= uint64_t(INT64_MAX);
+}
+
+int64_t BigInt::toInt64() const
+{
+    const uint64_t magnitude = low64();
+    return _negative ? -int64_t(magnitude) : int64_t(magnitude);
+}
+
+uint64_t BigInt::low64() const
+{
+    return _limbs.empty() ? 0 : _limbs[0] | (_limbs.size() > 1 ? uint64_t(_limbs[1]) << 32 : 0);
+}
+
+size_t BigInt::bitLength() const
+{
+    if (_limbs.empty())
+        return 0;
+    return _limbs.size() * 32 - size_t(leadingZeroBits(_limbs.back()));
+}
+
+size_t BigInt::trailingZeroBits() const
+{
+    size_t bits = 0;
+    size_t i = 0;
+    for (; i < _limbs.size() && _limbs[i] == 0; ++i)
+        bits += 32;
+    if (i < _limbs.size()) {
+        for (uint32_t limb = _limbs[i]; !(limb & 1); limb >>= 1)
+            ++bits;
+    }
+    return bits;
+}
+
+std::string BigInt::toString() const
+{
+    if (isZero())
+        return "0";
+    BigInt rest = abs();
+    std::vector<uint32_t> chunks;
+    while (!rest.isZero())
+        chunks.push_back(rest.divideBySmall(g_decimalChunk));
+    std::string result = _negative ? "-" : "";
+    result += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        const std::string chunk = std::to_string(chunks[i]);
+        result.append(g_decimalChunkDigits - chunk.size(), '0');
+        result += chunk;
+    }
+    return result;
+}
+
+BigInt BigInt::operator-() const
+{
+    BigInt result = *this;
+    if (!result.isZero())
+        result._negative = !result._negative;
+    return result;
+}
+
+BigInt BigInt::abs() const { return BigInt(_limbs, false); }
+
+BigInt BigInt::shiftedLeft(size_t bits) const
+{
+    if (isZero())
+        return *this;
+    Limbs limbs(bits / 32, 0);
+    const unsigned shift = bits % 32;
+    uint32_t carry = 0;
+    for (const uint32_t limb : _limbs) {
+        limbs.push_back(shift ? (limb << shift) | carry : limb);
+        carry = shift ? limb >> (32 - shift) : 0;
+    }
+    if (carry)
+        limbs.push_back(carry);
+    return BigInt(std::move(limbs), _negative);
+}
+
+BigInt BigInt::shiftedRight(size_t bits) const
+{
+    const size_t skipped = bits / 32;
+    if (skipped >= _limbs.size())
+        return BigInt();
+    const unsigned shift = bits % 32;
+    Limbs limbs(_limbs.begin() + skipped, _limbs.end());
+    for (size_t i = 0; shift && i < limbs.size(); ++i) {
+        limbs[i] >>= shift;
+        if (i + 1 < limbs.size())
+            limbs[i] |= limbs[i + 1] << (32 - shift);
+    }
+    return BigInt(std::move(limbs), _negative);
+}
+
+void BigInt::divide(const BigInt& dividend, const BigInt& divisor, BigInt* quotient,
+                    BigInt* remainder)
+{
+    if (divisor.isZero())
+        throw std::domain_error("Division by zero");
+    Limbs quotientLimbs;
+    Limbs remainderLimbs;
+    divideMagnitude(dividend._limbs, divisor._limbs, &quotientLimbs, &remainderLimbs);
+    if (quotient)
+        *quotient = BigInt(std::move(quotientLimbs), dividend._negative != divisor._negative);
+    if (remainder)
+        *remainder = BigInt(std::move(remainderLimbs), dividend._negative);
+}
+
+uint32_t BigInt::divideBySmall(uint32_t divisor)
+{
+    uint64_t remainder = 0;
+    for (size_t i = _limbs.size(); i-- > 0;) {
+        const uint64_t current = (remainder << 32) | _limbs[i];
+        _limbs[i] = uint32_t(current / divisor);
+        remainder = current % divisor;
+    }
+    trim();
+    return uint32_t(remainder);
+}
+
+BigInt BigInt::gcd(BigInt a, BigInt b)
+{
+    a._negative = false;
+    b._negative = false;
+    while (!b.isZero()) {
+        BigInt remainder;
+        divide(a, b, nullptr, &remainder);
+        a = std::move(b);
+        b = std::move(remainder);
+    }
+    return a;
+}
+
+BigInt operator+(const BigInt& a, const BigInt& b) { return BigInt::addSigned(a, b, false); }
+
+BigInt operator-(const BigInt& a, const BigInt& b) { return BigInt::addSigned(a, b, true); }
+
+BigInt operator*(const BigInt& a, const BigInt& b)
+{
+    return BigInt(BigInt::multiplyMagnitude(a._limbs, b._limbs), a._negative != b._negative);
+}
+
+BigInt operator/(const BigInt& a, const BigInt& b)
+{
+    BigInt quotient;
+    BigInt::divide(a, b, &quotient, nullptr);
+    return quotient;
+}
+
+BigInt operator%(const BigInt& a, const BigInt& b)
+{
+    BigInt remainder;
+    BigInt::divide(a, b, nullptr, &remainder);
+    return remainder;
+}
+
+int BigInt::compare(const BigInt& a, const BigInt& b)
+{
+    if (a._negative != b._negative)
+        return a._negative ? -1 : 1;
+    const int magnitude = compareMagnitude(a._limbs, b._limbs);
+    return a._negative ? -magnitude : magnitude;
+}
+
+void BigInt::trim()
+{
+    while (!_limbs.empty() && _limbs.back() == 0)
+        _limbs.pop_back();
+    if (_limbs.empty())
+        _negative = false;
+}
+
+int BigInt::compareMagnitude(const Limbs& a, const Limbs& b)
+{
+    if (a.size() != b.size())
+        return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+BigInt::Limbs BigInt::addMagnitude(const Limbs& a, const Limbs& b)
+{
+    const Limbs& longer = a.size() >= b.size() ? a : b;
+    const Limbs& shorter = a.size() >= b.size() ? b : a;
+    Limbs result(longer.size() + 1, 0);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < longer.size(); ++i) {
+        const uint64_t sum = uint64_t(longer[i]) + (i < shorter.size() ? shorter[i] : 0) + carry;
+        result[i] = uint32_t(sum);
+        carry = sum >> 32;
+    }
+    result.back() = uint32_t(carry);
+    return result;
+}
+
+BigInt::Limbs BigInt::subtractMagnitude(const Limbs& a, const Limbs& b)
+{
+    Limbs result(a.size(), 0);
+    int64_t borrow = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        int64_t difference = int64_t(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+        borrow = difference < 0;
+        if (borrow)
+            difference += int64_t(g_limbBase);
+        result[i] = uint32_t(difference);
+    }
+    return result;
+}
+
+BigInt::Limbs BigInt::multiplyMagnitude(const Limbs& a, const Limbs& b)
+{
+    if (a.empty() || b.empty())
+        return Limbs();
+    Limbs result(a.size() + b.size(), 0);
+    for (size_t i = 0; i < a.size(); ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < b.size(); ++j) {
+            const uint64_t product = uint64_t(a[i]) * b[j] + result[i + j] + carry;
+            result[i + j] = uint32_t(product);
+            carry = product >> 32;
+        }
+        result[i + b.size()] = uint32_t(carry);
+    }
+    return result;
+}
+
+// Knuth's algorithm D (TAOCP 4.3.1) on normalized operands.
+void BigInt::divideMagnitude(const Limbs& a, const Limbs& b, Limbs* quotient, Limbs* remainder)
+{
+    if (compareMagnitude(a, b) < 0) {
+        quotient->clear();
+        *remainder = a;
+        return;
+    }
+    if (b.size() == 1) {
+        BigInt rest(a, false);
+        const uint32_t small = rest.divideBySmall(b[0]);
+        *quotient = std::move(rest._limbs);
+        *remainder = small ? Limbs{small} : Limbs();
+        return;
+    }
+    const size_t n = b.size();
+    const size_t m = a.size() - n;
+    const int shift = leadingZeroBits(b.back());
+    Limbs v(n);
+    Limbs u(a.size() + 1);
+    for (size_t i = n; i-- > 0;)
+        v[i] = (b[i] << shift) | (shift && i > 0 ? b[i - 1] >> (32 - shift) : 0);
+    u[a.size()] = shift ? a.back() >> (32 - shift) : 0;
+    for (size_t i = a.size(); i-- > 0;)
+        u[i] = (a[i] << shift) | (shift && i > 0 ? a[i - 1] >> (32 - shift) : 0);
+
+    quotient->assign(m + 1, 0);
+    for (size_t j = m + 1; j-- > 0;) {
+        const uint64_t numerator = (uint64_t(u[j + n]) << 32) | u[j + n - 1];
+        uint64_t estimate = numerator / v[n - 1];
+        uint64_t rest = numerator % v[n - 1];
+        while (estimate >= g_limbBase ||
+               estimate * v[n - 2] > ((rest << 32) | u[j + n - 2])) {
+            --estimate;
+            rest += v[n - 1];
+            if (rest >= g_limbBase)
+                break;
+        }
+        int64_t borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const uint64_t product = estimate * v[i];
+            const int64_t difference = int64_t(u[i + j]) - borrow - int64_t(product & 0xFFFFFFFF);
+            u[i + j] = uint32_t(difference);
+            borrow = int64_t(product >> 32) - (difference >> 32);
+        }
+        const int64_t top = int64_t(u[j + n]) - borrow;
+        u[j + n] = uint32_t(top);
+        if (top < 0) {
+            --estimate;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                const uint64_t sum = uint64_t(u[i + j]) + v[i] + carry;
+                u[i + j] = uint32_t(sum);
+                carry = sum >> 32;
+            }
+            u[j + n] += uint32_t(carry);
+        }
+        (*quotient)[j] = uint32_t(estimate);
+    }
+    remainder->assign(n, 0);
+    for (size_t i = 0; i < n; ++i)
+        (*remainder)[i] = (u[i] >> shift) | (shift ? u[i + 1] << (32 - shift) : 0);
+}
+
+BigInt BigInt::addSigned(const BigInt& a, const BigInt& b, bool negateB)
+{
+    const bool bNegative = b.isZero() ? false : b._negative != negateB;
+    if (a._negative == bNegative)
+        return BigInt(addMagnitude(a._limbs, b._limbs), a._negative);
+    if (compareMagnitude(a._limbs, b._limbs) >= 0)
+        return BigInt(subtractMagnitude(a._limbs, b._limbs), a._negative);
+    return BigInt(subtractMagnitude(b._limbs, a._limbs), bNegative);
+}
+} // namespace core
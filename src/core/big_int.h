@@ -0,0 +1,78 @@
+#ifndef CORE_BIG_INT_H
+#define CORE_BIG_INT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core {
+// Arbitrary precision signed integer: a sign and a little-endian magnitude of 32-bit limbs
+// without leading zero limbs, so zero has no limbs and costs no allocation.
+class BigInt
+{
+public:
+    BigInt() = default;
+    BigInt(int64_t value);
+    // Digits only, no sign: "12345".
+    static BigInt fromDecimal(std::string_view digits);
+    static BigInt powerOfTen(unsigned exponent);
+
+    bool isZero() const { return _limbs.empty(); }
+    bool isNegative() const { return _negative; }
+    bool isOne() const { return !_negative && _limbs.size() == 1 && _limbs[0] == 1; }
+    bool fitsInt64() const;
+    int64_t toInt64() const;
+    // The lowest 64 bits of the magnitude.
+    uint64_t low64() const;
+    size_t bitLength() const;
+    // Number of trailing zero bits of a non-zero value.
+    size_t trailingZeroBits() const;
+    std::string toString() const;
+
+    BigInt operator-() const;
+    BigInt abs() const;
+    BigInt shiftedLeft(size_t bits) const;
+    BigInt shiftedRight(size_t bits) const;
+    // Truncating division, throws std::domain_error when divisor is zero.
+    static void divide(const BigInt& dividend, const BigInt& divisor, BigInt* quotient,
+                       BigInt* remainder);
+    // Divides in place by a small divisor and returns the remainder of the magnitude.
+    uint32_t divideBySmall(uint32_t divisor);
+    static BigInt gcd(BigInt a, BigInt b);
+
+    friend BigInt operator+(const BigInt& a, const BigInt& b);
+    friend BigInt operator-(const BigInt& a, const BigInt& b);
+    friend BigInt operator*(const BigInt& a, const BigInt& b);
+    friend BigInt operator/(const BigInt& a, const BigInt& b);
+    friend BigInt operator%(const BigInt& a, const BigInt& b);
+    friend bool operator==(const BigInt& a, const BigInt& b)
+    {
+        return a._negative == b._negative && a._limbs == b._limbs;
+    }
+    friend bool operator!=(const BigInt& a, const BigInt& b) { return !(a == b); }
+    friend bool operator<(const BigInt& a, const BigInt& b) { return compare(a, b) < 0; }
+    static int compare(const BigInt& a, const BigInt& b);
+
+private:
+    using Limbs = std::vector<uint32_t>;
+
+    BigInt(Limbs limbs, bool negative);
+    void trim();
+
+    static int compareMagnitude(const Limbs& a, const Limbs& b);
+    static Limbs addMagnitude(const Limbs& a, const Limbs& b);
+    // Requires a >= b.
+    static Limbs subtractMagnitude(const Limbs& a, const Limbs& b);
+    static Limbs multiplyMagnitude(const Limbs& a, const Limbs& b);
+    static void divideMagnitude(const Limbs& a, const Limbs& b, Limbs* quotient,
+                                Limbs* remainder);
+    static BigInt addSigned(const BigInt& a, const BigInt& b, bool negateB);
+
+    Limbs _limbs;
+    bool _negative = false;
+};
+} // namespace core
+
+#endif // CORE_BIG_INT_H
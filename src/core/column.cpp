@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include "core/column.h"
+#include "core/number_text.h"
+
+namespace {
+using core::ColumnBlock;
+using core::g_columnLanes;
+
+constexpr size_t g_checkLanes = 4;
+// Powers of ten up to 10^22 are exact doubles.
+constexpr int g_maxExactPowerOfTen = 22;
+constexpr double g_lowSignificand = 1e14;
+constexpr double g_highSignificand = 1e15;
+// Adding and subtracting 2^52 rounds a smaller magnitude to an integer, ties to even.
+constexpr double g_roundingOffset = 4503599627370496.0;
+// Veltkamp's constant for splitting a double into two halves of 26 bits.
+constexpr double g_splitFactor = 134217729.0;
+
+constexpr double powerOfTen(int exponent)
+{
+    double result = 1;
+    for (; exponent > 0; --exponent)
+        result *= 10;
+    return result;
+}
+
+struct PowersOfTen
+{
+    constexpr PowersOfTen()
+    {
+        for (int i = 0; i <= g_maxExactPowerOfTen; ++i)
+            values[i] = powerOfTen(i);
+    }
+
+    double values[g_maxExactPowerOfTen + 1] = {};
+};
+
+constexpr PowersOfTen g_powersOfTen;
+
+// The rounding error of a * b, exactly: a * b == product + error.
+double productError(double a, double b, double product)
+{
+#ifdef FP_FAST_FMA
+    return std::fma(a, b, -product);
+#else
+    // Dekker's product, exact unless contracted into fused operations, which FP_FAST_FMA covers.
+    const double splitA = g_splitFactor * a;
+    const double highA = splitA - (splitA - a);
+    const double lowA = a - highA;
+    const double splitB = g_splitFactor * b;
+    const double highB = splitB - (splitB - b);
+    const double lowB = b - highB;
+    return ((highA * highB - product) + highA * lowB + lowA * highB) + lowA * lowB;
+#endif
+}
+
+// roundToDisplayPrecision() for values from 1e-8 to 1e15, the amounts a column mostly holds, in
+// a few floating point operations: value * 10^k is rounded to an integer of 15 digits, with its
+// exact rounding error deciding the near ties, and divided by the exact 10^k again, which rounds
+// once to the nearest double. Returns false, leaving the value to the exact algorithm, whenever
+// the estimated k does not give 15 digits or lies outside of the exact powers of ten.
+bool roundToDisplayPrecisionFast(double value, double* rounded)
+{
+    const double magnitude = std::abs(value);
+    uint64_t bits;
+    std::memcpy(&bits, &magnitude, sizeof(bits));
+    // floor(log10(2^e)) is the decimal exponent or one less, a product of 16 digits tells.
+    const int binaryExponent = int(bits >> 52) - 1023;
+    int scale = core::g_displayDigits - 1 - ((binaryExponent * 78913) >> 18);
+    if (scale <= 0 || scale > g_maxExactPowerOfTen)
+        return false;
+    scale -= magnitude * g_powersOfTen.values[scale] >= g_highSignificand;
+    const double power = g_powersOfTen.values[scale];
+    const double product = magnitude * power;
+    const double error = productError(magnitude, power, product);
+    if (product < g_lowSignificand || (product == g_lowSignificand && error < 0) ||
+        product > g_highSignificand || (product == g_highSignificand && error >= 0))
+        return false;
+    double integer = (product + g_roundingOffset) - g_roundingOffset;
+    // Only a product exactly halfway between integers can be on the wrong side of the tie.
+    const double fraction = product - integer;
+    if (fraction == 0.5 && error > 0)
+        integer += 1;
+    else if (fraction == -0.5 && error < 0)
+        integer -= 1;
+    *rounded = std::copysign(integer / power, value);
+    return true;
+}
+
+// Rounds count values with the fast path and takes the exact one only for the values it leaves.
+void roundLanes(const double* values, size_t count, double* rounded)
+{
+    bool exact[g_columnLanes];
+    for (size_t lane = 0; lane < count; ++lane)
+        exact[lane] = !roundToDisplayPrecisionFast(values[lane], &rounded[lane]);
+    for (size_t lane = 0; lane < count; ++lane) {
+        if (exact[lane])
+            rounded[lane] = core::roundToDisplayPrecision(values[lane]);
+    }
+}
+
+template <typename Operation>
+void applyLanes(const ColumnBlock& left, const ColumnBlock& right, Operation operation,
+                ColumnBlock* result)
+{
+    for (size_t lane = 0; lane < g_columnLanes; ++lane)
+        result->values[lane] = operation(left.values[lane], right.values[lane]);
+}
+
+// Rows past the end of the column repeat its last row, so that the unused lanes of the last
+// block raise no exception of their own.
+void loadRows(const double* values, size_t count, ColumnBlock* block)
+{
+    std::copy(values, values + count, block->values);
+    std::fill(block->values + count, std::end(block->values), values[count - 1]);
+}
+} // namespace
+
+namespace core {
+ColumnBlock roundProduct(const ColumnBlock& block)
+{
+    ColumnBlock result;
+    roundLanes(block.values, g_columnLanes, result.values);
+    return result;
+}
+
+ColumnBlock checkedApply(const ColumnBlock& left, const ColumnBlock& right, Op op, Status* status)
+{
+    ColumnBlock result;
+    switch (op) {
+    case Op::Plus:
+        applyLanes(left, right, std::plus<double>(), &result);
+        break;
+    case Op::Minus:
+        applyLanes(left, right, std::minus<double>(), &result);
+        break;
+    case Op::Multiply:
+        applyLanes(left, right, std::multiplies<double>(), &result);
+        break;
+    case Op::Divide:
+        applyLanes(left, right, std::divides<double>(), &result);
+        break;
+    case Op::And:
+    case Op::Or:
+    case Op::Xor:
+    case Op::ShiftLeft:
+    case Op::ShiftRight:
+        std::fill(std::begin(result.values), std::end(result.values),
+                  std::numeric_limits<double>::quiet_NaN());
+        break;
+    case Op::Equal:
+    case Op::Open:
+    case Op::Close:
+        throw std::invalid_argument("Invalid arguments");
+    }
+    // x - x is 0 for finite x and NaN otherwise, summed in independent accumulators so that the
+    // check vectorizes as well.
+    double checks[g_checkLanes] = {};
+    for (size_t lane = 0; lane < g_columnLanes; lane += g_checkLanes) {
+        for (size_t check = 0; check < g_checkLanes; ++check)
+            checks[check] += result.values[lane + check] - result.values[lane + check];
+    }
+    const bool nonFinite = !isFinite((checks[0] + checks[1]) + (checks[2] + checks[3]));
+    for (size_t lane = 0; nonFinite && lane < g_columnLanes && *status == Status::Ok; ++lane)
+        checkedApply(left.values[lane], right.values[lane], op, status);
+    return result;
+}
+
+bool evaluateColumn(const Equation& equation, const std::vector<ColumnOperand>& columns,
+                    size_t first, size_t count, double* results, Status* status)
+{
+    const std::vector<Token>& tokens = equation.tokens();
+    size_t end = 0;
+    if (!equation.operandEnd(&end))
+        return false;
+    // Numbers that are the same in every row are broadcast once, columns are loaded per block.
+    std::vector<ColumnBlock> constants(end);
+    std::vector<const double*> columnValues(end, nullptr);
+    for (size_t i = 0; i < end; ++i) {
+        double value = 0;
+        if (tokens[i].isNumber && !parseNumber(tokens[i].text, &value))
+            return false;
+        std::fill(std::begin(constants[i].values), std::end(constants[i].values), value);
+    }
+    for (const ColumnOperand& column : columns) {
+        if (column.token >= end || !tokens[column.token].isNumber)
+            return false;
+        columnValues[column.token] = column.values;
+    }
+
+    *status = Status::Ok;
+    ColumnBlock rows;
+    ColumnBlock value;
+    for (size_t row = first; row < first + count; row += g_columnLanes) {
+        const size_t lanes = std::min(g_columnLanes, first + count - row);
+        GroupingEvaluator<ColumnBlock> evaluator;
+        for (size_t i = 0; i < end; ++i) {
+            if (!tokens[i].isNumber) {
+                if (!evaluator.op(tokens[i].op))
+                    return false;
+                continue;
+            }
+            if (columnValues[i])
+                loadRows(columnValues[i] + row, lanes, &rows);
+            if (!evaluator.number(columnValues[i] ? rows : constants[i]))
+                return false;
+        }
+        Status blockStatus = Status::Ok;
+        if (!evaluator.result(&value, &blockStatus))
+            return false;
+        // Like Equation, a result that rounds to infinity at 15 digits overflows as well.
+        roundLanes(value.values, lanes, results + row);
+        bool overflow = false;
+        for (size_t lane = 0; lane < lanes; ++lane)
+            overflow |= !isFinite(results[row + lane]);
+        if (*status == Status::Ok)
+            *status = blockStatus != Status::Ok ? blockStatus : overflow ? Status::Overflow
+                                                                          : Status::Ok;
+    }
+    return true;
+}
+} // namespace core
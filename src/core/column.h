@@ -0,0 +1,46 @@
+#ifndef CORE_COLUMN_H
+#define CORE_COLUMN_H
+
+#include <cstddef>
+#include <vector>
+
+#include "core/equation.h"
+
+namespace core {
+constexpr size_t g_columnLanes = 128;
+
+// g_columnLanes rows of a column as one operand. BasicEvaluator and GroupingEvaluator handle it
+// through the overloads below like any other number type, so every row follows the precedence,
+// parentheses and 15 digit rounding of × and ÷ of a single equation, while each step is a plain
+// loop over the lanes that the compiler vectorizes. ColumnBlock() is zero, blocks declared
+// without an initializer are left uninitialized.
+struct ColumnBlock
+{
+    double values[g_columnLanes];
+};
+
+// Rounds lane by lane; the rounding is not vectorized, so × and ÷ steps cost more than + and -.
+ColumnBlock roundProduct(const ColumnBlock& block);
+// Applies op to all lanes and records, unless status already holds an earlier one, what the
+// first lane with a non-finite result came from. Lanes are only examined one by one when one of
+// them is not finite.
+ColumnBlock checkedApply(const ColumnBlock& left, const ColumnBlock& right, Op op,
+                         Status* status);
+
+// A number of an equation that takes a different value in each row.
+struct ColumnOperand
+{
+    size_t token;
+    const double* values;
+};
+
+// Evaluates the equation, in double arithmetic, once for each row in [first, first + count):
+// the numbers columns lists take the value of that row, the others the same value in every row.
+// results[row] receives the result a completed equation with those numbers holds, bit for bit,
+// and status the first exception raised on the way, blocks of rows in order. Fails unless the
+// tokens before "=" form an expression. Ranges of rows can be evaluated on separate threads.
+bool evaluateColumn(const Equation& equation, const std::vector<ColumnOperand>& columns,
+                    size_t first, size_t count, double* results, Status* status);
+} // namespace core
+
+#endif // CORE_COLUMN_H
@@ -0,0 +1,751 @@
+#ifndef CORE_DECIMAL_H
+#define CORE_DECIMAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+// Exact decimal <-> binary floating point conversions usable in constexpr context. Results are
+// correctly rounded (to nearest, ties to even), so they agree bit for bit with any correct
+// runtime conversion.
+namespace core {
+namespace detail {
+constexpr int g_bigLimbs = 64;
+constexpr int g_maxParsedDigits = 100;
+constexpr int g_maxExactPowerOfTen = 22;
+constexpr uint64_t g_maxExactMantissa = uint64_t(1) << 53;
+constexpr double g_powersOfTen[g_maxExactPowerOfTen + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+constexpr uint32_t g_smallPowersOfTen[10] = {1,      10,      100,      1000,      10000,
+                                             100000, 1000000, 10000000, 100000000, 1000000000};
+
+constexpr int bitLength(uint64_t value)
+{
+    int bits = 0;
+    for (int step = 32; step > 0; step /= 2) {
+        if (value >> step) {
+            value >>= step;
+            bits += step;
+        }
+    }
+    return bits + int(value);
+}
+
+constexpr uint64_t powerOfTen(int n)
+{
+    uint64_t result = 1;
+    for (int i = 0; i < n; ++i)
+        result *= 10;
+    return result;
+}
+
+// floor(b * log10(2)) for |b| < 4000, rounded down slightly for b > 0.
+constexpr int floorLog10Pow2(int b)
+{
+    return b >= 0 ? (b * 78913) >> 18 : -((-b * 78913 + (1 << 18) - 1) >> 18);
+}
+
+struct UInt128
+{
+    constexpr bool bit(int n) const { return n < 64 ? (low >> n) & 1 : (high >> (n - 64)) & 1; }
+    constexpr bool anyBitBelow(int n) const
+    {
+        if (n <= 0)
+            return false;
+        if (n < 64)
+            return low & ((uint64_t(1) << n) - 1);
+        return low || (n > 64 && (high & ((uint64_t(1) << (n - 64)) - 1)));
+    }
+    // Saturates at 2^64 - 1.
+    constexpr uint64_t shiftedRight(int n) const
+    {
+        if (n >= 128)
+            return 0;
+        if (n >= 64)
+            return high >> (n - 64);
+        if (n > 0 && (high >> n) != 0)
+            return ~uint64_t(0);
+        return n == 0 ? (high ? ~uint64_t(0) : low) : (low >> n) | (high << (64 - n));
+    }
+
+    uint64_t high;
+    uint64_t low;
+};
+
+constexpr UInt128 multiply64(uint64_t a, uint64_t b)
+{
+    const uint64_t a0 = a & 0xffffffff;
+    const uint64_t a1 = a >> 32;
+    const uint64_t b0 = b & 0xffffffff;
+    const uint64_t b1 = b >> 32;
+    const uint64_t p00 = a0 * b0;
+    const uint64_t p01 = a0 * b1;
+    const uint64_t p10 = a1 * b0;
+    const uint64_t middle = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+    return UInt128{a1 * b1 + (p01 >> 32) + (p10 >> 32) + (middle >> 32),
+                   (middle << 32) | (p00 & 0xffffffff)};
+}
+
+// Fixed capacity unsigned integer, enough for any double times a power of ten in range.
+class BigUInt
+{
+public:
+    constexpr BigUInt() = default;
+    constexpr explicit BigUInt(uint64_t value)
+    {
+        _limbs[0] = uint32_t(value);
+        _limbs[1] = uint32_t(value >> 32);
+        _size = (value >> 32) ? 2 : (value ? 1 : 0);
+    }
+
+    constexpr bool isZero() const { return _size == 0; }
+    constexpr int bitLength() const
+    {
+        return _size == 0 ? 0 : (_size - 1) * 32 + detail::bitLength(_limbs[_size - 1]);
+    }
+
+    constexpr void multiplySmall(uint32_t factor)
+    {
+        uint64_t carry = 0;
+        for (int i = 0; i < _size; ++i) {
+            const uint64_t product = uint64_t(_limbs[i]) * factor + carry;
+            _limbs[i] = uint32_t(product);
+            carry = product >> 32;
+        }
+        if (carry && _size < g_bigLimbs)
+            _limbs[_size++] = uint32_t(carry);
+        trim();
+    }
+
+    constexpr void addSmall(uint32_t value)
+    {
+        uint64_t carry = value;
+        for (int i = 0; carry && i < _size; ++i) {
+            const uint64_t sum = uint64_t(_limbs[i]) + carry;
+            _limbs[i] = uint32_t(sum);
+            carry = sum >> 32;
+        }
+        if (carry && _size < g_bigLimbs)
+            _limbs[_size++] = uint32_t(carry);
+    }
+
+    constexpr void multiplyPowerOfTen(int n)
+    {
+        for (; n >= 9; n -= 9)
+            multiplySmall(g_smallPowersOfTen[9]);
+        if (n > 0)
+            multiplySmall(g_smallPowersOfTen[n]);
+    }
+
+    constexpr void shiftLeft(int bits)
+    {
+        if (_size == 0 || bits == 0)
+            return;
+        const int limbShift = bits / 32;
+        const int bitShift = bits % 32;
+        int newSize = _size + limbShift + 1;
+        if (newSize > g_bigLimbs)
+            newSize = g_bigLimbs;
+        for (int i = newSize - 1; i >= 0; --i) {
+            const int source = i - limbShift;
+            uint32_t limb = 0;
+            if (source >= 0 && source < _size)
+                limb = _limbs[source] << bitShift;
+            if (bitShift && source - 1 >= 0 && source - 1 < _size)
+                limb |= _limbs[source - 1] >> (32 - bitShift);
+            _limbs[i] = limb;
+        }
+        _size = newSize;
+        trim();
+    }
+
+    constexpr void shiftRightOne()
+    {
+        for (int i = 0; i < _size; ++i) {
+            _limbs[i] >>= 1;
+            if (i + 1 < _size)
+                _limbs[i] |= _limbs[i + 1] << 31;
+        }
+        trim();
+    }
+
+    constexpr int compare(const BigUInt& other) const
+    {
+        if (_size != other._size)
+            return _size < other._size ? -1 : 1;
+        for (int i = _size - 1; i >= 0; --i) {
+            if (_limbs[i] != other._limbs[i])
+                return _limbs[i] < other._limbs[i] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // Requires *this >= other.
+    constexpr void subtract(const BigUInt& other)
+    {
+        int64_t borrow = 0;
+        for (int i = 0; i < _size; ++i) {
+            int64_t difference = int64_t(_limbs[i]) - borrow;
+            if (i < other._size)
+                difference -= other._limbs[i];
+            borrow = difference < 0;
+            _limbs[i] = uint32_t(difference + (borrow << 32));
+        }
+        trim();
+    }
+
+    // The 64 bits starting at bit position, which must be below bitLength().
+    constexpr uint64_t bitsFrom(int position) const
+    {
+        uint64_t result = 0;
+        for (int bit = 63; bit >= 0; --bit)
+            result = (result << 1) | testBit(position + bit);
+        return result;
+    }
+
+    constexpr bool anyBitBelow(int position) const
+    {
+        for (int i = 0; i < _size && i * 32 < position; ++i) {
+            const int bits = position - i * 32;
+            const uint32_t mask = bits >= 32 ? ~uint32_t(0) : (uint32_t(1) << bits) - 1;
+            if (_limbs[i] & mask)
+                return true;
+        }
+        return false;
+    }
+
+    constexpr uint64_t low64() const { return uint64_t(_limbs[1]) << 32 | _limbs[0]; }
+
+private:
+    constexpr bool testBit(int bit) const
+    {
+        return bit / 32 < _size && ((_limbs[bit / 32] >> (bit % 32)) & 1);
+    }
+    constexpr void trim()
+    {
+        while (_size > 0 && _limbs[_size - 1] == 0)
+            --_size;
+    }
+
+    uint32_t _limbs[g_bigLimbs] = {};
+    int _size = 0;
+};
+
+// Divides numerator by denominator when the quotient is known to fit in quotientBits (at most
+// 64) bits. The numerator is left holding the remainder.
+constexpr uint64_t divideSmallQuotient(BigUInt& numerator, BigUInt denominator, int quotientBits)
+{
+    denominator.shiftLeft(quotientBits - 1);
+    uint64_t quotient = 0;
+    for (int bit = quotientBits - 1; bit >= 0; --bit) {
+        quotient <<= 1;
+        if (numerator.compare(denominator) >= 0) {
+            numerator.subtract(denominator);
+            quotient |= 1;
+        }
+        denominator.shiftRightOne();
+    }
+    return quotient;
+}
+
+constexpr double scaleByPowerOfTwo(double value, int exponent)
+{
+    constexpr double twoTo32 = 4294967296.0;
+    for (; exponent >= 32; exponent -= 32)
+        value *= twoTo32;
+    for (; exponent <= -32; exponent += 32)
+        value /= twoTo32;
+    for (; exponent > 0; --exponent)
+        value *= 2;
+    for (; exponent < 0; ++exponent)
+        value /= 2;
+    return value;
+}
+
+// The double nearest to (mantissa + sticky * epsilon) * 2^exponent, where sticky marks bits
+// below the mantissa that are not all zero.
+constexpr double makeDouble(uint64_t mantissa, int exponent, bool sticky)
+{
+    if (mantissa == 0)
+        return 0;
+    const int bits = bitLength(mantissa);
+    const int leading = exponent + bits - 1;
+    const int precision = leading < -1022 ? 53 - (-1022 - leading) : 53;
+    const int shift = bits - precision;
+    // With a shift of 64 only the round bit is left, against the smallest subnormal.
+    if (shift == 64) {
+        const uint64_t half = uint64_t(1) << 63;
+        return mantissa > half || (mantissa == half && sticky)
+                   ? scaleByPowerOfTwo(1, exponent + 64)
+                   : 0;
+    }
+    if (shift > 64)
+        return 0;
+    if (shift > 0) {
+        const uint64_t remainder = mantissa & ((uint64_t(1) << shift) - 1);
+        const uint64_t half = uint64_t(1) << (shift - 1);
+        mantissa >>= shift;
+        exponent += shift;
+        if (remainder > half || (remainder == half && (sticky || (mantissa & 1))))
+            ++mantissa;
+    }
+    if (exponent + bitLength(mantissa) - 1 > 1023)
+        return std::numeric_limits<double>::infinity();
+    return scaleByPowerOfTwo(double(mantissa), exponent);
+}
+
+// The double nearest to (mantissa + sticky * epsilon) * 10^exponent.
+constexpr double composeDouble(BigUInt mantissa, int exponent, bool sticky)
+{
+    if (mantissa.isZero())
+        return 0;
+    const int bits = mantissa.bitLength();
+    if (floorLog10Pow2(bits - 1) + exponent >= 309)
+        return std::numeric_limits<double>::infinity();
+    if (floorLog10Pow2(bits) + 1 + exponent <= -325)
+        return 0;
+    if (exponent >= 0) {
+        mantissa.multiplyPowerOfTen(exponent);
+        const int scaledBits = mantissa.bitLength();
+        if (scaledBits <= 64)
+            return makeDouble(mantissa.low64(), 0, sticky);
+        const int shift = scaledBits - 64;
+        return makeDouble(mantissa.bitsFrom(shift), shift,
+                          sticky || mantissa.anyBitBelow(shift));
+    }
+    BigUInt denominator(1);
+    denominator.multiplyPowerOfTen(-exponent);
+    // Scale so that the quotient has 63 or 64 significant bits.
+    const int scale = denominator.bitLength() - bits + 63;
+    if (scale >= 0)
+        mantissa.shiftLeft(scale);
+    else
+        denominator.shiftLeft(-scale);
+    const uint64_t quotient = divideSmallQuotient(mantissa, denominator, 64);
+    return makeDouble(quotient, -scale, sticky || !mantissa.isZero());
+}
+
+// 5^q ~ (high * 2^64 + low) * 2^exponent with the top bit of high set.
+struct PowerOfFive
+{
+    uint64_t high;
+    uint64_t low;
+    int exponent;
+};
+
+constexpr int g_minFastPowerOfTen = -342;
+constexpr int g_maxFastPowerOfTen = 308;
+
+struct PowersOfFive
+{
+    PowerOfFive entries[g_maxFastPowerOfTen - g_minFastPowerOfTen + 1];
+};
+
+// Steps from 5^0 by multiplying or dividing by 5 and truncating to 128 bits. Each step loses
+// at most one unit in the last place, so every entry is within 2^-118 of 5^q.
+constexpr PowersOfFive makePowersOfFive()
+{
+    PowersOfFive table{};
+    const int zero = -g_minFastPowerOfTen;
+    const PowerOfFive one{uint64_t(1) << 63, 0, -127};
+    table.entries[zero] = one;
+    PowerOfFive power = one;
+    for (int q = 1; q <= g_maxFastPowerOfTen; ++q) {
+        const UInt128 upper = multiply64(power.high, 5);
+        const UInt128 lower = multiply64(power.low, 5);
+        const uint64_t middle = upper.low + lower.high;
+        const uint64_t top = upper.high + (middle < upper.low);
+        const int shift = bitLength(top);
+        power.high = (top << (64 - shift)) | (middle >> shift);
+        power.low = (middle << (64 - shift)) | (lower.low >> shift);
+        power.exponent += shift;
+        table.entries[zero + q] = power;
+    }
+    power = one;
+    for (int q = -1; q >= g_minFastPowerOfTen; --q) {
+        const uint64_t limbs[4] = {power.high >> 32, power.high & 0xffffffff, power.low >> 32,
+                                   power.low & 0xffffffff};
+        uint64_t quotient[4] = {};
+        uint64_t remainder = 0;
+        for (int i = 0; i < 4; ++i) {
+            const uint64_t current = (remainder << 32) | limbs[i];
+            quotient[i] = current / 5;
+            remainder = current % 5;
+        }
+        const uint64_t high = (quotient[0] << 32) | quotient[1];
+        const uint64_t low = (quotient[2] << 32) | quotient[3];
+        // The quotient has 125 or 126 bits, the division continues into the freed low bits.
+        const int shift = 64 - bitLength(high);
+        power.high = (high << shift) | (low >> (64 - shift));
+        power.low = (low << shift) | ((remainder << shift) / 5);
+        power.exponent -= shift;
+        table.entries[q - g_minFastPowerOfTen] = power;
+    }
+    return table;
+}
+
+constexpr PowersOfFive g_powersOfFive = makePowersOfFive();
+
+// The Eisel-Lemire approach: mantissa * 10^exponent from one 64 x 128-bit product with the
+// table above. Fails, leaving the exact path to decide, when the product is too close to a
+// rounding boundary for the table error or the result is not a normal double.
+constexpr bool composeDoubleFast(uint64_t mantissa, int exponent, double* value)
+{
+    constexpr uint64_t slack = uint64_t(1) << 12;
+    if (mantissa == 0 || exponent < g_minFastPowerOfTen || exponent > g_maxFastPowerOfTen)
+        return false;
+    const PowerOfFive& power = g_powersOfFive.entries[exponent - g_minFastPowerOfTen];
+    const int leadingZeros = 64 - bitLength(mantissa);
+    const uint64_t normalized = mantissa << leadingZeros;
+    const UInt128 upper = multiply64(normalized, power.high);
+    const UInt128 lower = multiply64(normalized, power.low);
+    uint64_t low = upper.low + lower.high;
+    uint64_t high = upper.high + (low < upper.low);
+    // mantissa * 10^exponent ~ (high * 2^64 + low) * 2^binaryExponent.
+    int binaryExponent = 64 + power.exponent + exponent - leadingZeros;
+    if (!(high >> 63)) {
+        high = (high << 1) | (low >> 63);
+        low <<= 1;
+        --binaryExponent;
+    }
+    // Bits below the 53 kept ones: the round bit is 0x400, halfway is 0x400 followed by zeros.
+    const uint64_t rest = high & 0x7ff;
+    if ((rest == 0x400 && low <= slack) || (rest == 0x3ff && low >= ~uint64_t(0) - slack))
+        return false;
+    uint64_t result = (high >> 11) + ((rest & 0x400) ? 1 : 0);
+    binaryExponent += 64 + 11;
+    if (result == g_maxExactMantissa) {
+        result >>= 1;
+        ++binaryExponent;
+    }
+    const int biased = binaryExponent + 52 + 1023;
+    if (biased < 1 || biased > 2046)
+        return false;
+    *value = scaleByPowerOfTwo(double(result), binaryExponent);
+    return true;
+}
+
+constexpr double composeDouble(uint64_t mantissa, int exponent)
+{
+    // Clinger's fast path: both factors are exact doubles, so one rounding gives the result.
+    if (mantissa <= g_maxExactMantissa && exponent >= -g_maxExactPowerOfTen &&
+        exponent <= g_maxExactPowerOfTen) {
+        return exponent < 0 ? double(mantissa) / g_powersOfTen[-exponent]
+                            : double(mantissa) * g_powersOfTen[exponent];
+    }
+    double value = 0;
+    if (composeDoubleFast(mantissa, exponent, &value))
+        return value;
+    return composeDouble(BigUInt(mantissa), exponent, false);
+}
+
+// Splits a positive finite value into mantissa * 2^exponent with the mantissa in
+// [2^52, 2^53), exactly.
+constexpr uint64_t decompose(double value, int* exponent)
+{
+    constexpr double twoTo32 = 4294967296.0;
+    constexpr double twoTo52 = 4503599627370496.0;
+    constexpr double twoTo53 = 9007199254740992.0;
+    int e = 0;
+    while (value >= twoTo53 * twoTo32) {
+        value /= twoTo32;
+        e += 32;
+    }
+    while (value >= twoTo53) {
+        value /= 2;
+        ++e;
+    }
+    while (value < twoTo52 / twoTo32) {
+        value *= twoTo32;
+        e -= 32;
+    }
+    while (value < twoTo52) {
+        value *= 2;
+        --e;
+    }
+    *exponent = e;
+    return uint64_t(value);
+}
+
+// scaleToInteger() from one 64 x 128-bit product with the table of powers of five. The table
+// entries are truncated, so the product may fall short of the exact value by a few units of
+// 2^-64; fails when that could move the remainder across zero or half the divisor.
+constexpr bool scaleToIntegerFast(uint64_t mantissa, int binaryExponent, int decimalExponent,
+                                  int* half, uint64_t* scaled)
+{
+    constexpr uint64_t saturated = uint64_t(1) << 60;
+    constexpr uint64_t slack = uint64_t(1) << 16;
+    constexpr uint64_t halfway = uint64_t(1) << 63;
+    if (-decimalExponent < g_minFastPowerOfTen || -decimalExponent > g_maxFastPowerOfTen)
+        return false;
+    const PowerOfFive& power = g_powersOfFive.entries[-decimalExponent - g_minFastPowerOfTen];
+    const UInt128 upper = multiply64(mantissa, power.high);
+    const UInt128 lower = multiply64(mantissa, power.low);
+    // The quotient is the product (top, middle, bottom) shifted right by shift bits, and
+    // fraction the 64 bits below it.
+    const uint64_t bottom = lower.low;
+    const uint64_t middle = upper.low + lower.high;
+    const uint64_t top = upper.high + (middle < upper.low);
+    const int shift = decimalExponent - power.exponent - binaryExponent;
+    uint64_t quotient = 0;
+    uint64_t fraction = 0;
+    if (shift <= 120) {
+        // At least 2^59, above every significand.
+        *half = -1;
+        *scaled = saturated;
+        return true;
+    } else if (shift < 128) {
+        quotient = (top << (128 - shift)) | (middle >> (shift - 64));
+        fraction = (middle << (128 - shift)) | (bottom >> (shift - 64));
+    } else if (shift == 128) {
+        quotient = top;
+        fraction = middle;
+    } else if (shift < 192) {
+        quotient = top >> (shift - 128);
+        fraction = (top << (192 - shift)) | (middle >> (shift - 128));
+    } else {
+        *half = -1;
+        *scaled = 0;
+        return true;
+    }
+    if (fraction >= ~uint64_t(0) - slack ||
+        (fraction >= halfway - slack && fraction <= halfway + slack))
+        return false;
+    *half = fraction > halfway ? 1 : -1;
+    *scaled = quotient;
+    return true;
+}
+
+// floor(mantissa * 2^binaryExponent / 10^decimalExponent) and how the remainder compares to
+// half of the divisor: -1 below, 0 equal, 1 above.
+constexpr uint64_t scaleToInteger(uint64_t mantissa, int binaryExponent, int decimalExponent,
+                                  int* half)
+{
+    constexpr uint64_t saturated = uint64_t(1) << 60;
+    // Values from about 1e-12 to 1e15 scale by 10^s = 5^s * 2^s with 5^s below 2^63, so the
+    // product fits in 128 bits.
+    if (decimalExponent <= 0 && decimalExponent >= -27) {
+        uint64_t powerOfFive = 1;
+        for (int i = 0; i < -decimalExponent; ++i)
+            powerOfFive *= 5;
+        const UInt128 product = multiply64(mantissa, powerOfFive);
+        const int shift = binaryExponent - decimalExponent;
+        if (shift >= 0) {
+            *half = -1;
+            if (shift >= 64 || product.high || (shift > 0 && (product.low >> (64 - shift))))
+                return saturated;
+            const uint64_t quotient = product.low << shift;
+            return quotient < saturated ? quotient : saturated;
+        }
+        const uint64_t quotient = product.shiftedRight(-shift);
+        if (quotient >= saturated) {
+            *half = 0;
+            return saturated;
+        }
+        const int halfBit = -shift - 1;
+        *half = halfBit >= 128 || !product.bit(halfBit) ? -1
+                : product.anyBitBelow(halfBit)          ? 1
+                                                        : 0;
+        return quotient;
+    }
+
+    uint64_t scaled = 0;
+    if (scaleToIntegerFast(mantissa, binaryExponent, decimalExponent, half, &scaled))
+        return scaled;
+
+    BigUInt numerator(mantissa);
+    BigUInt denominator(1);
+    if (binaryExponent > 0)
+        numerator.shiftLeft(binaryExponent);
+    else
+        denominator.shiftLeft(-binaryExponent);
+    if (decimalExponent > 0)
+        denominator.multiplyPowerOfTen(decimalExponent);
+    else
+        numerator.multiplyPowerOfTen(-decimalExponent);
+    // Callers only keep quotients below 10^17, anything at or above 2^60 is reported as such.
+    BigUInt limit = denominator;
+    limit.shiftLeft(60);
+    if (numerator.compare(limit) >= 0) {
+        *half = 0;
+        return saturated;
+    }
+    const uint64_t quotient = divideSmallQuotient(numerator, denominator, 60);
+    numerator.shiftLeft(1);
+    *half = numerator.compare(denominator);
+    return quotient;
+}
+
+// The first digits (at most 17) significant decimal digits of a positive finite value, truncated,
+// as significand * 10^decimalExponent with the significand in [10^(digits - 1), 10^digits), and
+// how the rest compares to half a unit of the last digit: -1 below, 0 equal, 1 above.
+constexpr uint64_t truncatedDigits(double value, int digits, int* decimalExponent, int* half)
+{
+    int binaryExponent = 0;
+    const uint64_t mantissa = decompose(value, &binaryExponent);
+    const uint64_t low = powerOfTen(digits - 1);
+    const uint64_t high = powerOfTen(digits);
+    int exponent = floorLog10Pow2(binaryExponent + 52) - (digits - 1);
+    uint64_t scaled = 0;
+    for (;;) {
+        scaled = scaleToInteger(mantissa, binaryExponent, exponent, half);
+        if (scaled >= high)
+            ++exponent;
+        else if (scaled < low)
+            --exponent;
+        else
+            break;
+    }
+    *decimalExponent = exponent;
+    return scaled;
+}
+
+// A positive finite value rounded to digits (at most 17) significant decimal digits, as
+// significand * 10^decimalExponent with the significand in [10^(digits - 1), 10^digits): the
+// digits printf("%.*e", digits - 1, value) prints.
+constexpr uint64_t significantDigits(double value, int digits, int* decimalExponent)
+{
+    int half = 0;
+    int exponent = 0;
+    uint64_t scaled = truncatedDigits(value, digits, &exponent, &half);
+    if (half > 0 || (half == 0 && (scaled & 1)))
+        ++scaled;
+    if (scaled == powerOfTen(digits)) {
+        scaled = powerOfTen(digits - 1);
+        ++exponent;
+    }
+    *decimalExponent = exponent;
+    return scaled;
+}
+
+// The double nearest to value rounded to digits (at most 17) significant decimal digits, the
+// value printf("%.*g", digits, value) would read back as.
+constexpr double roundToSignificantDigits(double value, int digits)
+{
+    if (value != value || value == 0 || value == std::numeric_limits<double>::infinity() ||
+        value == -std::numeric_limits<double>::infinity())
+        return value;
+    const bool negative = value < 0;
+    int decimalExponent = 0;
+    const uint64_t scaled = significantDigits(negative ? -value : value, digits, &decimalExponent);
+    const double rounded = composeDouble(scaled, decimalExponent);
+    return negative ? -rounded : rounded;
+}
+
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+constexpr bool equalsIgnoringCase(std::string_view text, std::string_view word)
+{
+    if (text.size() != word.size())
+        return false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if ((text[i] | 0x20) != word[i])
+            return false;
+    }
+    return true;
+}
+
+// Collects the significant digits of a decimal number: up to 19 in a machine word, then up to
+// g_maxParsedDigits exactly and the rest as a sticky flag.
+struct DigitCollector
+{
+    constexpr void add(int digit, bool fraction)
+    {
+        if (count == 0 && digit == 0) {
+            exponent -= fraction;
+            return;
+        }
+        if (count < 19) {
+            mantissa = mantissa * 10 + uint64_t(digit);
+        } else if (count < g_maxParsedDigits) {
+            if (count == 19)
+                big = BigUInt(mantissa);
+            big.multiplySmall(10);
+            big.addSmall(uint32_t(digit));
+        } else {
+            truncated |= digit != 0;
+            exponent += !fraction;
+            return;
+        }
+        ++count;
+        exponent -= fraction;
+    }
+
+    constexpr double value() const
+    {
+        return count <= 19 ? composeDouble(mantissa, exponent)
+                           : composeDouble(big, exponent, truncated);
+    }
+
+    uint64_t mantissa = 0;
+    BigUInt big;
+    int count = 0;
+    int exponent = 0;
+    bool truncated = false;
+};
+} // namespace detail
+
+// Accepts an optional sign, digits with an optional '.', an optional exponent, "inf" and "nan".
+// An incomplete number such as "0." is accepted, a lone sign, a second '.' or a value that
+// overflows is not.
+constexpr bool parseDecimal(std::string_view text, double* value)
+{
+    size_t i = 0;
+    bool negative = false;
+    if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+        negative = text[i] == '-';
+        ++i;
+    }
+    if (detail::equalsIgnoringCase(text.substr(i), "inf")) {
+        *value = negative ? -std::numeric_limits<double>::infinity()
+                          : std::numeric_limits<double>::infinity();
+        return true;
+    }
+    if (detail::equalsIgnoringCase(text.substr(i), "nan")) {
+        *value = std::numeric_limits<double>::quiet_NaN();
+        return true;
+    }
+
+    detail::DigitCollector digits;
+    bool anyDigit = false;
+    for (; i < text.size() && detail::isDigit(text[i]); ++i) {
+        digits.add(text[i] - '0', false);
+        anyDigit = true;
+    }
+    if (i < text.size() && text[i] == '.') {
+        for (++i; i < text.size() && detail::isDigit(text[i]); ++i) {
+            digits.add(text[i] - '0', true);
+            anyDigit = true;
+        }
+    }
+    if (!anyDigit)
+        return false;
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        ++i;
+        bool negativeExponent = false;
+        if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+            negativeExponent = text[i] == '-';
+            ++i;
+        }
+        if (i == text.size() || !detail::isDigit(text[i]))
+            return false;
+        int written = 0;
+        for (; i < text.size() && detail::isDigit(text[i]); ++i) {
+            if (written < 100000)
+                written = written * 10 + (text[i] - '0');
+        }
+        digits.exponent += negativeExponent ? -written : written;
+    }
+    if (i != text.size())
+        return false;
+    const double magnitude = digits.value();
+    if (magnitude == std::numeric_limits<double>::infinity())
+        return false;
+    *value = negative ? -magnitude : magnitude;
+    return true;
+}
+} // namespace core
+
+#endif // CORE_DECIMAL_H
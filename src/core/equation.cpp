@@ -0,0 +1,423 @@
+#include <stdexcept>
+
+#include "core/equation.h"
+#include "core/number_text.h"
+
+namespace {
+constexpr size_t g_minimumTokenCountToCalc = 3;
+
+// Folds the tokens[0, end) into result in one pass, parse(text, &value) converts a number.
+// Fails unless the tokens form an expression.
+template <typename T, typename Parse>
+bool evaluateTokens(const std::vector<core::Token>& tokens, size_t end, Parse parse, T* result,
+                    core::Status* status)
+{
+    core::GroupingEvaluator<T> evaluator;
+    T value;
+    for (size_t i = 0; i < end; ++i) {
+        const core::Token& token = tokens[i];
+        if (token.isNumber ? !parse(token.text, &value) || !evaluator.number(value)
+                           : !evaluator.op(token.op))
+            return false;
+    }
+    return evaluator.result(result, status);
+}
+
+bool parseDouble(std::string_view text, double* value) { return core::parseNumber(text, value); }
+
+std::string appliedUnary(const std::string& text, core::Unary unary, core::Arithmetic arithmetic)
+{
+    if (unary == core::Unary::ToggleSign)
+        return !text.empty() && text[0] == '-' ? text.substr(1) : '-' + text;
+    // A percentage is rarely an integer, programmer mode leaves the number as it is.
+    if (arithmetic == core::Arithmetic::Integer)
+        return text;
+    core::Rational exact;
+    if (arithmetic == core::Arithmetic::Exact && core::Rational::parse(text, &exact))
+        return (exact / 100).toText();
+    double value;
+    if (!core::parseNumber(text, &value))
+        return text;
+    return core::formatNumber(value / 100);
+}
+} // namespace
+
+namespace core {
+bool Equation::parse(std::string_view text, Equation* equation, Arithmetic arithmetic, Base base)
+{
+    struct TokenSink
+    {
+        void number(std::string_view text, double)
+        {
+            if (!numbered && hasBasePrefix(text))
+                parsed._base = integerBase(text);
+            numbered = true;
+            parsed._tokens.push_back(Token::fromNumber(std::string(text)));
+        }
+        void op(Op op)
+        {
+            valid &= parsed._arithmetic == Arithmetic::Integer || !isBitwise(op);
+            parsed.pushOp(op);
+        }
+
+        Equation parsed;
+        // Open parentheses may come before the first number, whose base the line takes.
+        bool numbered = false;
+        bool valid = true;
+    };
+    const bool integer = arithmetic == Arithmetic::Integer;
+    TokenSink sink{Equation(arithmetic, base)};
+    if (!scanExpression(text, sink, integer) || !sink.valid)
+        return false;
+    sink.parsed.append(Op::Equal);
+    if (!sink.parsed.completed())
+        return false;
+    *equation = std::move(sink.parsed);
+    return true;
+}
+
+Equation Equation::continuing(const Equation& completed, size_t sourceId)
+{
+    Equation equation(completed._arithmetic, completed._base);
+    equation._tokens.push_back(Token::fromNumber(completed.back().text));
+    equation._source = sourceId;
+    equation._sourceStatus = completed._status;
+    return equation;
+}
+
+double Equation::calculate() const
+{
+    Evaluation evaluation;
+    if (!tryCalculate(&evaluation))
+        throw std::invalid_argument("Invalid");
+    return evaluation.value;
+}
+
+bool Equation::tryCalculate(Evaluation* evaluation) const { return evaluate(evaluation, nullptr); }
+
+bool Equation::calculateExact(Rational* value) const
+{
+    size_t end = 0;
+    if (!operandEnd(&end))
+        return false;
+    bool representable = true;
+    // Numbers such as "inf" have no exact value, the evaluation goes on with zero in their place
+    // and its result is dropped.
+    const auto parse = [&representable](std::string_view text, Rational* number) {
+        if (!Rational::parse(text, number)) {
+            representable = false;
+            *number = Rational();
+        }
+        return true;
+    };
+    Status status = Status::Ok;
+    return evaluateTokens<Rational>(_tokens, end, parse, value, &status) &&
+           status == Status::Ok && representable;
+}
+
+double Equation::result() const
+{
+    double value;
+    if (!completed() || !parseNumber(_tokens.back().text, &value))
+        throw std::invalid_argument("Invalid");
+    return value;
+}
+
+std::string Equation::text() const
+{
+    std::string result;
+    for (const Token& token : _tokens)
+        result += token.isNumber ? token.text : std::string(symbol(token.op));
+    return result;
+}
+
+void Equation::append(uint8_t digit)
+{
+    if (completed())
+        return;
+    if (!empty() && !back().isNumber && back().op == Op::Close)
+        return;
+    const bool startsNumber = empty() || !back().isNumber;
+    const Base numberBase = startsNumber || _arithmetic != Arithmetic::Integer
+                                ? base()
+                                : integerBase(back().text);
+    if (digit >= uint8_t(numberBase))
+        return;
+    const char c = digitCharacter(digit);
+    // Digits cannot extend a result such as "inf" into text that is no longer a number.
+    if (startsNumber) {
+        markChanged(size());
+        _tokens.push_back(Token::fromNumber(std::string(basePrefix(numberBase)) + c));
+    } else {
+        trySetLastNumber(back().text + c);
+    }
+}
+
+void Equation::append(Op op)
+{
+    if (completed())
+        return;
+    const bool afterOperand = !empty() && (back().isNumber || back().op == Op::Close);
+    if (op == Op::Open) {
+        if (!afterOperand)
+            pushOp(op);
+        return;
+    }
+    if (!afterOperand || (op == Op::Close && _openParentheses.empty()) ||
+        (isBitwise(op) && _arithmetic != Arithmetic::Integer))
+        return;
+    const size_t sizeBefore = size();
+    if (op == Op::Equal) {
+        if (size() < g_minimumTokenCountToCalc)
+            return;
+        while (!_openParentheses.empty())
+            pushOp(Op::Close);
+    }
+    pushOp(op);
+    if (op == Op::Equal) {
+        Evaluation evaluation;
+        std::string result;
+        if (!evaluate(&evaluation, &result)) {
+            // The parentheses closed for the evaluation are open again.
+            while (size() > sizeBefore)
+                popOp();
+            return;
+        }
+        markChanged(size());
+        _tokens.push_back(Token::fromNumber(std::move(result)));
+        _status = evaluation.status;
+        _completed = true;
+    }
+}
+
+void Equation::appendDecimal()
+{
+    if (completed() || _arithmetic == Arithmetic::Integer ||
+        (!empty() && !back().isNumber && back().op == Op::Close))
+        return;
+    if (empty() || !back().isNumber) {
+        markChanged(size());
+        _tokens.push_back(Token::fromNumber("0."));
+        return;
+    }
+    trySetLastNumber(back().text + '.');
+}
+
+bool Equation::appendNumber(const std::string& text)
+{
+    double value;
+    if (completed() || (!empty() && (back().isNumber || back().op == Op::Close)) ||
+        !parseNumber(text, &value))
+        return false;
+    markChanged(size());
+    _tokens.push_back(Token::fromNumber(text));
+    return true;
+}
+
+bool Equation::tryPopCharacter()
+{
+    if (empty())
+        return true;
+    if (size() == 1)
+        detachFromSource();
+    if (!back().isNumber) {
+        popOp();
+        return true;
+    }
+    std::string numberText = back().text;
+    if (numberText.empty()) {
+        markChanged(size() - 1);
+        _tokens.pop_back();
+        return tryPopCharacter();
+    }
+    numberText.pop_back();
+    if (!trySetLastNumber(numberText)) {
+        markChanged(size() - 1);
+        _tokens.pop_back();
+    }
+    return true;
+}
+
+bool Equation::trySetLastNumber(const std::string& text)
+{
+    if (empty() || !setNumberText(size() - 1, text))
+        return false;
+    if (size() == 1)
+        detachFromSource();
+    return true;
+}
+
+void Equation::apply(Unary unary)
+{
+    if (empty() || completed() || !back().isNumber)
+        return;
+    if (setNumberText(size() - 1, appliedUnary(back().text, unary, _arithmetic)) && size() == 1 &&
+        _source != g_noSource)
+        _sourceUnaries.push_back(unary);
+}
+
+void Equation::clear()
+{
+    markChanged(0);
+    _tokens.clear();
+    _openParentheses.clear();
+    _completed = false;
+    _status = Status::Ok;
+    detachFromSource();
+}
+
+bool Equation::setNumber(size_t tokenIndex, const std::string& text)
+{
+    const size_t end = completed() ? size() - 2 : size();
+    if (tokenIndex >= end || !setNumberText(tokenIndex, text))
+        return false;
+    if (tokenIndex == 0)
+        detachFromSource();
+    recalculate();
+    return true;
+}
+
+bool Equation::recalculate()
+{
+    Evaluation evaluation;
+    std::string result;
+    if (!completed() || !evaluate(&evaluation, &result))
+        return false;
+    const bool statusChanged = evaluation.status != _status;
+    _status = evaluation.status;
+    if (result == _tokens.back().text) {
+        if (statusChanged)
+            markChanged(size() - 1);
+        return statusChanged;
+    }
+    markChanged(size() - 1);
+    _tokens.back().text = std::move(result);
+    return true;
+}
+
+bool Equation::refreshFromSource(const Equation& source)
+{
+    if (_source == g_noSource || empty() || !source.completed())
+        return false;
+    std::string text = source.back().text;
+    for (const Unary unary : _sourceUnaries)
+        text = appliedUnary(text, unary, _arithmetic);
+    const bool statusChanged = source._status != _sourceStatus;
+    _sourceStatus = source._status;
+    if (text == _tokens[0].text || !setNumberText(0, text))
+        return statusChanged && recalculate();
+    recalculate();
+    return true;
+}
+
+void Equation::pushOp(Op op)
+{
+    Token token = Token::fromOp(op);
+    if (op == Op::Open) {
+        token.depth = uint32_t(_openParentheses.size());
+        _openParentheses.push_back(size());
+    } else if (op == Op::Close) {
+        const size_t open = _openParentheses.back();
+        _openParentheses.pop_back();
+        token.depth = _tokens[open].depth;
+        token.partner = open;
+        _tokens[open].partner = size();
+        markChanged(open);
+    }
+    markChanged(size());
+    _tokens.push_back(std::move(token));
+}
+
+void Equation::popOp()
+{
+    const Token& token = _tokens.back();
+    if (token.op == Op::Open) {
+        _openParentheses.pop_back();
+    } else if (token.op == Op::Close) {
+        _tokens[token.partner].partner = g_noPartner;
+        _openParentheses.push_back(token.partner);
+        markChanged(token.partner);
+    }
+    markChanged(size() - 1);
+    _tokens.pop_back();
+}
+
+bool Equation::operandEnd(size_t* end) const
+{
+    *end = _tokens.size();
+    if (_completed)
+        *end -= 2;
+    else if (*end > 0 && !_tokens.back().isNumber && _tokens.back().op == Op::Equal)
+        *end -= 1;
+    return *end >= g_minimumTokenCountToCalc;
+}
+
+bool Equation::evaluate(Evaluation* evaluation, std::string* text) const
+{
+    if (_arithmetic == Arithmetic::Integer)
+        return evaluateInteger(evaluation, text);
+    size_t end = 0;
+    Rational exact;
+    const bool isExact = _arithmetic == Arithmetic::Exact && calculateExact(&exact);
+    Evaluation result;
+    if (isExact) {
+        result.value = exact.toDouble();
+    } else if (!operandEnd(&end) ||
+               !evaluateTokens<double>(_tokens, end, parseDouble, &result.value, &result.status)) {
+        *evaluation = Evaluation{0, Status::Invalid};
+        return false;
+    }
+    // The result is shown with 15 digits, which can round up to infinity as well.
+    const double shown = roundToDisplayPrecision(result.value);
+    const bool finite = isFinite(shown);
+    if (!finite) {
+        if (_sourceStatus != Status::Ok)
+            result.status = _sourceStatus;
+        else if (result.status == Status::Ok)
+            result.status = Status::Overflow;
+    }
+    if (text)
+        *text = !finite ? formatNumber(shown) : isExact ? exact.toText() : formatNumber(result.value);
+    *evaluation = result;
+    return true;
+}
+
+// Numbers that are not integers, such as "1.5" typed before switching to programmer mode, leave
+// the line invalid. A result that overflows is kept wrapped around, so a line continuing from it
+// keeps its status.
+bool Equation::evaluateInteger(Evaluation* evaluation, std::string* text) const
+{
+    size_t end = 0;
+    int64_t value = 0;
+    Evaluation result;
+    if (!operandEnd(&end) ||
+        !evaluateTokens<int64_t>(_tokens, end, parseInteger, &value, &result.status)) {
+        *evaluation = Evaluation{0, Status::Invalid};
+        return false;
+    }
+    if (result.status == Status::Ok)
+        result.status = _sourceStatus;
+    result.value = double(value);
+    if (text)
+        *text = formatInteger(value, _base);
+    *evaluation = result;
+    return true;
+}
+
+bool Equation::setNumberText(size_t tokenIndex, const std::string& text)
+{
+    double value;
+    if (tokenIndex >= size() || !_tokens[tokenIndex].isNumber || !parseNumber(text, &value))
+        return false;
+    _tokens[tokenIndex].text = text;
+    markChanged(tokenIndex);
+    return true;
+}
+
+void Equation::detachFromSource()
+{
+    _source = g_noSource;
+    _sourceStatus = Status::Ok;
+    _sourceUnaries.clear();
+}
+} // namespace core
@@ -0,0 +1,158 @@
+#ifndef CORE_EQUATION_H
+#define CORE_EQUATION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/evaluation.h"
+#include "core/rational.h"
+
+namespace core {
+// Unary keys applied to the number being typed.
+enum class Unary : uint8_t { ToggleSign, Percent };
+
+// Double rounds every × and ÷ step to the 15 digits a line shows. Exact evaluates a line as a
+// fraction and shows the result in full whenever its decimal expansion terminates. Integer is
+// programmer mode: int64 arithmetic with the bitwise operators and shifts, see checkedApply()
+// in core/integer.h, with numbers typed and results written in the base of the line.
+enum class Arithmetic : uint8_t { Double, Exact, Integer };
+
+constexpr size_t g_noSource = ~size_t(0);
+constexpr size_t g_noPartner = ~size_t(0);
+constexpr size_t g_noChange = ~size_t(0);
+
+struct Token
+{
+    static Token fromNumber(std::string text) { return Token{true, Op::Plus, std::move(text)}; }
+    static Token fromOp(Op op) { return Token{false, op, std::string()}; }
+
+    bool isNumber;
+    Op op;
+    // Number text as typed, e.g. "0." or "-12"; empty for operators.
+    std::string text;
+    // For parentheses: the nesting depth, counted from 0, and the index of the matching one, or
+    // g_noPartner while an open parenthesis is not closed yet.
+    uint32_t depth = 0;
+    size_t partner = g_noPartner;
+};
+
+// An equation as a list of tokens, parentheses included. A completed equation ends with "=" and
+// its result. Parentheses are paired as they are appended and removed, so the pairs are known
+// at any time without scanning the line.
+class Equation
+{
+public:
+    Equation() = default;
+    explicit Equation(Arithmetic arithmetic, Base base = Base::Decimal)
+        : _arithmetic(arithmetic), _base(base)
+    {
+    }
+    // Parses and evaluates an expression, see scanExpression(): "1+2×3", "(1 + 2) * 3 =" or a
+    // copied history line such as "1+2×3=7", whose result is recomputed. Integer arithmetic
+    // also reads prefixed integers, "0xFF & 0x0F", and writes the result in the base of the
+    // first number, or in base when that one has no prefix.
+    static bool parse(std::string_view text, Equation* equation,
+                      Arithmetic arithmetic = Arithmetic::Double, Base base = Base::Decimal);
+    // Starts a new equation with the result of a completed one, whose identifier becomes the
+    // source of the new equation.
+    static Equation continuing(const Equation& completed, size_t sourceId = g_noSource);
+
+    // Throws std::invalid_argument unless the tokens before "=" form an expression.
+    double calculate() const;
+    // Never throws: returns false, with Status::Invalid, unless the tokens before "=" form an
+    // expression. A result that is not finite because the first number is the result of such a
+    // line keeps the status of that line.
+    bool tryCalculate(Evaluation* evaluation) const;
+    // Like calculate(), but returns false when a number has no exact value, such as "inf", or
+    // the line divides by zero.
+    bool calculateExact(Rational* value) const;
+    // Throws std::invalid_argument unless completed.
+    double result() const;
+    std::string text() const;
+    bool completed() const { return _completed; }
+    // How the result of a completed equation came about, Status::Ok before it is completed.
+    Status status() const { return _status; }
+    bool empty() const { return _tokens.empty(); }
+    size_t size() const { return _tokens.size(); }
+    const std::vector<Token>& tokens() const { return _tokens; }
+    const Token& back() const { return _tokens.back(); }
+    // Lowest index of a token added, removed or changed since the last clearChanges(), size()
+    // when there is none. A parenthesis whose partner changes counts as changed, and so does the
+    // result when the status changes.
+    size_t firstChangedToken() const { return std::min(_firstChangedToken, size()); }
+    void clearChanges() { _firstChangedToken = g_noChange; }
+    // Number of open parentheses not closed yet; "=" closes them.
+    size_t unclosedParentheses() const { return _openParentheses.size(); }
+    Arithmetic arithmetic() const { return _arithmetic; }
+    // Applies to results calculated from now on.
+    void setArithmetic(Arithmetic arithmetic) { _arithmetic = arithmetic; }
+    // The base of numbers typed from now on and of results calculated from now on; only
+    // Integer arithmetic has bases other than decimal.
+    Base base() const { return _arithmetic == Arithmetic::Integer ? _base : Base::Decimal; }
+    void setBase(Base base) { _base = base; }
+    // Identifier of the equation whose result the first number still is, possibly with sign and
+    // percent applied, or g_noSource once that number has been typed over.
+    size_t source() const { return _source; }
+
+    // Appends a digit below the base of the number it extends, or of the line for a new number,
+    // which starts with the base prefix; others are ignored.
+    void append(uint8_t digit);
+    // Open is accepted where a number may start, any other operator after a number or a close
+    // parenthesis; the bitwise operators only in Integer arithmetic. Appending Equal closes the
+    // open parentheses, calculates the equation and completes it.
+    void append(Op op);
+    void appendDecimal();
+    // Appends a whole number, such as a pasted one, where a number may start; returns false and
+    // appends nothing for invalid text or anywhere else.
+    bool appendNumber(const std::string& text);
+    bool tryPopCharacter();
+    // Replaces the text of the last token, which must be a number; invalid text is rejected.
+    bool trySetLastNumber(const std::string& text);
+    void apply(Unary unary);
+    void clear();
+
+    // Replaces a number before "=" and recomputes the result of a completed equation.
+    bool setNumber(size_t tokenIndex, const std::string& text);
+    // Recomputes the result of a completed equation, returns whether its text or status changed.
+    bool recalculate();
+    // Derives the first number and its status again from the result of source, returns whether
+    // either changed.
+    bool refreshFromSource(const Equation& source);
+
+    // The number of tokens before "=", fails when they are too few to calculate.
+    bool operandEnd(size_t* end) const;
+
+private:
+    // Appends or removes an operator token and keeps the parentheses paired.
+    void pushOp(Op op);
+    void popOp();
+    // tryCalculate() that also writes the result text when text is not null.
+    bool evaluate(Evaluation* evaluation, std::string* text) const;
+    bool evaluateInteger(Evaluation* evaluation, std::string* text) const;
+    bool setNumberText(size_t tokenIndex, const std::string& text);
+    void detachFromSource();
+    void markChanged(size_t tokenIndex)
+    {
+        _firstChangedToken = std::min(_firstChangedToken, tokenIndex);
+    }
+
+    std::vector<Token> _tokens;
+    // Indexes of the open parentheses not closed yet, innermost last.
+    std::vector<size_t> _openParentheses;
+    bool _completed = false;
+    Status _status = Status::Ok;
+    Arithmetic _arithmetic = Arithmetic::Double;
+    Base _base = Base::Decimal;
+    size_t _source = g_noSource;
+    Status _sourceStatus = Status::Ok;
+    // Applied in order to the source result to give the first number.
+    std::vector<Unary> _sourceUnaries;
+    // See firstChangedToken(), all tokens of a new equation are.
+    size_t _firstChangedToken = 0;
+};
+} // namespace core
+
+#endif // CORE_EQUATION_H
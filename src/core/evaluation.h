@@ -0,0 +1,359 @@
+#ifndef CORE_EVALUATION_H
+#define CORE_EVALUATION_H
+
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "core/integer.h"
+#include "core/number_text.h"
+#include "core/operators.h"
+
+namespace core {
+// Every × and ÷ step is rounded to the 15 significant digits a history line shows.
+constexpr double roundProduct(double value) { return roundToDisplayPrecision(value); }
+
+constexpr bool isFinite(double value) { return value - value == 0; }
+
+// Applies op with IEEE semantics and, unless status already holds an earlier one, records what
+// a non-finite result came from. Only non-finite results are examined, so the common case costs
+// one comparison. The bitwise operators have no meaning for doubles and give NaN.
+constexpr double checkedApply(double left, double right, Op op, Status* status)
+{
+    const double value = isBitwise(op) ? std::numeric_limits<double>::quiet_NaN()
+                                       : applyOperator(left, right, op);
+    if (isFinite(value) || *status != Status::Ok)
+        return value;
+    if (value != value)
+        *status = Status::Invalid;
+    else if (isFinite(left) && op == Op::Divide && right == 0)
+        *status = Status::DivisionByZero;
+    else
+        *status = Status::Overflow;
+    return value;
+}
+
+// Folds value, operator, value, ... as they arrive, with × and ÷ binding tighter than + and -,
+// and those tighter than the bitwise operators and shifts, which bind as in C, see
+// bitwiseLevel(). Terms are added left to right once the following + or - shows they are
+// complete; a bitwise operator completes the sum and every pending operand of a tighter level
+// and combines the result into its own level. Each step goes through checkedApply(), found by
+// argument dependent lookup like roundProduct(), so that the first exception raised on the way
+// is kept in status().
+template <typename T>
+class BasicEvaluator
+{
+public:
+    constexpr explicit BasicEvaluator(const T& first)
+        : _bits{first, first, first, first}, _sum(first), _term(first)
+    {
+    }
+
+    // Starts over from first like a new evaluator, without copying the operands of every level.
+    constexpr void restart(const T& first)
+    {
+        _term = first;
+        _haveSum = false;
+        for (bool& have : _haveBits)
+            have = false;
+        _status = Status::Ok;
+    }
+
+    // Throws std::invalid_argument for Equal, see tryApply().
+    constexpr void apply(Op op, const T& value)
+    {
+        if (!tryApply(op, value))
+            throw std::invalid_argument("Invalid");
+    }
+
+    // Returns false and records Status::Invalid for Equal and the parentheses, which are not
+    // binary operators.
+    constexpr bool tryApply(Op op, const T& value)
+    {
+        if (op == Op::Equal || isParenthesis(op)) {
+            record(Status::Invalid);
+            return false;
+        }
+        if (isMultiplicative(op)) {
+            _term = roundProduct(checkedApply(_term, value, op, &_status));
+            return true;
+        }
+        if (isBitwise(op)) {
+            const size_t level = bitwiseLevel(op);
+            T operand = _haveSum ? checkedApply(_sum, _term, _pending, &_status) : _term;
+            for (size_t i = 0; i < level; ++i) {
+                if (_haveBits[i])
+                    operand = checkedApply(_bits[i], operand, _pendingBits[i], &_status);
+                _haveBits[i] = false;
+            }
+            _bits[level] = _haveBits[level]
+                               ? checkedApply(_bits[level], operand, _pendingBits[level], &_status)
+                               : operand;
+            _haveBits[level] = true;
+            _pendingBits[level] = op;
+            _haveSum = false;
+            _term = value;
+            return true;
+        }
+        _sum = _haveSum ? checkedApply(_sum, _term, _pending, &_status) : _term;
+        _haveSum = true;
+        _pending = op;
+        _term = value;
+        return true;
+    }
+
+    constexpr T result() const
+    {
+        Status status = _status;
+        return result(&status);
+    }
+
+    // The result and the first exception raised on the way to it.
+    constexpr T result(Status* status) const
+    {
+        *status = _status;
+        T value = _haveSum ? checkedApply(_sum, _term, _pending, status) : _term;
+        for (size_t i = 0; i < g_bitwiseLevels; ++i) {
+            if (_haveBits[i])
+                value = checkedApply(_bits[i], value, _pendingBits[i], status);
+        }
+        return value;
+    }
+
+    // Keeps a status raised elsewhere, such as inside a group, unless one was raised before.
+    constexpr void record(Status status)
+    {
+        if (_status == Status::Ok)
+            _status = status;
+    }
+
+private:
+    T _bits[g_bitwiseLevels];
+    T _sum;
+    T _term;
+    Op _pendingBits[g_bitwiseLevels] = {Op::ShiftLeft, Op::And, Op::Xor, Op::Or};
+    Op _pending = Op::Plus;
+    bool _haveBits[g_bitwiseLevels] = {};
+    bool _haveSum = false;
+    Status _status = Status::Ok;
+};
+
+using Evaluator = BasicEvaluator<double>;
+
+// The value of an expression and how its evaluation went.
+struct Evaluation
+{
+    double value = 0;
+    Status status = Status::Ok;
+};
+
+// Evaluates values[0] ops[0] values[1] ... values[count - 1].
+constexpr double evaluate(const double* values, const Op* ops, size_t count)
+{
+    if (count == 0)
+        throw std::invalid_argument("Invalid");
+    Evaluator evaluator(values[0]);
+    for (size_t i = 1; i < count; ++i)
+        evaluator.apply(ops[i - 1], values[i]);
+    return evaluator.result();
+}
+
+template <typename T>
+struct GroupLevel
+{
+    BasicEvaluator<T> evaluator{T()};
+    Op pending = Op::Plus;
+    bool started = false;
+};
+
+// A stack of fixed capacity with the part of the std::vector interface GroupingEvaluator uses,
+// for constant expressions, where std::vector is not available.
+template <typename T, size_t Capacity>
+class FixedStack
+{
+public:
+    constexpr bool empty() const { return _size == 0; }
+    constexpr size_t size() const { return _size; }
+    constexpr size_t max_size() const { return Capacity; }
+    constexpr T& back() { return _items[_size - 1]; }
+    constexpr void push_back(const T& item) { _items[_size++] = item; }
+    constexpr void pop_back() { --_size; }
+
+private:
+    T _items[Capacity] = {};
+    size_t _size = 0;
+};
+
+// Evaluates number, operator, number, ... with groups in parentheses in a single pass. An open
+// parenthesis saves the level it interrupts on the stack and the matching close parenthesis
+// applies the result of the group to that level, so the time is linear in the number of tokens
+// and nesting grows the stack, std::vector or FixedStack, instead of the call stack.
+template <typename T, typename Stack = std::vector<GroupLevel<T>>>
+class GroupingEvaluator
+{
+public:
+    // Each call returns false when the token cannot follow the ones before.
+    constexpr bool number(const T& value)
+    {
+        if (_expectOperator)
+            return false;
+        add(value);
+        return true;
+    }
+
+    constexpr bool op(Op op)
+    {
+        if (op == Op::Open) {
+            if (_expectOperator || _levels.size() == _levels.max_size())
+                return false;
+            _levels.push_back(_current);
+            _current = GroupLevel<T>();
+            return true;
+        }
+        if (!_expectOperator || op == Op::Equal || (op == Op::Close && _levels.empty()))
+            return false;
+        if (op == Op::Close) {
+            Status status = Status::Ok;
+            const T value = _current.evaluator.result(&status);
+            _current = _levels.back();
+            _levels.pop_back();
+            add(value);
+            _current.evaluator.record(status);
+            return true;
+        }
+        _current.pending = op;
+        _expectOperator = false;
+        return true;
+    }
+
+    // Fails unless the tokens so far form a complete expression.
+    constexpr bool result(T* value, Status* status) const
+    {
+        if (!_expectOperator || !_levels.empty())
+            return false;
+        *value = _current.evaluator.result(status);
+        return true;
+    }
+
+private:
+    constexpr void add(const T& value)
+    {
+        if (_current.started)
+            _current.evaluator.tryApply(_current.pending, value);
+        else
+            _current.evaluator.restart(value);
+        _current.started = true;
+        _expectOperator = true;
+    }
+
+    GroupLevel<T> _current;
+    Stack _levels;
+    bool _expectOperator = false;
+};
+
+// Nesting depth tryEvaluateExpression() supports, Equation has no limit.
+constexpr size_t g_maxConstantNesting = 32;
+
+// Walks the expression grammar: numbers and operators alternate, an open parenthesis may stand
+// wherever a number may and a close parenthesis after a number or another close parenthesis. A
+// minus directly at the start or after an operator belongs to the number, blanks are skipped and
+// everything from "=" on is ignored. Calls sink.number(text, value) and sink.op(op) for each
+// token, parentheses included, and fails unless there are at least two numbers, the parentheses
+// match and the expression ends with a number or a close parenthesis. With integerLiterals, a
+// number may also be a prefixed integer such as "0x1F", see parseInteger(); otherwise "0x1F"
+// reads as 0 × 1F and fails.
+template <typename Sink>
+constexpr bool scanExpression(std::string_view text, Sink& sink, bool integerLiterals = false)
+{
+    size_t i = 0;
+    size_t numbers = 0;
+    size_t depth = 0;
+    bool expectNumber = true;
+    while (i < text.size()) {
+        const char c = text[i];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            ++i;
+            continue;
+        }
+        if (expectNumber && c == '(') {
+            sink.op(Op::Open);
+            ++depth;
+            ++i;
+            continue;
+        }
+        if (expectNumber) {
+            size_t j = i;
+            if (text[j] == '-')
+                ++j;
+            if (integerLiterals && hasBasePrefix(text.substr(j))) {
+                j += 2;
+                while (j < text.size() && detail::digitValue(text[j]) < 16)
+                    ++j;
+            }
+            while (j < text.size() && (detail::isDigit(text[j]) || text[j] == '.'))
+                ++j;
+            const std::string_view number = text.substr(i, j - i);
+            double value = 0;
+            if (!parseNumber(number, &value))
+                return false;
+            sink.number(number, value);
+            ++numbers;
+            expectNumber = false;
+            i = j;
+            continue;
+        }
+        Op op = Op::Plus;
+        const size_t consumed = parseOperator(text.substr(i), &op);
+        if (consumed == 0)
+            return false;
+        if (op == Op::Equal)
+            break;
+        if (op == Op::Open || (op == Op::Close && depth == 0))
+            return false;
+        sink.op(op);
+        if (op == Op::Close)
+            --depth;
+        else
+            expectNumber = true;
+        i += consumed;
+    }
+    return numbers >= 2 && !expectNumber && depth == 0;
+}
+
+namespace detail {
+struct EvaluatingSink
+{
+    constexpr void number(std::string_view, double value) { valid &= evaluator.number(value); }
+    constexpr void op(Op op) { valid &= !isBitwise(op) && evaluator.op(op); }
+
+    GroupingEvaluator<double, FixedStack<GroupLevel<double>, g_maxConstantNesting>> evaluator;
+    bool valid = true;
+};
+} // namespace detail
+
+// Evaluates an expression the way Equation::parse does and yields the value the completed
+// equation's result holds, bit for bit, also in constant expressions.
+constexpr bool tryEvaluateExpression(std::string_view text, double* result)
+{
+    detail::EvaluatingSink sink;
+    double value = 0;
+    Status status = Status::Ok;
+    if (!scanExpression(text, sink) || !sink.valid || !sink.evaluator.result(&value, &status))
+        return false;
+    *result = roundToDisplayPrecision(value);
+    return true;
+}
+
+// In a constant expression, invalid text or a division by zero fails to compile.
+constexpr double evaluateExpression(std::string_view text)
+{
+    double result = 0;
+    if (!tryEvaluateExpression(text, &result))
+        throw std::invalid_argument("Invalid expression");
+    return result;
+}
+} // namespace core
+
+#endif // CORE_EVALUATION_H
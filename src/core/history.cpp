@@ -0,0 +1,228 @@
+#include <cassert>
+#include <set>
+
+#include "core/history.h"
+#include "core/number_text.h"
+
+namespace core {
+void History::append(uint8_t digit)
+{
+    assert(digit < 16);
+    if (empty() || back().completed())
+        _equations.emplace_back(_arithmetic, _base);
+    _equations.back().append(digit);
+    popFrontIfExceedLimit();
+}
+
+void History::appendDecimal()
+{
+    if (empty() || back().completed())
+        _equations.emplace_back(_arithmetic, _base);
+    _equations.back().appendDecimal();
+    popFrontIfExceedLimit();
+}
+
+bool History::appendNumber(const std::string& text)
+{
+    const bool newLine = empty() || back().completed();
+    if (newLine)
+        _equations.emplace_back(_arithmetic, _base);
+    if (!_equations.back().appendNumber(text)) {
+        if (newLine)
+            _equations.pop_back();
+        return false;
+    }
+    popFrontIfExceedLimit();
+    return true;
+}
+
+void History::append(Op op)
+{
+    // An open parenthesis starts a new line like a digit, other operators continue from the
+    // last result.
+    if (op == Op::Open && (empty() || back().completed())) {
+        _equations.emplace_back(_arithmetic, _base);
+        _equations.back().append(op);
+        popFrontIfExceedLimit();
+        return;
+    }
+    if (empty())
+        return;
+    if (back().completed()) {
+        pushContinuing();
+        _equations.back().append(op);
+        popFrontIfExceedLimit();
+        return;
+    }
+    _equations.back().append(op);
+    if (back().completed())
+        registerCompletedBack();
+    popFrontIfExceedLimit();
+}
+
+void History::tryPopLastCharacter()
+{
+    if (empty() || back().completed() || back().empty())
+        return;
+    _equations.back().tryPopCharacter();
+}
+
+void History::appendCompleted(std::vector<Equation> equations)
+{
+    if (equations.empty())
+        return;
+    Equation pending;
+    if (!empty() && !back().completed()) {
+        pending = std::move(_equations.back());
+        _equations.pop_back();
+    }
+    for (auto& equation : equations) {
+        if (!equation.completed())
+            continue;
+        _equations.push_back(std::move(equation));
+        registerCompletedBack();
+        popFrontIfExceedLimit();
+    }
+    if (!pending.empty()) {
+        const size_t pendingId = firstId() + size();
+        if (pending.source() != g_noSource)
+            _dependents[pending.source()].push_back(pendingId);
+        _equations.push_back(std::move(pending));
+        popFrontIfExceedLimit();
+    }
+}
+
+void History::toggleSign()
+{
+    if (Equation* const equation = lastNumberForUnaryOperator())
+        equation->apply(Unary::ToggleSign);
+}
+
+void History::applyPercent()
+{
+    if (Equation* const equation = lastNumberForUnaryOperator())
+        equation->apply(Unary::Percent);
+}
+
+void History::setArithmetic(Arithmetic arithmetic)
+{
+    _arithmetic = arithmetic;
+    if (!empty() && !back().completed())
+        _equations.back().setArithmetic(arithmetic);
+}
+
+void History::setBase(Base base)
+{
+    _base = base;
+    if (!empty() && !back().completed())
+        _equations.back().setBase(base);
+}
+
+void History::clearEntry()
+{
+    if (empty())
+        return;
+    if (back().empty()) {
+        clear();
+    } else if (back().completed()) {
+        _equations.emplace_back(_arithmetic, _base);
+        popFrontIfExceedLimit();
+    } else {
+        _equations.back().clear();
+    }
+}
+
+void History::clear()
+{
+    _evictedCount += size();
+    _equations.clear();
+    _statistics.clear();
+    _dependents.clear();
+}
+
+bool History::editNumber(size_t id, size_t tokenIndex, const std::string& text,
+                         std::vector<size_t>* changedIds)
+{
+    if (!contains(id) || !at(id).completed())
+        return false;
+    Equation& edited = _equations[id - firstId()];
+    const std::string before = edited.text();
+    const Status statusBefore = edited.status();
+    if (!edited.setNumber(tokenIndex, text))
+        return false;
+    if (edited.text() == before && edited.status() == statusBefore)
+        return true;
+
+    changedIds->push_back(id);
+    std::set<size_t> pending;
+    const auto scheduleDependents = [&](size_t source) {
+        const auto dependents = _dependents.find(source);
+        if (dependents != _dependents.end())
+            pending.insert(dependents->second.begin(), dependents->second.end());
+    };
+    scheduleDependents(id);
+    while (!pending.empty()) {
+        const size_t dependentId = *pending.begin();
+        pending.erase(pending.begin());
+        if (!contains(dependentId))
+            continue;
+        Equation& dependent = _equations[dependentId - firstId()];
+        const size_t source = dependent.source();
+        // Entries of lines whose first number was typed over since are stale.
+        if (source == g_noSource || !contains(source))
+            continue;
+        const std::string previousResult = dependent.completed() ? dependent.back().text : "";
+        const Status previousStatus = dependent.status();
+        if (!dependent.refreshFromSource(at(source)))
+            continue;
+        changedIds->push_back(dependentId);
+        if (dependent.completed() &&
+            (dependent.back().text != previousResult || dependent.status() != previousStatus))
+            scheduleDependents(dependentId);
+    }
+    // Completed lines precede the only incomplete one, so their window index is their position.
+    for (const size_t changedId : *changedIds) {
+        if (at(changedId).completed())
+            _statistics.replace(changedId - firstId(), at(changedId).result());
+    }
+    return true;
+}
+
+void History::registerCompletedBack()
+{
+    _statistics.push(back().result());
+    if (_observer)
+        _observer(_evictedCount + size() - 1, back());
+}
+
+Equation* History::lastNumberForUnaryOperator()
+{
+    if (empty() || back().empty() || !back().back().isNumber)
+        return nullptr;
+    if (back().completed()) {
+        pushContinuing();
+        popFrontIfExceedLimit();
+    }
+    return &_equations.back();
+}
+
+void History::pushContinuing()
+{
+    const size_t sourceId = firstId() + size() - 1;
+    _equations.push_back(Equation::continuing(back(), sourceId));
+    _equations.back().setArithmetic(_arithmetic);
+    _equations.back().setBase(_base);
+    _dependents[sourceId].push_back(sourceId + 1);
+}
+
+void History::popFrontIfExceedLimit()
+{
+    while (size() > _sizeLimit) {
+        if (_equations.front().completed())
+            _statistics.popFront();
+        _equations.pop_front();
+        _dependents.erase(_evictedCount);
+        ++_evictedCount;
+    }
+}
+} // namespace core
@@ -0,0 +1,87 @@
+#ifndef CORE_HISTORY_H
+#define CORE_HISTORY_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "core/equation.h"
+#include "core/statistics.h"
+
+namespace core {
+// The calculator's history of equations: the last one is being typed unless it is completed.
+// Keeps at most sizeLimit equations and the running statistics of the completed ones.
+class History
+{
+public:
+    using CompletionObserver = std::function<void(size_t id, const Equation& equation)>;
+
+    explicit History(size_t sizeLimit = 32) : _sizeLimit(sizeLimit) {}
+
+    const std::deque<Equation>& equations() const { return _equations; }
+    size_t size() const { return _equations.size(); }
+    bool empty() const { return _equations.empty(); }
+    const Equation& operator[](size_t index) const { return _equations[index]; }
+    const Equation& back() const { return _equations.back(); }
+    bool contains(size_t id) const { return id >= firstId() && id - firstId() < size(); }
+    const Equation& at(size_t id) const { return _equations[id - firstId()]; }
+    // Called once a mirror of the equation id has caught up, see Equation::firstChangedToken().
+    void clearChanges(size_t id) { _equations[id - firstId()].clearChanges(); }
+    // Identifier of the first equation, identifiers keep increasing across evictions and clears.
+    size_t firstId() const { return _evictedCount; }
+    size_t sizeLimit() const { return _sizeLimit; }
+    const RunningStatistics& statistics() const { return _statistics; }
+    Arithmetic arithmetic() const { return _arithmetic; }
+    // Applies to the line being typed and every later one, completed lines keep their results.
+    void setArithmetic(Arithmetic arithmetic);
+    Base base() const { return _base; }
+    // The base of programmer mode, applies like the arithmetic.
+    void setBase(Base base);
+    // Called for every equation that becomes completed, before it can be evicted.
+    void setCompletionObserver(CompletionObserver observer) { _observer = std::move(observer); }
+
+    void append(uint8_t digit);
+    void appendDecimal();
+    // Appends a whole number to the current line, or starts a new one with it after a completed
+    // line, see Equation::appendNumber().
+    bool appendNumber(const std::string& text);
+    void append(Op op);
+    void tryPopLastCharacter();
+    // Appends already completed equations, the line being typed stays the last one.
+    void appendCompleted(std::vector<Equation> equations);
+    void toggleSign();
+    void applyPercent();
+    // Clears the current line, or starts a new one after a completed line, or clears the whole
+    // history when the current line is already empty.
+    void clearEntry();
+    void clear();
+
+    // Replaces a number of a completed equation, then recomputes it and every equation that
+    // continued from its result, directly or through others. Dependents always have larger
+    // identifiers, so they are visited in identifier order, and a branch stops as soon as a
+    // result and its status come out unchanged. changedIds receives the equations whose text or
+    // status changed.
+    bool editNumber(size_t id, size_t tokenIndex, const std::string& text,
+                    std::vector<size_t>* changedIds);
+
+private:
+    void popFrontIfExceedLimit();
+    void registerCompletedBack();
+    void pushContinuing();
+    Equation* lastNumberForUnaryOperator();
+
+    std::deque<Equation> _equations;
+    size_t _sizeLimit;
+    size_t _evictedCount = 0;
+    Arithmetic _arithmetic = Arithmetic::Double;
+    Base _base = Base::Decimal;
+    RunningStatistics _statistics;
+    CompletionObserver _observer;
+    // Source identifier to the equations that continued from its result.
+    std::unordered_map<size_t, std::vector<size_t>> _dependents;
+};
+} // namespace core
+
+#endif // CORE_HISTORY_H
@@ -0,0 +1,66 @@
+#include <cstring>
+
+#include "core/integer.h"
+
+namespace {
+constexpr char g_digitPairs[] = "00010203040506070809"
+                                "10111213141516171819"
+                                "20212223242526272829"
+                                "30313233343536373839"
+                                "40414243444546474849"
+                                "50515253545556575859"
+                                "60616263646566676869"
+                                "70717273747576777879"
+                                "80818283848586878889"
+                                "90919293949596979899";
+
+constexpr unsigned bitsPerDigit(core::Base base)
+{
+    return base == core::Base::Hexadecimal ? 4 : base == core::Base::Octal ? 3 : 1;
+}
+} // namespace
+
+namespace core {
+size_t writeInteger(int64_t value, Base base, char* buffer)
+{
+    // Digits are written backwards from the end of a scratch buffer and copied once.
+    char digits[g_maxIntegerText];
+    char* const end = digits + g_maxIntegerText;
+    char* begin = end;
+    if (base == Base::Decimal) {
+        uint64_t magnitude = value < 0 ? uint64_t(0) - uint64_t(value) : uint64_t(value);
+        for (; magnitude >= 100; magnitude /= 100) {
+            begin -= 2;
+            std::memcpy(begin, g_digitPairs + 2 * (magnitude % 100), 2);
+        }
+        if (magnitude >= 10) {
+            begin -= 2;
+            std::memcpy(begin, g_digitPairs + 2 * magnitude, 2);
+        } else {
+            *--begin = char('0' + magnitude);
+        }
+        if (value < 0)
+            *--begin = '-';
+    } else {
+        const unsigned bits = bitsPerDigit(base);
+        const uint64_t mask = (uint64_t(1) << bits) - 1;
+        uint64_t pattern = uint64_t(value);
+        do {
+            *--begin = digitCharacter(uint8_t(pattern & mask));
+            pattern >>= bits;
+        } while (pattern != 0);
+        const std::string_view prefix = basePrefix(base);
+        begin -= prefix.size();
+        std::memcpy(begin, prefix.data(), prefix.size());
+    }
+    const size_t length = size_t(end - begin);
+    std::memcpy(buffer, begin, length);
+    return length;
+}
+
+std::string formatInteger(int64_t value, Base base)
+{
+    char text[g_maxIntegerText];
+    return std::string(text, writeInteger(value, base, text));
+}
+} // namespace core
@@ -0,0 +1,215 @@
+#ifndef CORE_INTEGER_H
+#define CORE_INTEGER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "core/operators.h"
+
+namespace core {
+// Bases of programmer mode. Numbers in a base other than decimal carry a prefix, "0x1F", "0o17"
+// or "0b101", and are written in two's complement, so that -1 is "0xFFFFFFFFFFFFFFFF".
+enum class Base : uint8_t { Binary = 2, Octal = 8, Decimal = 10, Hexadecimal = 16 };
+
+// A sign and 20 decimal digits, or a prefix and 64 binary digits.
+constexpr size_t g_maxIntegerText = 66;
+
+namespace detail {
+constexpr int64_t g_int64Min = std::numeric_limits<int64_t>::min();
+
+// The value of a digit in any base up to 16, or 16 for anything else.
+constexpr unsigned digitValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return unsigned(c - '0');
+    if (c >= 'A' && c <= 'F')
+        return unsigned(c - 'A' + 10);
+    if (c >= 'a' && c <= 'f')
+        return unsigned(c - 'a' + 10);
+    return 16;
+}
+
+constexpr std::string_view withoutSign(std::string_view text)
+{
+    return !text.empty() && text[0] == '-' ? text.substr(1) : text;
+}
+} // namespace detail
+
+constexpr char digitCharacter(uint8_t digit) { return "0123456789ABCDEF"[digit & 15]; }
+
+// "0x", "0o", "0b" or nothing for decimal.
+constexpr std::string_view basePrefix(Base base)
+{
+    switch (base) {
+    case Base::Binary:
+        return "0b";
+    case Base::Octal:
+        return "0o";
+    case Base::Decimal:
+        break;
+    case Base::Hexadecimal:
+        return "0x";
+    }
+    return "";
+}
+
+// The base of number text from its prefix, after an optional '-'; decimal without one.
+constexpr Base integerBase(std::string_view text)
+{
+    text = detail::withoutSign(text);
+    if (text.size() < 2 || text[0] != '0')
+        return Base::Decimal;
+    switch (text[1]) {
+    case 'b':
+    case 'B':
+        return Base::Binary;
+    case 'o':
+    case 'O':
+        return Base::Octal;
+    case 'x':
+    case 'X':
+        return Base::Hexadecimal;
+    }
+    return Base::Decimal;
+}
+
+constexpr bool hasBasePrefix(std::string_view text)
+{
+    return integerBase(text) != Base::Decimal;
+}
+
+// Reads an optional '-' and either decimal digits within the int64 range or a prefixed number
+// of at most 64 bits, taken as two's complement and negated with wraparound by '-'.
+constexpr bool parseInteger(std::string_view text, int64_t* value)
+{
+    const bool negative = !text.empty() && text[0] == '-';
+    const Base base = integerBase(text);
+    const std::string_view digits =
+        detail::withoutSign(text).substr(basePrefix(base).size());
+    if (digits.empty())
+        return false;
+    const uint64_t radix = uint64_t(base);
+    // Decimal text may reach 2^63 only for INT64_MIN, any other base takes all 64 bits.
+    const uint64_t limit = base != Base::Decimal ? ~uint64_t(0)
+                                                 : uint64_t(detail::g_int64Min) - !negative;
+    uint64_t magnitude = 0;
+    for (const char c : digits) {
+        const unsigned digit = detail::digitValue(c);
+        if (digit >= radix || magnitude > (limit - digit) / radix)
+            return false;
+        magnitude = magnitude * radix + digit;
+    }
+    *value = int64_t(negative ? uint64_t(0) - magnitude : magnitude);
+    return true;
+}
+
+// Writes value in base to buffer, which must hold g_maxIntegerText characters, and returns the
+// length: decimal two digits per division, the other bases by shifts, with no allocation and
+// no locale, so that long histories in programmer mode stay cheap to format.
+size_t writeInteger(int64_t value, Base base, char* buffer);
+std::string formatInteger(int64_t value, Base base);
+
+namespace detail {
+// Each stores the result wrapped around to 64 bits and returns whether the exact one overflows.
+inline bool addOverflow(int64_t a, int64_t b, int64_t* result)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_add_overflow(a, b, result);
+#else
+    const uint64_t sum = uint64_t(a) + uint64_t(b);
+    *result = int64_t(sum);
+    return int64_t((uint64_t(a) ^ sum) & (uint64_t(b) ^ sum)) < 0;
+#endif
+}
+
+inline bool subtractOverflow(int64_t a, int64_t b, int64_t* result)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_sub_overflow(a, b, result);
+#else
+    const uint64_t difference = uint64_t(a) - uint64_t(b);
+    *result = int64_t(difference);
+    return int64_t((uint64_t(a) ^ uint64_t(b)) & (uint64_t(a) ^ difference)) < 0;
+#endif
+}
+
+inline bool multiplyOverflow(int64_t a, int64_t b, int64_t* result)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_mul_overflow(a, b, result);
+#else
+    *result = int64_t(uint64_t(a) * uint64_t(b));
+    return a != 0 && ((a == -1 && b == g_int64Min) || *result / a != b);
+#endif
+}
+} // namespace detail
+
+// Integers have nothing to round, see BasicEvaluator.
+constexpr int64_t roundProduct(int64_t value) { return value; }
+
+// Programmer mode arithmetic: + - × checked for overflow, ÷ truncating toward zero, & | ^ bit by
+// bit, << dropping the bits shifted out and >> keeping the sign. Whether an operation fails is
+// computed alongside its result rather than branched on: an overflow keeps the wrapped result,
+// a division by zero and a shift by a count outside [0, 63] give zero, and status records the
+// failure unless it already holds an earlier one.
+inline int64_t checkedApply(int64_t left, int64_t right, Op op, Status* status)
+{
+    int64_t result = 0;
+    bool overflow = false;
+    bool divisionByZero = false;
+    bool invalid = false;
+    switch (op) {
+    case Op::Plus:
+        overflow = detail::addOverflow(left, right, &result);
+        break;
+    case Op::Minus:
+        overflow = detail::subtractOverflow(left, right, &result);
+        break;
+    case Op::Multiply:
+        overflow = detail::multiplyOverflow(left, right, &result);
+        break;
+    case Op::Divide: {
+        divisionByZero = right == 0;
+        // INT64_MIN / -1 is the one quotient that overflows, its wrapped result is INT64_MIN.
+        overflow = (left == detail::g_int64Min) & (right == -1);
+        const int64_t quotient = left / (divisionByZero | overflow ? 1 : right);
+        result = quotient & -int64_t(!divisionByZero);
+        break;
+    }
+    case Op::And:
+        result = left & right;
+        break;
+    case Op::Or:
+        result = left | right;
+        break;
+    case Op::Xor:
+        result = left ^ right;
+        break;
+    case Op::ShiftLeft:
+    case Op::ShiftRight: {
+        invalid = uint64_t(right) > 63;
+        const unsigned count = unsigned(right) & 63;
+        const int64_t shifted =
+            op == Op::ShiftLeft ? int64_t(uint64_t(left) << count) : left >> count;
+        result = shifted & -int64_t(!invalid);
+        break;
+    }
+    case Op::Equal:
+    case Op::Open:
+    case Op::Close:
+        invalid = true;
+        break;
+    }
+    const Status raised = divisionByZero ? Status::DivisionByZero
+                          : overflow     ? Status::Overflow
+                          : invalid      ? Status::Invalid
+                                         : Status::Ok;
+    *status = *status == Status::Ok ? raised : *status;
+    return result;
+}
+} // namespace core
+
+#endif // CORE_INTEGER_H
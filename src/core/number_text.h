@@ -0,0 +1,39 @@
+#ifndef CORE_NUMBER_TEXT_H
+#define CORE_NUMBER_TEXT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "core/decimal.h"
+#include "core/integer.h"
+
+namespace core {
+// Number text is always in the C locale: '.' decimal point, no group separators.
+constexpr int g_displayDigits = 15;
+
+// Shortest of fixed or scientific notation with 15 significant digits, like printf's "%.15g"
+// in the C locale, character for character.
+std::string formatNumber(double value);
+// The fewest significant digits, at least 15, that parse back to exactly value, in the
+// notation of formatNumber(); the two agree whenever 15 digits are enough.
+std::string formatShortest(double value);
+// Also reads the prefixed integers of programmer mode, "0x1F" as 31, see parseInteger().
+constexpr bool parseNumber(std::string_view text, double* value)
+{
+    int64_t integer = 0;
+    if (!hasBasePrefix(text))
+        return parseDecimal(text, value);
+    if (!parseInteger(text, &integer))
+        return false;
+    *value = double(integer);
+    return true;
+}
+// The value a number keeps once it has been written to the history.
+constexpr double roundToDisplayPrecision(double value)
+{
+    return detail::roundToSignificantDigits(value, g_displayDigits);
+}
+} // namespace core
+
+#endif // CORE_NUMBER_TEXT_H
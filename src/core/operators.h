@@ -0,0 +1,171 @@
+#ifndef CORE_OPERATORS_H
+#define CORE_OPERATORS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace core {
+// Open and Close are the parentheses, they group operands rather than combine them. And to
+// ShiftRight are the bitwise operators and shifts of programmer mode.
+enum class Op : uint8_t {
+    Plus,
+    Minus,
+    Multiply,
+    Divide,
+    Equal,
+    Open,
+    Close,
+    And,
+    Or,
+    Xor,
+    ShiftLeft,
+    ShiftRight
+};
+
+// How an evaluation went, after the IEEE 754 exceptions: a division of a finite value by zero,
+// a finite calculation that ends in infinity, or one without a meaningful result such as 0/0 or
+// inf - inf. Invalid also stands for tokens that do not form an expression.
+enum class Status : uint8_t { Ok, DivisionByZero, Overflow, Invalid };
+
+// UTF-8 text of the operator as shown in the history, e.g. "×" for Multiply.
+constexpr const char* symbol(Op op)
+{
+    switch (op) {
+    case Op::Plus:
+        return "+";
+    case Op::Minus:
+        return "-";
+    case Op::Multiply:
+        return "\xC3\x97";
+    case Op::Divide:
+        return "\xC3\xB7";
+    case Op::Equal:
+        return "=";
+    case Op::Open:
+        return "(";
+    case Op::Close:
+        return ")";
+    case Op::And:
+        return "&";
+    case Op::Or:
+        return "|";
+    case Op::Xor:
+        return "^";
+    case Op::ShiftLeft:
+        return "<<";
+    case Op::ShiftRight:
+        return ">>";
+    }
+    return "";
+}
+
+// Recognizes "+", "-", "*", "x", "/", "=", "(", ")", "&", "|", "^", "<<", ">>" and the UTF-8 "×"
+// and "÷" at the start of text, returns the number of bytes consumed or 0.
+constexpr size_t parseOperator(std::string_view text, Op* op)
+{
+    if (text.empty())
+        return 0;
+    switch (text[0]) {
+    case '+':
+        *op = Op::Plus;
+        return 1;
+    case '-':
+        *op = Op::Minus;
+        return 1;
+    case '*':
+    case 'x':
+        *op = Op::Multiply;
+        return 1;
+    case '/':
+        *op = Op::Divide;
+        return 1;
+    case '=':
+        *op = Op::Equal;
+        return 1;
+    case '(':
+        *op = Op::Open;
+        return 1;
+    case ')':
+        *op = Op::Close;
+        return 1;
+    case '&':
+        *op = Op::And;
+        return 1;
+    case '|':
+        *op = Op::Or;
+        return 1;
+    case '^':
+        *op = Op::Xor;
+        return 1;
+    }
+    if (text.size() >= 2 && (text[0] == '<' || text[0] == '>') && text[1] == text[0]) {
+        *op = text[0] == '<' ? Op::ShiftLeft : Op::ShiftRight;
+        return 2;
+    }
+    if (text.size() >= 2 && text[0] == '\xC3' && text[1] == '\x97') {
+        *op = Op::Multiply;
+        return 2;
+    }
+    if (text.size() >= 2 && text[0] == '\xC3' && text[1] == '\xB7') {
+        *op = Op::Divide;
+        return 2;
+    }
+    return 0;
+}
+
+constexpr bool isMultiplicative(Op op) { return op == Op::Multiply || op == Op::Divide; }
+constexpr bool isParenthesis(Op op) { return op == Op::Open || op == Op::Close; }
+constexpr bool isBitwise(Op op)
+{
+    return op == Op::And || op == Op::Or || op == Op::Xor || op == Op::ShiftLeft ||
+           op == Op::ShiftRight;
+}
+
+// The bitwise operators bind as in C, all below + and -: the shifts tightest, then &, ^ and |.
+constexpr size_t g_bitwiseLevels = 4;
+constexpr size_t bitwiseLevel(Op op)
+{
+    switch (op) {
+    case Op::ShiftLeft:
+    case Op::ShiftRight:
+        return 0;
+    case Op::And:
+        return 1;
+    case Op::Xor:
+        return 2;
+    default:
+        return 3;
+    }
+}
+
+// The arithmetic behind every operator, for any number type with the four operations. The
+// bitwise operators have no meaning here, see checkedApply() for integers.
+template <typename T>
+constexpr T applyOperator(const T& left, const T& right, Op op)
+{
+    switch (op) {
+    case Op::Plus:
+        return left + right;
+    case Op::Minus:
+        return left - right;
+    case Op::Multiply:
+        return left * right;
+    case Op::Divide:
+        return left / right;
+    case Op::Equal:
+    case Op::Open:
+    case Op::Close:
+    case Op::And:
+    case Op::Or:
+    case Op::Xor:
+    case Op::ShiftLeft:
+    case Op::ShiftRight:
+        break;
+    }
+    throw std::invalid_argument("Invalid arguments");
+}
+} // namespace core
+
+#endif // CORE_OPERATORS_H
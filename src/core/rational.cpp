@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "core/number_text.h"
+#include "core/rational.h"
+
+namespace {
+constexpr int64_t g_int64Max = std::numeric_limits<int64_t>::max();
+// 10^18 is the largest power of ten below g_int64Max.
+constexpr int g_fastDigits = 18;
+constexpr int g_maxExponent = 1000;
+
+constexpr int64_t powerOfTen(int exponent)
+{
+    int64_t result = 1;
+    for (; exponent > 0; --exponent)
+        result *= 10;
+    return result;
+}
+
+// The checked operations also reject INT64_MIN, so that every int64 part can be negated.
+bool checkedAdd(int64_t a, int64_t b, int64_t* result)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_add_overflow(a, b, result) && *result != -g_int64Max - 1;
+#else
+    if ((b > 0 && a > g_int64Max - b) || (b < 0 && a < -g_int64Max - b))
+        return false;
+    *result = a + b;
+    return true;
+#endif
+}
+
+bool checkedMultiply(int64_t a, int64_t b, int64_t* result)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_mul_overflow(a, b, result) && *result != -g_int64Max - 1;
+#else
+    const uint64_t magnitudeA = a < 0 ? uint64_t(-a) : uint64_t(a);
+    const uint64_t magnitudeB = b < 0 ? uint64_t(-b) : uint64_t(b);
+    if (magnitudeA != 0 && magnitudeB > uint64_t(g_int64Max) / magnitudeA)
+        return false;
+    *result = a * b;
+    return true;
+#endif
+}
+
+// Multiplies two fractions in lowest terms, cross-reducing first so that the products stay
+// as small as possible.
+bool multiplyFast(int64_t numeratorA, int64_t denominatorA, int64_t numeratorB,
+                  int64_t denominatorB, int64_t* numerator, int64_t* denominator)
+{
+    const int64_t gcdA = std::gcd(numeratorA, denominatorB);
+    const int64_t gcdB = std::gcd(numeratorB, denominatorA);
+    if (gcdA == 0 || gcdB == 0) {
+        *numerator = 0;
+        *denominator = 1;
+        return true;
+    }
+    return checkedMultiply(numeratorA / gcdA, numeratorB / gcdB, numerator) &&
+           checkedMultiply(denominatorA / gcdB, denominatorB / gcdA, denominator);
+}
+
+// Writes digits * 10^-scale, or fails when that takes more than g_maxExactDigits digits.
+bool decimalText(std::string digits, size_t scale, bool negative, std::string* text)
+{
+    if (digits.size() > size_t(core::g_maxExactDigits) || scale > size_t(core::g_maxExactDigits))
+        return false;
+    if (scale > 0) {
+        if (digits.size() <= scale)
+            digits.insert(0, scale + 1 - digits.size(), '0');
+        digits.insert(digits.size() - scale, 1, '.');
+    }
+    *text = negative ? '-' + digits : std::move(digits);
+    return true;
+}
+} // namespace
+
+namespace core {
+Rational::Rational(int64_t value) : _numerator(value)
+{
+    if (value == -g_int64Max - 1)
+        *this = fromBig(BigInt(value), BigInt(1));
+}
+
+bool Rational::parse(std::string_view text, Rational* value)
+{
+    size_t i = 0;
+    bool negative = false;
+    if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+        negative = text[i] == '-';
+        ++i;
+    }
+    const size_t digitsBegin = i;
+    int64_t mantissa = 0;
+    int significantDigits = 0;
+    int fractionDigits = 0;
+    bool anyDigit = false;
+    bool seenPoint = false;
+    for (; i < text.size(); ++i) {
+        if (text[i] == '.' && !seenPoint) {
+            seenPoint = true;
+            continue;
+        }
+        if (!detail::isDigit(text[i]))
+            break;
+        anyDigit = true;
+        fractionDigits += seenPoint;
+        if (mantissa != 0 || text[i] != '0')
+            ++significantDigits;
+        if (significantDigits <= g_fastDigits)
+            mantissa = mantissa * 10 + (text[i] - '0');
+    }
+    const size_t digitsEnd = i;
+    if (!anyDigit)
+        return false;
+    int exponent = 0;
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        ++i;
+        bool negativeExponent = false;
+        if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+            negativeExponent = text[i] == '-';
+            ++i;
+        }
+        if (i == text.size() || !detail::isDigit(text[i]))
+            return false;
+        for (; i < text.size() && detail::isDigit(text[i]); ++i) {
+            if (exponent <= g_maxExponent * 2)
+                exponent = exponent * 10 + (text[i] - '0');
+        }
+        if (negativeExponent)
+            exponent = -exponent;
+    }
+    if (i != text.size())
+        return false;
+    exponent -= fractionDigits;
+    if (exponent > g_maxExponent || exponent < -g_maxExponent)
+        return false;
+
+    if (significantDigits <= g_fastDigits) {
+        int64_t numerator;
+        if (exponent >= 0 && exponent <= g_fastDigits &&
+            checkedMultiply(mantissa, powerOfTen(exponent), &numerator)) {
+            *value = Rational(negative ? -numerator : numerator, 1);
+            return true;
+        }
+        if (exponent < 0 && exponent >= -g_fastDigits) {
+            const int64_t denominator = powerOfTen(-exponent);
+            const int64_t divisor = std::gcd(mantissa, denominator);
+            *value = Rational((negative ? -mantissa : mantissa) / divisor, denominator / divisor);
+            return true;
+        }
+    }
+    std::string digits;
+    for (size_t j = digitsBegin; j < digitsEnd; ++j) {
+        if (text[j] != '.')
+            digits += text[j];
+    }
+    BigInt numerator = BigInt::fromDecimal(digits);
+    if (negative)
+        numerator = -numerator;
+    if (exponent >= 0)
+        *value = fromBig(numerator * BigInt::powerOfTen(unsigned(exponent)), BigInt(1));
+    else
+        *value = fromBig(std::move(numerator), BigInt::powerOfTen(unsigned(-exponent)));
+    return true;
+}
+
+double Rational::toDouble() const
+{
+    // Both parts are exact doubles, so the division rounds only once.
+    constexpr int64_t exactLimit = int64_t(1) << 53;
+    if (!_big && _numerator >= -exactLimit && _numerator <= exactLimit &&
+        _denominator <= exactLimit)
+        return double(_numerator) / double(_denominator);
+    const BigInt numerator = bigNumerator().abs();
+    const BigInt denominator = bigDenominator();
+    // Scales the quotient to 63 or 64 bits, which makeDouble rounds together with the remainder.
+    const long shift = 63 + long(denominator.bitLength()) - long(numerator.bitLength());
+    BigInt quotient;
+    BigInt remainder;
+    BigInt::divide(shift >= 0 ? numerator.shiftedLeft(size_t(shift)) : numerator,
+                   shift >= 0 ? denominator : denominator.shiftedLeft(size_t(-shift)), &quotient,
+                   &remainder);
+    const double magnitude = detail::makeDouble(quotient.low64(), int(-shift), !remainder.isZero());
+    return bigNumerator().isNegative() ? -magnitude : magnitude;
+}
+
+// Only denominators 2^a 5^b have a terminating expansion, with max(a, b) decimals.
+std::string Rational::toText() const
+{
+    std::string text;
+    if (!_big) {
+        int64_t rest = _denominator;
+        int twos = 0;
+        int fives = 0;
+        for (; rest % 2 == 0; rest /= 2)
+            ++twos;
+        for (; rest % 5 == 0; rest /= 5)
+            ++fives;
+        if (rest != 1)
+            return formatNumber(toDouble());
+        const int scale = std::max(twos, fives);
+        int64_t digits;
+        if (scale <= g_fastDigits &&
+            checkedMultiply(_numerator < 0 ? -_numerator : _numerator,
+                            powerOfTen(scale) / _denominator, &digits)) {
+            if (decimalText(std::to_string(digits), size_t(scale), _numerator < 0, &text))
+                return text;
+            return formatNumber(toDouble());
+        }
+    }
+    const BigInt denominator = bigDenominator();
+    const size_t twos = denominator.trailingZeroBits();
+    BigInt rest = denominator.shiftedRight(twos);
+    size_t fives = 0;
+    for (BigInt quotient = rest; quotient.divideBySmall(5) == 0; quotient = rest) {
+        rest = quotient;
+        ++fives;
+    }
+    const size_t scale = std::max(twos, fives);
+    if (!rest.isOne() || scale > size_t(g_maxExactDigits))
+        return formatNumber(toDouble());
+    const BigInt numerator = bigNumerator();
+    const BigInt digits = numerator.abs() * (BigInt::powerOfTen(unsigned(scale)) / denominator);
+    if (decimalText(digits.toString(), scale, numerator.isNegative(), &text))
+        return text;
+    return formatNumber(toDouble());
+}
+
+Rational operator*(const Rational& a, const Rational& b)
+{
+    int64_t numerator;
+    int64_t denominator;
+    if (!a._big && !b._big &&
+        multiplyFast(a._numerator, a._denominator, b._numerator, b._denominator, &numerator,
+                     &denominator))
+        return Rational(numerator, denominator);
+    return Rational::fromBig(a.bigNumerator() * b.bigNumerator(),
+                             a.bigDenominator() * b.bigDenominator());
+}
+
+Rational operator/(const Rational& a, const Rational& b)
+{
+    if (b.isZero())
+        throw std::domain_error("Division by zero");
+    int64_t numerator;
+    int64_t denominator;
+    if (!a._big && !b._big &&
+        multiplyFast(a._numerator, a._denominator,
+                     b._numerator < 0 ? -b._denominator : b._denominator,
+                     b._numerator < 0 ? -b._numerator : b._numerator, &numerator, &denominator))
+        return Rational(numerator, denominator);
+    return Rational::fromBig(a.bigNumerator() * b.bigDenominator(),
+                             a.bigDenominator() * b.bigNumerator());
+}
+
+bool operator==(const Rational& a, const Rational& b)
+{
+    if (!a._big && !b._big)
+        return a._numerator == b._numerator && a._denominator == b._denominator;
+    return a.bigNumerator() == b.bigNumerator() && a.bigDenominator() == b.bigDenominator();
+}
+
+Rational Rational::add(const Rational& a, const Rational& b, bool subtract)
+{
+    if (!a._big && !b._big) {
+        const int64_t numeratorB = subtract ? -b._numerator : b._numerator;
+        int64_t sum;
+        if (a._denominator == b._denominator) {
+            if (checkedAdd(a._numerator, numeratorB, &sum)) {
+                const int64_t divisor = std::gcd(sum, a._denominator);
+                return Rational(sum / divisor, a._denominator / divisor);
+            }
+        } else {
+            // Knuth's addition, TAOCP 4.5.1: only the common part of the denominators can
+            // cancel against the sum.
+            const int64_t common = std::gcd(a._denominator, b._denominator);
+            const int64_t scaleA = b._denominator / common;
+            const int64_t scaleB = a._denominator / common;
+            int64_t left;
+            int64_t right;
+            int64_t denominator;
+            if (checkedMultiply(a._numerator, scaleA, &left) &&
+                checkedMultiply(numeratorB, scaleB, &right) && checkedAdd(left, right, &sum)) {
+                const int64_t divisor = std::gcd(sum, common);
+                if (checkedMultiply(scaleB, b._denominator / divisor, &denominator))
+                    return Rational(sum / divisor, denominator);
+            }
+        }
+    }
+    const BigInt left = a.bigNumerator() * b.bigDenominator();
+    const BigInt right = b.bigNumerator() * a.bigDenominator();
+    return fromBig(subtract ? left - right : left + right,
+                   a.bigDenominator() * b.bigDenominator());
+}
+
+Rational Rational::fromBig(BigInt numerator, BigInt denominator)
+{
+    if (denominator.isNegative()) {
+        numerator = -numerator;
+        denominator = -denominator;
+    }
+    const BigInt divisor = BigInt::gcd(numerator, denominator);
+    if (!divisor.isOne() && !divisor.isZero()) {
+        numerator = numerator / divisor;
+        denominator = denominator / divisor;
+    }
+    if (numerator.fitsInt64() && denominator.fitsInt64())
+        return Rational(numerator.toInt64(), denominator.toInt64());
+    Rational result;
+    result._big = true;
+    result._bigNumerator = std::move(numerator);
+    result._bigDenominator = std::move(denominator);
+    return result;
+}
+} // namespace core
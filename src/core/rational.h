@@ -0,0 +1,80 @@
+#ifndef CORE_RATIONAL_H
+#define CORE_RATIONAL_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "core/big_int.h"
+#include "core/operators.h"
+
+namespace core {
+// Exact fraction in lowest terms with a positive denominator. Numerator and denominator are
+// int64 as long as every intermediate result fits, which covers amounts with a few decimals,
+// and move to BigInt transparently on overflow and back once they fit again.
+class Rational
+{
+public:
+    Rational() = default;
+    Rational(int64_t value);
+
+    // Accepts number text as the history writes it: an optional sign, digits with an optional
+    // '.' and an optional exponent. Rejects "inf", "nan" and exponents beyond ±1000.
+    static bool parse(std::string_view text, Rational* value);
+
+    bool isZero() const { return !_big && _numerator == 0; }
+    bool isBig() const { return _big; }
+    double toDouble() const;
+    // The exact decimal expansion when it terminates within g_maxExactDigits significant
+    // digits, otherwise formatNumber(toDouble()).
+    std::string toText() const;
+
+    friend Rational operator+(const Rational& a, const Rational& b) { return add(a, b, false); }
+    friend Rational operator-(const Rational& a, const Rational& b) { return add(a, b, true); }
+    friend Rational operator*(const Rational& a, const Rational& b);
+    // Throws std::domain_error when b is zero.
+    friend Rational operator/(const Rational& a, const Rational& b);
+    friend bool operator==(const Rational& a, const Rational& b);
+    friend bool operator!=(const Rational& a, const Rational& b) { return !(a == b); }
+
+private:
+    // Both already in lowest terms, denominator positive.
+    Rational(int64_t numerator, int64_t denominator)
+        : _numerator(numerator), _denominator(denominator)
+    {
+    }
+
+    static Rational add(const Rational& a, const Rational& b, bool subtract);
+    // Reduces to lowest terms and moves back to int64 when both parts fit.
+    static Rational fromBig(BigInt numerator, BigInt denominator);
+    BigInt bigNumerator() const { return _big ? _bigNumerator : BigInt(_numerator); }
+    BigInt bigDenominator() const { return _big ? _bigDenominator : BigInt(_denominator); }
+
+    int64_t _numerator = 0;
+    int64_t _denominator = 1;
+    bool _big = false;
+    BigInt _bigNumerator;
+    BigInt _bigDenominator;
+};
+
+constexpr int g_maxExactDigits = 40;
+
+// Exact arithmetic has nothing to round, see BasicEvaluator.
+inline const Rational& roundProduct(const Rational& value) { return value; }
+
+// A division by zero has no exact result, nor has a bitwise operator on fractions: either is
+// recorded in status, unless that already holds an earlier one, and yields zero instead of
+// throwing.
+inline Rational checkedApply(const Rational& left, const Rational& right, Op op, Status* status)
+{
+    const bool divisionByZero = op == Op::Divide && right.isZero();
+    if (divisionByZero || isBitwise(op)) {
+        if (*status == Status::Ok)
+            *status = divisionByZero ? Status::DivisionByZero : Status::Invalid;
+        return Rational();
+    }
+    return applyOperator(left, right, op);
+}
+} // namespace core
+
+#endif // CORE_RATIONAL_H
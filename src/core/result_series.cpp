@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cmath>
+
+#include "core/result_series.h"
+
+namespace core {
+void Extent::add(double value)
+{
+    if (!std::isfinite(value))
+        return;
+    min = std::min(min, value);
+    max = std::max(max, value);
+}
+
+void Extent::add(const Extent& other)
+{
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+void ResultSeries::append(double value)
+{
+    _values.push_back(value);
+    size_t count = _values.size();
+    size_t index = count - 1;
+    for (size_t level = 1; count > 1; ++level) {
+        const size_t childCount = count;
+        index /= g_seriesFanout;
+        count = (count + g_seriesFanout - 1) / g_seriesFanout;
+        if (_levels.size() < level)
+            _levels.emplace_back();
+        std::vector<Extent>& entries = _levels[level - 1];
+        // A new entry, or a new level, starts from the children it already covers.
+        if (index < entries.size())
+            entries[index].add(value);
+        else
+            entries.push_back(combined(level - 1, index * g_seriesFanout,
+                                       std::min(childCount, index * g_seriesFanout +
+                                                                g_seriesFanout)));
+    }
+}
+
+void ResultSeries::set(size_t index, double value)
+{
+    _values[index] = value;
+    size_t childCount = _values.size();
+    for (size_t level = 1; level <= _levels.size(); ++level) {
+        index /= g_seriesFanout;
+        const size_t first = index * g_seriesFanout;
+        _levels[level - 1][index] =
+            combined(level - 1, first, std::min(childCount, first + g_seriesFanout));
+        childCount = _levels[level - 1].size();
+    }
+}
+
+void ResultSeries::clear()
+{
+    _values.clear();
+    _levels.clear();
+}
+
+// Like a segment tree: the ends of the range that do not fill an entry of the next level are
+// combined at this one, the aligned middle goes up a level.
+Extent ResultSeries::extent(size_t first, size_t last) const
+{
+    Extent result;
+    last = std::min(last, _values.size());
+    for (size_t level = 0; first < last; ++level) {
+        for (; first < last && first % g_seriesFanout != 0; ++first)
+            result.add(entry(level, first));
+        for (; first < last && last % g_seriesFanout != 0; --last)
+            result.add(entry(level, last - 1));
+        first /= g_seriesFanout;
+        last /= g_seriesFanout;
+    }
+    return result;
+}
+
+Extent ResultSeries::entry(size_t level, size_t index) const
+{
+    if (level > 0)
+        return _levels[level - 1][index];
+    Extent extent;
+    extent.add(_values[index]);
+    return extent;
+}
+
+Extent ResultSeries::combined(size_t level, size_t first, size_t last) const
+{
+    Extent result;
+    for (size_t i = first; i < last; ++i)
+        result.add(entry(level, i));
+    return result;
+}
+} // namespace core
@@ -0,0 +1,55 @@
+#ifndef CORE_RESULT_SERIES_H
+#define CORE_RESULT_SERIES_H
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace core {
+// The smallest and largest finite value of a range, empty() when it holds none.
+struct Extent
+{
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    bool empty() const { return min > max; }
+    // Infinities and NaN are left out, so that a single special value cannot flatten a plot.
+    void add(double value);
+    void add(const Extent& other);
+};
+
+// Entries of a level of ResultSeries per entry of the level above.
+constexpr size_t g_seriesFanout = 8;
+
+// Values in the order they were appended, with a pyramid of extents kept up to date as they
+// arrive: level k holds one Extent per g_seriesFanout^k values. Appending or replacing a value
+// touches one entry per level, and the extent of any range combines at most
+// 2 (g_seriesFanout - 1) entries per level, so that a plot asking for one extent per pixel
+// column costs the same for a thousand values as for millions. The pyramid takes a seventh of
+// the memory of the values.
+class ResultSeries
+{
+public:
+    size_t size() const { return _values.size(); }
+    bool empty() const { return _values.empty(); }
+    double operator[](size_t index) const { return _values[index]; }
+
+    void append(double value);
+    void set(size_t index, double value);
+    void clear();
+    // The extent of the values in [first, last), last is clamped to size().
+    Extent extent(size_t first, size_t last) const;
+
+private:
+    // Level 0 are the values themselves.
+    Extent entry(size_t level, size_t index) const;
+    // The extent of entries [first, last) of level, which must all exist.
+    Extent combined(size_t level, size_t first, size_t last) const;
+
+    std::vector<double> _values;
+    // _levels[k - 1] is level k, the last one has a single entry.
+    std::vector<std::vector<Extent>> _levels;
+};
+} // namespace core
+
+#endif // CORE_RESULT_SERIES_H
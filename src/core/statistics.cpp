@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STATISTICS_USE_SSE2
+#endif
+
+#include "core/statistics.h"
+
+namespace {
+// How far the largest magnitude in the window may drop below the largest one added since the
+// last recomputation, a loss of at most 8 bits of the sums.
+constexpr double g_cancellationRatio = 256;
+
+void kahanAdd(double& sum, double& compensation, double value)
+{
+    const double y = value - compensation;
+    const double t = sum + y;
+    compensation = (t - sum) - y;
+    sum = t;
+}
+
+double sampleStandardDeviation(double m2, size_t count)
+{
+    if (count < 2)
+        return 0;
+    return std::sqrt(std::max(m2, 0.0) / (count - 1));
+}
+
+// Overrides the aggregates of the finite values with what IEEE arithmetic over all count values
+// gives: ±inf for infinities of one sign, NaN for both signs or any NaN.
+void applySpecialValues(core::StatisticsSummary& result, size_t count, size_t nanCount,
+                        size_t positiveInfinityCount, size_t negativeInfinityCount)
+{
+    if (nanCount + positiveInfinityCount + negativeInfinityCount == 0)
+        return;
+    const double nan = std::nan("");
+    const double infinity = std::numeric_limits<double>::infinity();
+    double total = nan;
+    if (nanCount == 0 && negativeInfinityCount == 0)
+        total = infinity;
+    else if (nanCount == 0 && positiveInfinityCount == 0)
+        total = -infinity;
+    result.sum = result.mean = total;
+    result.standardDeviation = nan;
+    if (nanCount == count)
+        result.min = result.max = nan;
+}
+} // namespace
+
+namespace core {
+void RunningStatistics::push(double value)
+{
+    _window.push_back(value);
+    addValue(value);
+}
+
+void RunningStatistics::popFront()
+{
+    if (_window.empty())
+        return;
+    removeValue(_window.front());
+    _window.pop_front();
+    recomputeIfCancelled();
+}
+
+void RunningStatistics::replace(size_t index, double value)
+{
+    if (index >= _window.size())
+        return;
+    removeValue(_window[index]);
+    _window[index] = value;
+    addValue(value);
+    recomputeIfCancelled();
+}
+
+void RunningStatistics::clear()
+{
+    _window.clear();
+    _ordered.clear();
+    _finiteCount = _nanCount = _positiveInfinityCount = _negativeInfinityCount = 0;
+    _sum = _compensation = _mean = _m2 = _magnitude = 0;
+}
+
+void RunningStatistics::addValue(double value)
+{
+    if (!std::isnan(value))
+        _ordered.insert(value);
+    if (!std::isfinite(value)) {
+        ++(std::isnan(value) ? _nanCount
+                             : value > 0 ? _positiveInfinityCount : _negativeInfinityCount);
+        return;
+    }
+    accumulate(value);
+}
+
+void RunningStatistics::accumulate(double value)
+{
+    kahanAdd(_sum, _compensation, value);
+    _magnitude = std::max(_magnitude, std::fabs(value));
+    ++_finiteCount;
+    const double delta = value - _mean;
+    _mean += delta / _finiteCount;
+    _m2 += delta * (value - _mean);
+}
+
+void RunningStatistics::removeValue(double value)
+{
+    if (!std::isnan(value))
+        _ordered.erase(_ordered.find(value));
+    if (!std::isfinite(value)) {
+        --(std::isnan(value) ? _nanCount
+                             : value > 0 ? _positiveInfinityCount : _negativeInfinityCount);
+        return;
+    }
+    --_finiteCount;
+    if (_finiteCount == 0) {
+        _sum = _compensation = _mean = _m2 = _magnitude = 0;
+    } else {
+        kahanAdd(_sum, _compensation, -value);
+        const double delta = value - _mean;
+        _mean -= delta / _finiteCount;
+        _m2 = std::max(_m2 - delta * (value - _mean), 0.0);
+    }
+}
+
+void RunningStatistics::recomputeIfCancelled()
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    const auto lowest = _ordered.upper_bound(-infinity);
+    const auto highest = _ordered.lower_bound(infinity);
+    if (lowest == highest ||
+        _magnitude <= g_cancellationRatio *
+                          std::max(std::fabs(*lowest), std::fabs(*std::prev(highest))))
+        return;
+    _finiteCount = 0;
+    _sum = _compensation = _mean = _m2 = _magnitude = 0;
+    for (double value : _window) {
+        if (std::isfinite(value))
+            accumulate(value);
+    }
+}
+
+StatisticsSummary RunningStatistics::summary() const
+{
+    StatisticsSummary result;
+    result.count = _window.size();
+    if (result.count == 0)
+        return result;
+    result.sum = _sum;
+    result.mean = _mean;
+    if (!_ordered.empty()) {
+        result.min = *_ordered.begin();
+        result.max = *_ordered.rbegin();
+    }
+    result.standardDeviation = sampleStandardDeviation(_m2, _finiteCount);
+    applySpecialValues(result, result.count, _nanCount, _positiveInfinityCount,
+                       _negativeInfinityCount);
+    return result;
+}
+
+StatisticsSummary computeStatistics(const double* values, size_t count)
+{
+    StatisticsSummary result;
+    result.count = count;
+    if (count == 0)
+        return result;
+
+    // Infinities and NaN are masked out of the sums and NaN out of min/max, as in
+    // RunningStatistics; they are counted in a scalar pass only when there are any.
+    const double infinity = std::numeric_limits<double>::infinity();
+    double sum = 0;
+    double compensation = 0;
+    double min = infinity;
+    double max = -infinity;
+    bool special = false;
+    size_t i = 0;
+#ifdef STATISTICS_USE_SSE2
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d positiveInfinity = _mm_set1_pd(infinity);
+    const __m128d negativeInfinity = _mm_set1_pd(-infinity);
+    __m128d sumLanes = zero;
+    __m128d compensationLanes = zero;
+    __m128d minLanes = positiveInfinity;
+    __m128d maxLanes = negativeInfinity;
+    int finiteMask = 3;
+    for (; i + 2 <= count; i += 2) {
+        const __m128d v = _mm_loadu_pd(values + i);
+        const __m128d finite = _mm_cmpeq_pd(_mm_sub_pd(v, v), zero);
+        const __m128d ordered = _mm_cmpord_pd(v, v);
+        finiteMask &= _mm_movemask_pd(finite);
+        const __m128d y = _mm_sub_pd(_mm_and_pd(finite, v), compensationLanes);
+        const __m128d t = _mm_add_pd(sumLanes, y);
+        compensationLanes = _mm_sub_pd(_mm_sub_pd(t, sumLanes), y);
+        sumLanes = t;
+        minLanes = _mm_min_pd(
+            minLanes, _mm_or_pd(_mm_and_pd(ordered, v), _mm_andnot_pd(ordered, positiveInfinity)));
+        maxLanes = _mm_max_pd(
+            maxLanes, _mm_or_pd(_mm_and_pd(ordered, v), _mm_andnot_pd(ordered, negativeInfinity)));
+    }
+    special = finiteMask != 3;
+    double lanes[2];
+    _mm_storeu_pd(lanes, sumLanes);
+    kahanAdd(sum, compensation, lanes[0]);
+    kahanAdd(sum, compensation, lanes[1]);
+    _mm_storeu_pd(lanes, compensationLanes);
+    kahanAdd(sum, compensation, -lanes[0]);
+    kahanAdd(sum, compensation, -lanes[1]);
+    _mm_storeu_pd(lanes, minLanes);
+    min = std::min(lanes[0], lanes[1]);
+    _mm_storeu_pd(lanes, maxLanes);
+    max = std::max(lanes[0], lanes[1]);
+#endif
+    for (; i < count; ++i) {
+        if (!std::isfinite(values[i])) {
+            special = true;
+            if (std::isnan(values[i]))
+                continue;
+        } else {
+            kahanAdd(sum, compensation, values[i]);
+        }
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+
+    size_t nanCount = 0;
+    size_t positiveInfinityCount = 0;
+    size_t negativeInfinityCount = 0;
+    for (i = 0; special && i < count; ++i) {
+        if (std::isnan(values[i]))
+            ++nanCount;
+        else if (values[i] == infinity)
+            ++positiveInfinityCount;
+        else if (values[i] == -infinity)
+            ++negativeInfinityCount;
+    }
+    const size_t finiteCount = count - nanCount - positiveInfinityCount - negativeInfinityCount;
+    const double mean = finiteCount > 0 ? sum / finiteCount : 0;
+
+    double m2 = 0;
+    i = 0;
+#ifdef STATISTICS_USE_SSE2
+    const __m128d meanLanes = _mm_set1_pd(mean);
+    __m128d m2Lanes = zero;
+    for (; i + 2 <= count; i += 2) {
+        const __m128d v = _mm_loadu_pd(values + i);
+        const __m128d finite = _mm_cmpeq_pd(_mm_sub_pd(v, v), zero);
+        const __m128d d = _mm_and_pd(finite, _mm_sub_pd(v, meanLanes));
+        m2Lanes = _mm_add_pd(m2Lanes, _mm_mul_pd(d, d));
+    }
+    _mm_storeu_pd(lanes, m2Lanes);
+    m2 = lanes[0] + lanes[1];
+#endif
+    for (; i < count; ++i) {
+        if (!std::isfinite(values[i]))
+            continue;
+        const double d = values[i] - mean;
+        m2 += d * d;
+    }
+
+    result.sum = sum;
+    result.mean = mean;
+    result.min = min;
+    result.max = max;
+    result.standardDeviation = sampleStandardDeviation(m2, finiteCount);
+    applySpecialValues(result, count, nanCount, positiveInfinityCount, negativeInfinityCount);
+    return result;
+}
+} // namespace core
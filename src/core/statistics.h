@@ -0,0 +1,65 @@
+#ifndef CORE_STATISTICS_H
+#define CORE_STATISTICS_H
+
+#include <cstddef>
+#include <deque>
+#include <set>
+
+namespace core {
+struct StatisticsSummary
+{
+    size_t count = 0;
+    double sum = 0;
+    double mean = 0;
+    double min = 0;
+    double max = 0;
+    double standardDeviation = 0;
+};
+
+// Aggregates over a FIFO window of values: values are added at the back and removed from the
+// front, and any value in the window can be replaced, each in O(log n). The sum is Kahan
+// compensated, mean and variance use Welford's update, which also takes a value back out, and
+// min/max come from an ordered multiset of the values that are not NaN. Infinities and NaN are
+// only counted, so that one "1/0=" line turns the summary into what IEEE arithmetic gives while
+// it is in the window and leaves the sums intact once it is evicted or edited away. Taking a
+// value back out cannot restore the low bits that a much larger one rounded away, so the sums
+// are recomputed from the window once its largest magnitude drops far below the largest one
+// added since.
+class RunningStatistics
+{
+public:
+    void push(double value);
+    void popFront();
+    // Replaces the value at index, counted from the front of the window.
+    void replace(size_t index, double value);
+    void clear();
+
+    size_t count() const { return _window.size(); }
+    StatisticsSummary summary() const;
+
+private:
+    void addValue(double value);
+    // Adds a finite value to the sums.
+    void accumulate(double value);
+    void removeValue(double value);
+    void recomputeIfCancelled();
+
+    std::deque<double> _window;
+    std::multiset<double> _ordered;
+    size_t _finiteCount = 0;
+    size_t _nanCount = 0;
+    size_t _positiveInfinityCount = 0;
+    size_t _negativeInfinityCount = 0;
+    double _sum = 0;
+    double _compensation = 0;
+    double _mean = 0;
+    double _m2 = 0;
+    double _magnitude = 0;
+};
+
+// Recomputes the aggregates of an arbitrary set of values in two vectorized passes, with the
+// same treatment of infinities and NaN as RunningStatistics.
+StatisticsSummary computeStatistics(const double* values, size_t count);
+} // namespace core
+
+#endif // CORE_STATISTICS_H
@@ -1,9 +1,14 @@
+#include <cmath>
 #include <memory>
 #include <algorithm>
+#include <iterator>
+#include <limits>
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QPainterPath>
 #include <QtMath>
+#include <QtNumeric>
 #include <QRandomGenerator>
 #include <QPointer>
 #include <QPushButton>
@@ -18,13 +23,33 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QKeyEvent>
+#include <QMouseEvent>
+#include <QLineEdit>
+#include <QInputDialog>
+#include <QTimer>
+#include <QtConcurrent>
 
+#include "core/number_text.h"
 #include "display.h"
+#include "frame_scheduler.h"
+#include "memory_panel.h"
 #include "menu.h"
+#include "plot_panel.h"
+#include "statistics_panel.h"
+#include "text_width_cache.h"
+
+extern const QString g_multiply;
+extern const QString g_divide;
 
 namespace {
 constexpr int g_bigPointSize = 48;
 constexpr int g_smallPointSize = 20;
+// The last line takes the largest point size that keeps it within this width.
+constexpr int g_lastLineWidth = 360;
+// Time a frame spends laying out new lines, the rest are left to the following frames.
+constexpr qint64 g_layoutSliceMs = 8;
+// Appending at least this many lines measures their text on the thread pool first.
+constexpr int g_backgroundMeasuredLines = 4;
 
 const QString g_fontFamily("Arial");
 constexpr int g_bigFontWidgetHeight = 76;
@@ -32,25 +57,132 @@ constexpr int g_smallFontWidgetHeight = 36;
 
 constexpr int g_animationDuration = 300;
 
-constexpr int g_hChannelUpperBound = 361;
+// Consecutive palette indices step around the hue circle by the golden angle, which keeps any
+// number of them as far apart as possible.
+constexpr double g_goldenAngle = 137.50776405003785;
+constexpr int g_hueCount = 360;
 constexpr int g_sChannel = 92;
 constexpr int g_lChannel = 158;
 constexpr double g_connectionLineWidth = 1.6;
 constexpr QColor g_displayTextColor(38, 39, 42);
 constexpr QColor g_historyTextColor(90, 90, 90);
+constexpr QColor g_errorTextColor(192, 57, 43);
+// Matched parentheses cycle through these by nesting depth.
+constexpr QColor g_parenthesisColors[] = {QColor(41, 98, 255), QColor(0, 137, 123),
+                                          QColor(142, 36, 170), QColor(230, 115, 0)};
+constexpr QColor g_selectionColor(225, 235, 248);
 
 constexpr QSize g_menuButtonSize(34, 30);
 constexpr QPoint g_menuButtonPos(4, 3);
 const QString g_menuButtonFileName(":/Button/menu_hamburger.png");
 
+// A collapsed column shows its first row and the number of rows, an expanded one its first
+// rows, one per line.
+constexpr size_t g_expandedColumnRows = 10;
+const QString g_columnSummary("%1 …×%2");
+const QString g_columnMore("… %1 more");
+const QString g_columnToolTip("%1 values, click to expand or collapse");
+
 constexpr QChar g_minusSign = '-';
 constexpr QChar g_leftParenthesis = '(';
 constexpr QChar g_rightParenthesis = ')';
 
+// The font of element displays at pointSize, also used to measure their text off the GUI thread.
+QFont elementFont(int pointSize)
+{
+    QFont font(g_fontFamily, pointSize);
+    font.setStyleStrategy(QFont::PreferAntialias);
+    return font;
+}
+
+QColor clusterColor(int paletteIndex)
+{
+    if (paletteIndex < 0)
+        return QColor();
+    const int hue = int(std::fmod(paletteIndex * g_goldenAngle, g_hueCount));
+    return QColor::fromHsl(hue, g_sChannel, g_lChannel);
+}
+
+QString columnText(const std::vector<double>& column, bool expanded)
+{
+    const auto rowText = [](double value) {
+        return QString::fromStdString(core::formatNumber(value));
+    };
+    if (!expanded)
+        return g_columnSummary.arg(rowText(column.front())).arg(column.size());
+    const size_t shown = std::min(column.size(), g_expandedColumnRows);
+    QStringList rows;
+    for (size_t row = 0; row < shown; ++row)
+        rows << rowText(column[row]);
+    if (column.size() > shown)
+        rows << g_columnMore.arg(column.size() - shown);
+    return rows.join(QChar('\n'));
+}
+
+// The text a display shows for element: the summary or rows of a column, a negative number in
+// parentheses.
+QString elementText(const Element* element, bool columnExpanded)
+{
+    if (!element)
+        return QString();
+    const auto* number = dynamic_cast<const Number*>(element);
+    if (number && number->column())
+        return columnText(*number->column(), columnExpanded);
+    const QString text = element->text();
+    if (text.size() > 1 && text[0] == g_minusSign)
+        return g_leftParenthesis % text % g_rightParenthesis;
+    return text;
+}
+
 constexpr int g_elementRectDX = 1;
 constexpr int g_elementRectDY = -2;
+
+QString statusDescription(core::Status status)
+{
+    switch (status) {
+    case core::Status::Ok:
+        break;
+    case core::Status::DivisionByZero:
+        return QStringLiteral("Division by zero");
+    case core::Status::Overflow:
+        return QStringLiteral("Overflow");
+    case core::Status::Invalid:
+        return QStringLiteral("Invalid operation");
+    }
+    return QString();
+}
 constexpr int g_elementRectRadius = 2;
 
+constexpr int g_searchBoxSpacing = 4;
+const QString g_searchPlaceholder("=value, low..high or text");
+const QString g_rangeSeparator("..");
+const QString g_editNumberTitle("Edit number");
+const QString g_editNumberLabel("New value:");
+
+// "=v" matches a value, "low..high" a range with optional bounds, anything else a substring.
+std::vector<size_t> findMatches(const HistoryIndex& index, QString query)
+{
+    bool ok = false;
+    if (query.startsWith(QChar('='))) {
+        const double value = query.mid(1).toDouble(&ok);
+        return ok ? index.findValue(value) : std::vector<size_t>();
+    }
+    const int separator = query.indexOf(g_rangeSeparator);
+    if (separator >= 0) {
+        const QString lowText = query.left(separator).trimmed();
+        const QString highText = query.mid(separator + g_rangeSeparator.size()).trimmed();
+        bool lowOk = true;
+        bool highOk = true;
+        const double low = lowText.isEmpty() ? -qInf() : lowText.toDouble(&lowOk);
+        const double high = highText.isEmpty() ? qInf() : highText.toDouble(&highOk);
+        if (lowOk && highOk)
+            return index.findRange(low, high);
+    }
+    query.replace(QChar('*'), g_multiply);
+    query.replace(QChar('/'), g_divide);
+    return index.findText(query);
+}
+
 QLayoutItem* lastItemInLayout(QLayout* layout)
 {
     if (!layout)
@@ -65,39 +197,37 @@ QLayoutItem* takeLastItemInLayout(QLayout* layout)
     return layout->takeAt(layout->count() - 1);
 }
 
-int widgetsWidth(QLayout* layout)
+void setLineFontSize(QLayout* layout, int pointSize)
 {
-    int totalWidth = 0;
-    for (int c = 0; c < layout->count(); ++c) {
-        totalWidth += layout->itemAt(c)->widget()->width();
-    }
-    return totalWidth;
-}
-
-bool changeWidgetsWidthBy(QLayout* layout, int change)
-{
-    QFont font = static_cast<ElementDisplay*>(layout->itemAt(0)->widget())->font();
-    font.setPointSize(font.pointSize() + change);
-    if (font.pointSize() > g_bigPointSize || font.pointSize() < g_smallPointSize) {
-        return false;
-    }
-
     for (int c = 0; c < layout->count(); ++c) {
         auto* display = static_cast<ElementDisplay*>(layout->itemAt(c)->widget());
+        QFont font = display->font();
+        font.setPointSize(pointSize);
         display->setFont(font);
         display->adjustSize();
         display->updateGeometry();
     }
-    return true;
+}
+
+qint64 pathElementBytes(const QPainterPath& path)
+{
+    return qint64(path.elementCount()) * qint64(sizeof(QPainterPath::Element));
 }
 } // namespace
 
 ElementPath::ElementPath(ElementDisplay* start, ElementDisplay* end, QObject* parent)
     : QObject(parent), _start(start), _end(end)
 {
+    accountConstruction(MemoryCategory::ElementPaths, objectBytes(sizeof(ElementPath)));
     update();
 }
 
+ElementPath::~ElementPath()
+{
+    accountDestruction(MemoryCategory::ElementPaths,
+                       objectBytes(sizeof(ElementPath)) + pathElementBytes(*this));
+}
+
 QPointF ElementPath::startPoint() const
 {
     if (!_start)
@@ -114,6 +244,7 @@ QPointF ElementPath::endPoint() const
 
 void ElementPath::update()
 {
+    const qint64 elementBytes = pathElementBytes(*this);
     clear();
     const QPointF startP = startPoint();
     const QPointF endP = endPoint();
@@ -128,17 +259,21 @@ void ElementPath::update()
     const QPointF c1(startP.x() + directionModifier * offsetX, startP.y() + offsetY);
     const QPointF c2(endP.x() - directionModifier * offsetX, endP.y() - offsetY);
     cubicTo(c1, c2, endP);
+    accountResize(MemoryCategory::ElementPaths, pathElementBytes(*this) - elementBytes);
 }
 
 QColor ElementPath::color() const
 {
     if (!_start)
         return {};
-    return *(_start->connectColor());
+    return _start->connectColor();
 }
 
-Display::Display(QWidget* parent) : QWidget(parent)
+Display::Display(QWidget* parent) : QWidget(parent), _frameScheduler(new FrameScheduler(this))
 {
+    connect(_frameScheduler, &FrameScheduler::frame, this, &Display::applyPendingChanges);
+    connect(&_measurement, &QFutureWatcherBase::finished, _frameScheduler,
+            &FrameScheduler::requestFrame);
     auto* vLayout = new QVBoxLayout(this);
     vLayout->setAlignment(Qt::AlignBottom);
     setLayout(vLayout);
@@ -149,108 +284,237 @@ void Display::setEquations(const std::shared_ptr<EquationQueue>& equations)
 {
     if (_equations == equations)
         return;
-    if (_equations.get())
-        disconnect(_equations.get(), &EquationQueue::changed, this,
-                   &Display::alignElementDisplayContent);
+    if (_equations.get()) {
+        disconnect(_equations.get(), &EquationQueue::changed, this, &Display::scheduleAlignment);
+        disconnect(_equations.get(), &EquationQueue::linesEdited, this,
+                   &Display::scheduleEditedLines);
+    }
     _equations = equations;
-    connect(_equations.get(), &EquationQueue::changed, this, &Display::alignElementDisplayContent);
+    _firstLineId = _equations->firstId();
+    _editedLines.clear();
+    connect(_equations.get(), &EquationQueue::changed, this, &Display::scheduleAlignment);
+    connect(_equations.get(), &EquationQueue::linesEdited, this, &Display::scheduleEditedLines);
+    scheduleAlignment();
 }
 
-void Display::alignElementDisplayContent()
+// Queue notifications only mark the display dirty, the layout follows at the next frame.
+void Display::scheduleAlignment()
 {
-    bool newLineAdded = false;
-    if (_equations->size() > layout()->count()) {
-        if (!layout()->isEmpty()) {
-            auto* const lastLineOfLayout = lastItemInLayout(layout())->layout();
-            for (int i = 0; i < lastLineOfLayout->count(); ++i) {
-                auto* display =
-                    dynamic_cast<ElementDisplay*>(lastLineOfLayout->itemAt(i)->widget());
-                if (!display)
-                    continue;
-                display->show();
-                QFont font = display->font();
-                font.setPointSize(g_smallPointSize);
-                display->setFont(font);
-                QPalette palette = this->palette();
-                palette.setColor(QPalette::WindowText, g_historyTextColor);
-                display->setPalette(palette);
-                display->setFixedHeight(g_smallFontWidgetHeight);
-            }
-        }
-        auto* lineLayout = new QHBoxLayout(this);
-        lineLayout->setAlignment(Qt::AlignRight);
-        layout()->addItem(lineLayout);
-        newLineAdded = true;
-    }
-    while (_equations->size() < layout()->count()) {
-        auto* const lastLineItem = takeLastItemInLayout(layout());
-        while (auto* lastItem = takeLastItemInLayout(lastLineItem->layout())) {
-            delete lastItem->widget();
-            delete lastItem;
-        }
-        delete lastLineItem->layout();
-    }
+    _alignmentPending = true;
+    measureNewLines();
+    _frameScheduler->requestFrame();
+}
+
+void Display::scheduleEditedLines(const std::vector<size_t>& ids)
+{
+    _editedLines.insert(_editedLines.end(), ids.begin(), ids.end());
+    _frameScheduler->requestFrame();
+}
 
-    if (_equations->empty() && layout()->count() == 0) {
-        adjustElementsDisplayGeo(newLineAdded);
-        update();
+// Lines appended in bulk have their text measured on the thread pool, in the fonts of the
+// history and every size the last line may take, while the frames keep showing the previous
+// layout; the layout then finds the widths in textWidthCache().
+void Display::measureNewLines()
+{
+    if (_measurement.isRunning())
+        return;
+    // The previous last line may have changed, the lines after it are new. Without lines laid
+    // out yet, all of them are.
+    size_t first = 0;
+    if (layout()->count() > 0) {
+        const size_t firstNewId = _firstLineId + size_t(layout()->count()) - 1;
+        const size_t firstId = _equations->firstId();
+        first = firstNewId > firstId ? firstNewId - firstId : 0;
+    }
+    if (first + g_backgroundMeasuredLines > _equations->size())
         return;
+    QStringList historyTexts;
+    QStringList lastLineTexts;
+    for (size_t r = first; r < _equations->size(); ++r) {
+        QStringList& texts = r + 1 < _equations->size() ? historyTexts : lastLineTexts;
+        for (const auto& element : (*_equations)[r])
+            texts << elementText(element.get(), false);
     }
+    _measurement.setFuture(QtConcurrent::run([historyTexts, lastLineTexts] {
+        TextWidthCache& cache = textWidthCache();
+        QFont measured = elementFont(g_smallPointSize);
+        for (const QString& text : historyTexts)
+            cache.width(measured, text);
+        for (int size = g_smallPointSize; size <= g_bigPointSize; ++size) {
+            measured.setPointSize(size);
+            for (const QString& text : lastLineTexts)
+                cache.width(measured, text);
+        }
+    }));
+}
 
-    const auto& equation = _equations->back();
-    auto* lastLineLayout = static_cast<QHBoxLayout*>(lastItemInLayout(layout())->layout());
-    while (equation.size() < lastLineLayout->count()) {
-        auto* display = takeLastItemInLayout(lastLineLayout);
-        delete display->widget();
-        delete display;
-    }
-    if (equation.empty()) {
-        lastLineLayout->insertWidget(-1, new ElementDisplay(this));
-        adjustElementsDisplayGeo(newLineAdded);
-        update();
+// The alignment catches up with appends and evictions first, so that the edited lines are
+// looked up in the current layout. New lines are laid out in slices of g_layoutSliceMs, one per
+// frame, once their text is measured.
+void Display::applyPendingChanges()
+{
+    applyChanges(g_layoutSliceMs);
+}
+
+void Display::finishPendingChanges()
+{
+    _frameScheduler->flush();
+    if (!_alignmentPending && _editedLines.empty())
+        return;
+    _measurement.waitForFinished();
+    applyChanges(std::numeric_limits<qint64>::max());
+}
+
+void Display::applyChanges(qint64 budgetMs)
+{
+    if (!_equations)
         return;
+    if (_alignmentPending) {
+        // The end of the measurement requests the next frame.
+        if (_measurement.isRunning())
+            return;
+        _alignmentPending = !alignElementDisplayContent(budgetMs);
+        if (_alignmentPending) {
+            _frameScheduler->requestFrame();
+            return;
+        }
     }
-    for (int i = std::max(int(equation.size()) - 2, 0); i < equation.size(); ++i) {
-        if (i >= lastLineLayout->count()) {
-            auto* display = new ElementDisplay(this, equation[i].get());
-            if (lastLineLayout->count() > 0) {
-                display->setFont(
-                    static_cast<ElementDisplay*>(lastItemInLayout(lastLineLayout)->widget())
-                        ->font());
-            }
-            display->show();
-            lastLineLayout->addWidget(display);
-        } else {
-            static_cast<ElementDisplay*>(lastItemInLayout(lastLineLayout)->widget())
-                ->setElement(equation[i].get());
+    if (!_editedLines.empty()) {
+        std::sort(_editedLines.begin(), _editedLines.end());
+        _editedLines.erase(std::unique(_editedLines.begin(), _editedLines.end()),
+                           _editedLines.end());
+        std::vector<size_t> ids;
+        ids.swap(_editedLines);
+        refreshEditedLines(ids);
+    }
+}
+
+bool Display::alignElementDisplayContent(qint64 budgetMs)
+{
+    QElapsedTimer slice;
+    slice.start();
+    // Lines of equations evicted from the front of the queue (or dropped by a clear) go first,
+    // then every equation appended since the last alignment gets its own line.
+    const size_t firstId = _equations->firstId();
+    int evictedLines = int(std::min<size_t>(firstId - _firstLineId, layout()->count()));
+    _firstLineId = firstId;
+    if (_firstUnalignedLine >= 0)
+        _firstUnalignedLine = std::max(_firstUnalignedLine - evictedLines, 0);
+    while (evictedLines-- > 0)
+        removeLine(0);
+    while (int(_equations->size()) < layout()->count())
+        removeLine(layout()->count() - 1);
+
+    // Typing only edits the previous last line, older lines edited through editNumber() are
+    // refreshed by refreshEditedLines().
+    const int firstChangedLine = std::max(layout()->count() - 1, 0);
+    _firstUnalignedLine = _firstUnalignedLine >= 0
+                              ? std::min(_firstUnalignedLine, firstChangedLine)
+                              : firstChangedLine;
+    const int lineCount = int(_equations->size());
+    for (int r = firstChangedLine; r < lineCount; ++r) {
+        if (r >= layout()->count()) {
+            auto* lineLayout = new QHBoxLayout();
+            lineLayout->setAlignment(Qt::AlignRight);
+            static_cast<QVBoxLayout*>(layout())->addLayout(lineLayout);
+        }
+        auto* line = layout()->itemAt(r)->layout();
+        syncLine(line, (*_equations)[r]);
+        if (r + 1 < lineCount) {
+            setLineAsHistory(line);
+            if (slice.elapsed() >= budgetMs)
+                return false;
         }
     }
 
-    adjustLastLineFontSize();
-    adjustElementsDisplayGeo(newLineAdded);
+    if (lineCount > 0)
+        adjustLastLineFontSize();
+    adjustElementsDisplayGeo(std::min(_firstUnalignedLine, layout()->count()));
+    _firstUnalignedLine = -1;
+    updateSelectionDisplay();
+    applyFilter();
     update();
+    emit linesChanged();
+    return true;
+}
+
+void Display::removeLine(int index)
+{
+    auto* const lineItem = layout()->takeAt(index);
+    while (auto* item = takeLastItemInLayout(lineItem->layout())) {
+        delete item->widget();
+        delete item;
+    }
+    delete lineItem->layout();
+}
+
+void Display::syncLine(QLayout* line, const Equation& equation)
+{
+    const int displayCount = std::max(int(equation.size()), 1);
+    while (line->count() > displayCount) {
+        auto* item = takeLastItemInLayout(line);
+        delete item->widget();
+        delete item;
+    }
+    // An empty equation still gets one empty display so that the line keeps its height.
+    for (int i = 0; i < displayCount; ++i) {
+        const Element* element = i < int(equation.size()) ? equation[i].get() : nullptr;
+        if (i < line->count()) {
+            static_cast<ElementDisplay*>(line->itemAt(i)->widget())->setElement(element);
+            continue;
+        }
+        auto* display = new ElementDisplay(this, const_cast<Element*>(element));
+        if (line->count() > 0)
+            display->setFont(static_cast<ElementDisplay*>(lastItemInLayout(line)->widget())->font());
+        display->show();
+        line->addWidget(display);
+    }
+}
+
+void Display::setLineAsHistory(QLayout* line)
+{
+    for (int i = 0; i < line->count(); ++i) {
+        auto* display = dynamic_cast<ElementDisplay*>(line->itemAt(i)->widget());
+        if (!display)
+            continue;
+        display->show();
+        QFont font = display->font();
+        font.setPointSize(g_smallPointSize);
+        display->setFont(font);
+        display->setTextColor(g_historyTextColor);
+        display->setLineHeight(g_smallFontWidgetHeight);
+    }
 }
 
+// The largest point size whose line fits g_lastLineWidth, or the smallest when none does,
+// found by bisection over widths from textWidthCache() before the font is set once.
 void Display::adjustLastLineFontSize()
 {
     auto* lastLineLayout = static_cast<QHBoxLayout*>(lastItemInLayout(layout())->layout());
     if (!lastLineLayout || lastLineLayout->count() == 0)
         return;
-    int totalWidth = widgetsWidth(lastLineLayout);
-    while (totalWidth < 360) {
-        if (!changeWidgetsWidthBy(lastLineLayout, 1))
-            break;
-        totalWidth = widgetsWidth(lastLineLayout);
-    }
-
-    while (totalWidth > 360) {
-        if (!changeWidgetsWidthBy(lastLineLayout, -1))
-            break;
-        totalWidth = widgetsWidth(lastLineLayout);
+    QFont font = static_cast<ElementDisplay*>(lastLineLayout->itemAt(0)->widget())->font();
+    const auto lineWidth = [&](int pointSize) {
+        font.setPointSize(pointSize);
+        int width = 0;
+        for (int c = 0; c < lastLineLayout->count(); ++c)
+            width += static_cast<ElementDisplay*>(lastLineLayout->itemAt(c)->widget())
+                         ->widthFor(font);
+        return width;
+    };
+    int low = g_smallPointSize;
+    int high = g_bigPointSize;
+    while (low < high) {
+        const int middle = (low + high + 1) / 2;
+        if (lineWidth(middle) <= g_lastLineWidth)
+            low = middle;
+        else
+            high = middle - 1;
     }
+    setLineFontSize(lastLineLayout, low);
 }
 
-void Display::adjustElementsDisplayGeo(bool newLineAdded)
+void Display::adjustElementsDisplayGeo(int firstChangedLine)
 {
     for (int i = 0; i < layout()->count(); ++i) {
         auto* line = layout()->itemAt(i)->layout();
@@ -264,22 +528,20 @@ void Display::adjustElementsDisplayGeo(bool newLineAdded)
             }
         }
     }
-    updateConnectionForSecondLastLine();
+    for (int r = std::max(firstChangedLine, 1); r < layout()->count(); ++r)
+        updateConnectionToLine(r);
 }
 
-void Display::updateConnectionForSecondLastLine()
+void Display::updateConnectionToLine(int lineIndex)
 {
-    const int displayLineCount = layout()->count();
-    if (displayLineCount < 2)
-        return;
-    auto* secondLastLine = layout()->itemAt(displayLineCount - 2)->layout();
+    auto* secondLastLine = layout()->itemAt(lineIndex - 1)->layout();
     for (int column = 0; column < secondLastLine->count(); ++column) {
         auto* display = dynamic_cast<ElementDisplay*>(secondLastLine->itemAt(column)->widget());
         if (!display)
             continue;
         display->clearAllNext();
     }
-    auto* lastLine = layout()->itemAt(displayLineCount - 1)->layout();
+    auto* lastLine = layout()->itemAt(lineIndex)->layout();
     for (int column = secondLastLine->count() - 1; column >= 0; --column) {
         auto* const displayFromPreviousLine =
             dynamic_cast<ElementDisplay*>(secondLastLine->itemAt(column)->widget());
@@ -297,8 +559,10 @@ void Display::updateConnectionForSecondLastLine()
             const auto* lastLineElement = dynamic_cast<const Number*>(lastLineDisplay->element());
 
             if (lastLineElement && !lastLineDisplay->_previous &&
-                (*previousLineElement) == (*lastLineElement)) {
-                displayFromPreviousLine->addNext(lastLineDisplay);
+                ValueClusters::sameValue(previousLineElement->value(), lastLineElement->value())) {
+                const int paletteIndex =
+                    _equations->valueClusters().paletteIndex(lastLineElement->value());
+                displayFromPreviousLine->addNext(lastLineDisplay, clusterColor(paletteIndex));
             }
         }
     }
@@ -311,8 +575,10 @@ void Display::regeneratePaths()
         auto* line = layout()->itemAt(r)->layout();
         for (int c = 0; c < line->count(); ++c) {
             auto* display = dynamic_cast<ElementDisplay*>(line->itemAt(c)->widget());
+            if (display->isHidden())
+                continue;
             for (const auto& next : display->nexts()) {
-                if (!next)
+                if (!next || next->isHidden())
                     continue;
                 addPath(display, next);
             }
@@ -322,11 +588,6 @@ void Display::regeneratePaths()
 
 void Display::addPath(ElementDisplay* one, ElementDisplay* other)
 {
-    if (!one->connectColor()->isValid()) {
-        one->connectColor()->setHsl(
-            (std::hash<double>{}(static_cast<const Number*>(one->element())->value()) % g_hChannelUpperBound),
-            g_sChannel, g_lChannel);
-    }
     _paths.emplace_back(std::make_unique<ElementPath>(one, other, this));
 }
 
@@ -352,6 +613,178 @@ void Display::resizeEvent(QResizeEvent* event)
     QWidget::resizeEvent(event);
 }
 
+// Selects lines while the statistics are shown, otherwise expands and collapses columns.
+void Display::mousePressEvent(QMouseEvent* event)
+{
+    if (!_equations)
+        return QWidget::mousePressEvent(event);
+    if (!_selectionEnabled) {
+        auto* const target = dynamic_cast<ElementDisplay*>(childAt(event->position().toPoint()));
+        if (!target || !target->showsColumn())
+            return QWidget::mousePressEvent(event);
+        finishPendingChanges();
+        toggleColumns(target);
+        return;
+    }
+    finishPendingChanges();
+    const QPoint pos = event->position().toPoint();
+    for (int r = 0; r < layout()->count() && r < int(_equations->size()); ++r) {
+        auto* line = layout()->itemAt(r)->layout();
+        if (!line || !line->geometry().contains(pos))
+            continue;
+        if (!(*_equations)[r].completed())
+            break;
+        const size_t id = _equations->firstId() + r;
+        if (_selection.erase(id) == 0)
+            _selection.insert(id);
+        updateSelectionDisplay();
+        emit selectionChanged();
+        return;
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void Display::toggleColumns(ElementDisplay* target)
+{
+    const bool expanded = !target->columnExpanded();
+    for (int r = 0; r < layout()->count(); ++r) {
+        auto* line = layout()->itemAt(r)->layout();
+        if (!line || line->indexOf(target) < 0)
+            continue;
+        for (int c = 0; c < line->count(); ++c) {
+            if (auto* display = dynamic_cast<ElementDisplay*>(line->itemAt(c)->widget()))
+                display->setColumnExpanded(expanded);
+        }
+        line->invalidate();
+        break;
+    }
+    update();
+}
+
+// Numbers before "=" of completed lines can be edited, the lines continuing from the edited
+// result are recomputed by the queue.
+void Display::mouseDoubleClickEvent(QMouseEvent* event)
+{
+    auto* const target = dynamic_cast<ElementDisplay*>(childAt(event->position().toPoint()));
+    if (!_equations || !target)
+        return QWidget::mouseDoubleClickEvent(event);
+    finishPendingChanges();
+    for (int r = 0; r < layout()->count() && r < int(_equations->size()); ++r) {
+        auto* line = layout()->itemAt(r)->layout();
+        const int column = line ? line->indexOf(target) : -1;
+        if (column < 0)
+            continue;
+        const Equation& equation = (*_equations)[r];
+        if (!equation.completed() || column + 2 >= int(equation.size()) ||
+            !dynamic_cast<const Number*>(equation[column].get()))
+            break;
+        const size_t id = _equations->firstId() + r;
+        bool ok = false;
+        const QString text = QInputDialog::getText(this, g_editNumberTitle, g_editNumberLabel,
+                                                   QLineEdit::Normal, equation[column]->text(), &ok);
+        if (ok)
+            _equations->editNumber(id, size_t(column), text.trimmed());
+        return;
+    }
+    QWidget::mouseDoubleClickEvent(event);
+}
+
+// The elements of edited lines were updated in place and their displays follow them, only the
+// geometry and the connections to the neighbouring lines are left to redo.
+void Display::refreshEditedLines(const std::vector<size_t>& ids)
+{
+    const size_t firstId = _equations->firstId();
+    for (const size_t id : ids) {
+        const int r = int(id - firstId);
+        if (id < firstId || r >= layout()->count())
+            continue;
+        auto* line = layout()->itemAt(r)->layout();
+        syncLine(line, (*_equations)[r]);
+        if (r + 1 < layout()->count())
+            setLineAsHistory(line);
+        for (int c = 0; c < line->count(); ++c)
+            line->itemAt(c)->widget()->adjustSize();
+        if (r > 0)
+            updateConnectionToLine(r);
+        if (r + 1 < layout()->count())
+            updateConnectionToLine(r + 1);
+    }
+    update();
+}
+
+void Display::setArithmetic(core::Arithmetic arithmetic)
+{
+    if (_equations)
+        _equations->setArithmetic(arithmetic);
+}
+
+void Display::setBase(core::Base base)
+{
+    if (_equations)
+        _equations->setBase(base);
+}
+
+void Display::setSelectionEnabled(bool enabled)
+{
+    if (_selectionEnabled == enabled)
+        return;
+    _selectionEnabled = enabled;
+    if (!enabled && !_selection.empty()) {
+        _selection.clear();
+        updateSelectionDisplay();
+        emit selectionChanged();
+    }
+}
+
+void Display::updateSelectionDisplay()
+{
+    const size_t firstId = _equations ? _equations->firstId() : 0;
+    const bool pruned = !_selection.empty() && *_selection.begin() < firstId;
+    _selection.erase(_selection.begin(), _selection.lower_bound(firstId));
+    for (int r = 0; r < layout()->count(); ++r) {
+        auto* line = layout()->itemAt(r)->layout();
+        if (!line)
+            continue;
+        const bool selected = _selection.count(firstId + r) > 0;
+        for (int c = 0; c < line->count(); ++c) {
+            if (auto* display = dynamic_cast<ElementDisplay*>(line->itemAt(c)->widget()))
+                display->setSelected(selected);
+        }
+    }
+    if (pruned)
+        emit selectionChanged();
+}
+
+void Display::setFilter(const QString& query)
+{
+    const QString trimmed = query.trimmed();
+    if (_filterQuery == trimmed)
+        return;
+    _filterQuery = trimmed;
+    finishPendingChanges();
+    applyFilter();
+    update();
+}
+
+void Display::applyFilter()
+{
+    const bool active = _equations && !_filterQuery.isEmpty();
+    const std::vector<size_t> matches =
+        active ? findMatches(_equations->index(), _filterQuery) : std::vector<size_t>();
+    const size_t firstId = _equations ? _equations->firstId() : 0;
+    for (int r = 0; r < layout()->count(); ++r) {
+        auto* line = layout()->itemAt(r)->layout();
+        if (!line)
+            continue;
+        const bool visible = !active || r == layout()->count() - 1 ||
+                             std::binary_search(matches.begin(), matches.end(), firstId + r);
+        for (int c = 0; c < line->count(); ++c) {
+            if (auto* widget = line->itemAt(c)->widget())
+                widget->setVisible(visible);
+        }
+    }
+}
+
 void Display::drawPaths()
 {
     QPainter painter(this);
@@ -366,24 +799,9 @@ void Display::drawPaths()
 
 void Display::pasteAllResults() const
 {
-    QString result;
-
-    for (int r = 0; r < layout()->count(); ++r) {
-        auto* line = layout()->itemAt(r)->layout();
-        assert(line);
-        for (int c = 0; c < line->count(); ++c) {
-            auto* display = static_cast<ElementDisplay*>(line->itemAt(c)->widget());
-            assert(display);
-
-            result.append(display->text());
-            if (display) {
-                display->updateGeometry();
-                display->show();
-            }
-        }
-        result.append('\n');
-    }
-    result = result.trimmed();
+    if (!_equations)
+        return;
+    const QString result = _equations->text().trimmed();
     if (result.size() > 0)
         QApplication::clipboard()->setText(result);
 }
@@ -398,19 +816,16 @@ void Display::toggleConnection(bool show)
 
 void Display::clearAllHistory()
 {
-    if (!_equations->empty()) {
+    if (!_equations->empty())
         _equations->clear();
-        emit _equations->changed();
-    }
 }
 
-ScrollDisplay::ScrollDisplay(QWidget* parent) : QScrollArea(parent)
+ScrollDisplay::ScrollDisplay(QWidget* parent) : QScrollArea(parent), _display(new Display(this))
 {
-    auto* display = new Display(this);
-    setWidget(display);
+    setWidget(_display);
     setWidgetResizable(true);
     setAlignment(Qt::AlignLeft | Qt::AlignBottom);
-    display->installEventFilter(this);
+    _display->installEventFilter(this);
 
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -419,35 +834,78 @@ ScrollDisplay::ScrollDisplay(QWidget* parent) : QScrollArea(parent)
     connect(horizontalScrollBar(), &QScrollBar::rangeChanged, this, &ScrollDisplay::setBarToMax);
     connect(verticalScrollBar(), &QScrollBar::rangeChanged, this, &ScrollDisplay::setBarToMax);
 
-    _menu = new Menu(this);
-    connect(_menu, &Menu::copyButtonClicked, display, &Display::pasteAllResults);
-    connect(_menu, &Menu::connectionButtonToggled, display, &Display::toggleConnection);
-    connect(_menu, &Menu::clearButtonClicked, display, &Display::clearAllHistory);
-    _menu->move(-_menu->width(), _menu->y());
-
-    _animation = new QPropertyAnimation(_menu, "pos", this);
-    _animation->setDuration(g_animationDuration);
-    _animation->setEasingCurve(QEasingCurve::InOutQuad);
-    toggleMenu(false);
-
     _menuButton = new QToolButton(this);
     _menuButton->setIcon(QIcon(g_menuButtonFileName));
-    _menuButton->setStyleSheet(_menu->styleSheet());
+    _menuButton->setStyleSheet(g_menuStyleSheet);
     _menuButton->setFixedSize(g_menuButtonSize);
     _menuButton->move(g_menuButtonPos);
     _menuButton->setCheckable(true);
     connect(_menuButton, &QPushButton::toggled, this, &ScrollDisplay::toggleMenu);
 
-    _menu->raise();
     _menuButton->raise();
     setStyleSheet(QStringLiteral("QScrollArea{border: none;}"));
 }
 
+void ScrollDisplay::createMenu()
+{
+    if (_menu)
+        return;
+    _menu = new Menu(this);
+    connect(_menu, &Menu::copyButtonClicked, _display, &Display::pasteAllResults);
+    connect(_menu, &Menu::connectionButtonToggled, _display, &Display::toggleConnection);
+    connect(_menu, &Menu::clearButtonClicked, _display, &Display::clearAllHistory);
+    _menu->move(-_menu->width(), _menu->y());
+
+    _statisticsPanel = new StatisticsPanel(_display, this);
+    _statisticsPanel->hide();
+    connect(_menu, &Menu::statisticsButtonToggled, _display, &Display::setSelectionEnabled);
+    connect(_menu, &Menu::statisticsButtonToggled, _statisticsPanel,
+            &StatisticsPanel::setVisible);
+    _plotPanel = new PlotPanel(_display, this);
+    _plotPanel->hide();
+    connect(_menu, &Menu::plotButtonToggled, _plotPanel, &PlotPanel::setVisible);
+    _memoryPanel = new MemoryPanel(_display, this);
+    _memoryPanel->hide();
+    connect(_menu, &Menu::memoryButtonToggled, _memoryPanel, &MemoryPanel::setVisible);
+    connect(_menu, &Menu::searchButtonToggled, this, &ScrollDisplay::toggleSearch);
+    connect(_menu, &Menu::arithmeticChanged, _display, &Display::setArithmetic);
+    connect(_menu, &Menu::baseChanged, _display, &Display::setBase);
+
+    _animation = new QPropertyAnimation(_menu, "pos", this);
+    _animation->setDuration(g_animationDuration);
+    _animation->setEasingCurve(QEasingCurve::InOutQuad);
+
+    _searchBox = new QLineEdit(this);
+    _searchBox->setPlaceholderText(g_searchPlaceholder);
+    _searchBox->setClearButtonEnabled(true);
+    _searchBox->setFixedHeight(g_menuButtonSize.height());
+    _searchBox->move(g_menuButtonPos.x() + g_menuButtonSize.width() + g_searchBoxSpacing,
+                     g_menuButtonPos.y());
+    _searchBox->hide();
+    connect(_searchBox, &QLineEdit::textChanged, _display, &Display::setFilter);
+
+    _menu->show();
+    raiseOverlays();
+}
+
+void ScrollDisplay::raiseOverlays()
+{
+    if (_menu) {
+        _menu->raise();
+        _menuButton->raise();
+        _statisticsPanel->raise();
+        _plotPanel->raise();
+        _memoryPanel->raise();
+        _searchBox->raise();
+        // Last, the copy button's bubble points at the menu from above the panels.
+        _menu->raiseBubble();
+    }
+}
+
 void ScrollDisplay::paintEvent(QPaintEvent* event)
 {
     QScrollArea::paintEvent(event);
-    _menu->raise();
-    _menuButton->raise();
+    raiseOverlays();
 }
 
 void ScrollDisplay::wheelEvent(QWheelEvent* event)
@@ -467,6 +925,13 @@ bool ScrollDisplay::eventFilter(QObject *watched, QEvent *event)
 {
     if (event->type() != QEvent::Paint)
         return false;
+    if (!_menu) {
+        if (!_menuScheduled) {
+            _menuScheduled = true;
+            QTimer::singleShot(0, this, &ScrollDisplay::createMenu);
+        }
+        return false;
+    }
     const auto* paintEvent = static_cast<QPaintEvent*>(event);
     const auto* watchedWidget = static_cast<QWidget*>(watched);
     const QRect updateRectInCurrentCoordinate = paintEvent->rect().translated(watchedWidget->pos());
@@ -482,8 +947,22 @@ void ScrollDisplay::setBarToMax()
     horizontalScrollBar()->setValue(horizontalScrollBar()->maximum());
 }
 
+void ScrollDisplay::toggleSearch(bool show)
+{
+    if (show) {
+        _searchBox->setFixedWidth(width() - _searchBox->x() - g_searchBoxSpacing);
+        _searchBox->show();
+        _searchBox->raise();
+        _searchBox->setFocus();
+    } else {
+        _searchBox->clear();
+        _searchBox->hide();
+    }
+}
+
 void ScrollDisplay::toggleMenu(bool show)
 {
+    createMenu();
     _animation->setStartValue(_menu->pos());
     _animation->setEndValue(QPoint(show ? 0 : -_menu->width(), _menu->y()));
     _animation->start();
@@ -491,28 +970,32 @@ void ScrollDisplay::toggleMenu(bool show)
 }
 
 ElementDisplay::ElementDisplay(QWidget* parent, Element* element, bool showConnection)
-    : QLabel(parent), _connectColor(std::make_shared<QColor>())
+    : QLabel(parent)
 {
+    accountConstruction(MemoryCategory::ElementDisplays, labelBytes(sizeof(ElementDisplay)));
     setElement(element);
     setMargin(2);
 
     setAlignment(Qt::AlignLeft | Qt::AlignCenter);
-    QFont font(g_fontFamily, g_bigPointSize);
-    font.setStyleStrategy(QFont::PreferAntialias);
-    setFont(font);
+    setFont(elementFont(g_bigPointSize));
 
-    QPalette palette = this->palette();
-    palette.setColor(QPalette::WindowText, g_displayTextColor);
-    setPalette(palette);
-    setFixedHeight(g_bigFontWidgetHeight);
+    setTextColor(g_displayTextColor);
+    setLineHeight(g_bigFontWidgetHeight);
 }
 
 void ElementDisplay::paintEvent(QPaintEvent* event)
 {
+    if (_selected) {
+        QPainter painter(this);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(g_selectionColor);
+        painter.drawRoundedRect(rect(), g_elementRectRadius, g_elementRectRadius);
+    }
     QLabel::paintEvent(event);
     if (_showConnections && (!_nexts.empty() || _previous)) {
         QPainter painter(this);
-        QPen pen(_connectColor == nullptr ? Qt::gray : *_connectColor, g_connectionLineWidth);
+        QPen pen(_connectColor.isValid() ? _connectColor : QColor(Qt::gray), g_connectionLineWidth);
         pen.setStyle(Qt::DashLine);
         painter.setPen(pen);
         painter.setRenderHint(QPainter::Antialiasing);
@@ -522,28 +1005,38 @@ void ElementDisplay::paintEvent(QPaintEvent* event)
     }
 }
 
+void ElementDisplay::changeEvent(QEvent* event)
+{
+    QLabel::changeEvent(event);
+    if (event->type() == QEvent::FontChange)
+        updateHeight();
+}
+
+ElementDisplay::~ElementDisplay()
+{
+    accountDestruction(MemoryCategory::ElementDisplays, labelBytes(sizeof(ElementDisplay)));
+}
+
 const Element* ElementDisplay::element() const { return _element; }
 
 void ElementDisplay::setElement(const Element* e)
 {
-    if (_element == e)
+    const uint64_t revision = e ? e->revision() : 0;
+    if (_element == e && _shownRevision == revision)
         return;
-    disconnect(e, &Element::changed, this, &ElementDisplay::updateElementText);
     _element = e;
+    _shownRevision = revision;
     updateElementText();
-    if (_element)
-        connect(_element, &Element::changed, this, &ElementDisplay::updateElementText);
 }
 
-void ElementDisplay::addNext(ElementDisplay* display)
+void ElementDisplay::addNext(ElementDisplay* display, const QColor& color)
 {
     if (!display)
         return;
     _nexts.push_back(display);
     display->_previous = this;
-    if (!_connectColor)
-        _connectColor = std::make_shared<QColor>();
-    display->_connectColor = _connectColor;
+    _connectColor = color;
+    display->_connectColor = color;
 }
 
 void ElementDisplay::clearAllNext()
@@ -551,25 +1044,103 @@ void ElementDisplay::clearAllNext()
     while (!_nexts.empty()) {
         if (_nexts.back()) {
             _nexts.back()->_previous = nullptr;
-            _nexts.back()->_connectColor.reset();
+            _nexts.back()->_connectColor = QColor();
         }
         _nexts.pop_back();
     }
 }
 
-void ElementDisplay::updateElementText()
+void ElementDisplay::setSelected(bool selected)
 {
-    if (!_element) {
-        setText("");
+    if (_selected == selected)
+        return;
+    _selected = selected;
+    update();
+}
+
+void ElementDisplay::setTextColor(const QColor& color)
+{
+    _textColor = color;
+    updateTextColor();
+}
+
+void ElementDisplay::setLineHeight(int height)
+{
+    _lineHeight = height;
+    updateHeight();
+}
+
+bool ElementDisplay::showsColumn() const
+{
+    const auto* number = dynamic_cast<const Number*>(_element.data());
+    return number && number->column();
+}
+
+void ElementDisplay::setColumnExpanded(bool expanded)
+{
+    if (_columnExpanded == expanded)
+        return;
+    _columnExpanded = expanded;
+    if (showsColumn())
+        updateElementText();
+}
+
+void ElementDisplay::updateHeight()
+{
+    if (_lineHeight > 0)
+        setFixedHeight(_lineHeight + int(text().count(QChar('\n'))) * fontMetrics().lineSpacing());
+}
+
+// A result with a special value is shown in the error color and tells why in its tooltip, a
+// matched parenthesis in the color of its depth, so that both ends of a pair share it.
+void ElementDisplay::updateTextColor()
+{
+    const auto* number = dynamic_cast<const Number*>(_element.data());
+    const auto* op = dynamic_cast<const Operator*>(_element.data());
+    const core::Status status = number ? number->status() : core::Status::Ok;
+    QColor color = _textColor;
+    if (status != core::Status::Ok)
+        color = g_errorTextColor;
+    else if (op && op->paired())
+        color = g_parenthesisColors[size_t(op->depth()) % std::size(g_parenthesisColors)];
+    if (palette().color(QPalette::WindowText) != color) {
+        QPalette palette = this->palette();
+        palette.setColor(QPalette::WindowText, color);
+        setPalette(palette);
     }
-    auto textToShow = _element->text();
+    if (status == core::Status::Ok && number && number->column())
+        setToolTip(g_columnToolTip.arg(number->column()->size()));
+    else
+        setToolTip(statusDescription(status));
+}
+
+void ElementDisplay::updateElementText()
+{
+    updateTextColor();
+    const QString textToShow = elementText(_element, _columnExpanded);
     if (text() == textToShow)
         return;
-    if (textToShow.size() > 1 && textToShow[0] == g_minusSign)
-        textToShow = g_leftParenthesis % textToShow % g_rightParenthesis;
     setText(textToShow);
+    updateHeight();
+}
+
+// The text is measured through textWidthCache(), so that lines measured on the thread pool are
+// laid out without shaping their text again.
+int ElementDisplay::widthFor(const QFont& font) const
+{
+    const QMargins margins = contentsMargins();
+    return qCeil(textWidthCache().width(font, text())) + margins.left() + margins.right() +
+           2 * margin();
 }
 
+QSize ElementDisplay::sizeHint() const
+{
+    return QSize(widthFor(font()),
+                 _lineHeight > 0 ? minimumHeight() : QLabel::sizeHint().height());
+}
+
+QSize ElementDisplay::minimumSizeHint() const { return sizeHint(); }
+
 bool ElementDisplay::_showConnections = true;
 
 #include "moc_display.cpp"
@@ -1,26 +1,37 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
+#include <QFutureWatcher>
 #include <QPointer>
 #include <QLabel>
 #include <QPainter>
 #include <QPainterPath>
 #include <QScrollArea>
+#include <set>
 
 #include "math_elements.h"
+#include "memory_accounting.h"
 
+class Display;
 class EquationQueue;
 class ElementDisplay;
+class FrameScheduler;
 class QPropertyAnimation;
+class MemoryPanel;
 class Menu;
+class PlotPanel;
+class QLineEdit;
 class QToolButton;
+class StatisticsPanel;
 
 class ElementPath : public QObject, public QPainterPath
 {
 public:
     ElementPath(ElementDisplay* start, ElementDisplay* end, QObject* parent);
+    ~ElementPath();
     void update();
     QColor color() const;
+    static int liveCount() { return int(memoryUsage(MemoryCategory::ElementPaths).count); }
 
 private:
     QPointF startPoint() const;
@@ -30,6 +41,9 @@ private:
     bool _dirty = true;
 };
 
+// Shows the Display with the menu button on top. The menu, its animation, the statistics, plot
+// and memory panels and the search box are not needed for the first frame: they are created on
+// first use or once the event loop is idle after the first paint.
 class ScrollDisplay : public QScrollArea
 {
     Q_OBJECT
@@ -43,12 +57,22 @@ protected:
 
 private slots:
     void toggleMenu(bool show);
+    void toggleSearch(bool show);
     void setBarToMax();
+    void createMenu();
 
 private:
-    QPropertyAnimation* _animation;
-    Menu* _menu;
+    void raiseOverlays();
+
+    Display* const _display;
+    QPropertyAnimation* _animation = nullptr;
+    Menu* _menu = nullptr;
     QToolButton* _menuButton;
+    StatisticsPanel* _statisticsPanel = nullptr;
+    PlotPanel* _plotPanel = nullptr;
+    MemoryPanel* _memoryPanel = nullptr;
+    QLineEdit* _searchBox = nullptr;
+    bool _menuScheduled = false;
 };
 
 class Display : public QWidget
@@ -58,28 +82,70 @@ public:
     explicit Display(QWidget* parent = nullptr);
 
     void setEquations(const std::shared_ptr<EquationQueue>& equations);
+    const std::shared_ptr<EquationQueue>& equations() const { return _equations; }
+    // Identifiers (see EquationQueue::firstId()) of the selected lines.
+    const std::set<size_t>& selection() const { return _selection; }
+
+signals:
+    void linesChanged();
+    void selectionChanged();
 
 public slots:
-    void alignElementDisplayContent();
     void pasteAllResults() const;
     void toggleConnection(bool show);
     void clearAllHistory();
+    void setSelectionEnabled(bool enabled);
+    void setFilter(const QString& query);
+    void refreshEditedLines(const std::vector<size_t>& ids);
+    void setArithmetic(core::Arithmetic arithmetic);
+    void setBase(core::Base base);
 
 protected:
     void paintEvent(QPaintEvent* event) override;
     QSize sizeHint() const override;
     void resizeEvent(QResizeEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
 
 private:
-    void adjustElementsDisplayGeo(bool newLineAdded);
+    // Expands or collapses the column numbers of the line that shows target, all together so
+    // that their rows line up.
+    void toggleColumns(ElementDisplay* target);
+    void scheduleAlignment();
+    void scheduleEditedLines(const std::vector<size_t>& ids);
+    void measureNewLines();
+    // Applies everything scheduled since the last frame with one layout and paint pass.
+    void applyPendingChanges();
+    // Applies everything scheduled at once, for input that looks lines up by position.
+    void finishPendingChanges();
+    void applyChanges(qint64 budgetMs);
+    // Returns false when the budget ran out before every new line was laid out.
+    bool alignElementDisplayContent(qint64 budgetMs);
+    void removeLine(int index);
+    void syncLine(QLayout* line, const Equation& equation);
+    void setLineAsHistory(QLayout* line);
+    void adjustElementsDisplayGeo(int firstChangedLine);
     void adjustLastLineFontSize();
-    void updateConnectionForSecondLastLine();
+    void updateConnectionToLine(int lineIndex);
     void regeneratePaths();
     void drawPaths();
     void addPath(ElementDisplay* one, ElementDisplay* other);
+    void updateSelectionDisplay();
+    void applyFilter();
 
     std::shared_ptr<EquationQueue> _equations;
+    FrameScheduler* _frameScheduler;
+    bool _alignmentPending = false;
+    // The first line whose connections are left to update once the lines laid out over several
+    // frames are complete, -1 when none are.
+    int _firstUnalignedLine = -1;
+    QFutureWatcher<void> _measurement;
+    std::vector<size_t> _editedLines;
     std::vector<std::unique_ptr<ElementPath>> _paths;
+    size_t _firstLineId = 0;
+    std::set<size_t> _selection;
+    bool _selectionEnabled = false;
+    QString _filterQuery;
 };
 
 class ElementDisplay : public QLabel
@@ -88,27 +154,52 @@ class ElementDisplay : public QLabel
     friend Display;
 public:
     explicit ElementDisplay(QWidget* parent, Element* element = nullptr, bool showConnection = true);
+    ~ElementDisplay();
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+    // The width of the text shown, set in font, with the margins.
+    int widthFor(const QFont& font) const;
+    static int liveCount() { return int(memoryUsage(MemoryCategory::ElementDisplays).count); }
 
     const Element* element() const;
+    // Shows e, refreshing the text and color when e is new or was edited since last shown.
     void setElement(const Element* e);
-    std::shared_ptr<QColor> connectColor() const { return _connectColor; }
-    void setConnectColor(const std::shared_ptr<QColor>& color) { _connectColor = color; }
+    // Color of the value cluster shared with the connected displays, invalid when unconnected.
+    QColor connectColor() const { return _connectColor; }
 
     const std::vector<QPointer<ElementDisplay>>& nexts() { return _nexts; };
-    void addNext(ElementDisplay* display);
+    void addNext(ElementDisplay* display, const QColor& color);
     void clearAllNext();
+    void setSelected(bool selected);
+    // Color of the text unless the element is a result with a special value or a matched
+    // parenthesis.
+    void setTextColor(const QColor& color);
+    // Height of a single line of text; an expanded column grows by a line per row it shows.
+    void setLineHeight(int height);
+    // A number standing for a column shows its first row and the number of rows, or the first
+    // rows one per line when expanded.
+    bool showsColumn() const;
+    bool columnExpanded() const { return _columnExpanded; }
+    void setColumnExpanded(bool expanded);
 
 protected:
     void paintEvent(QPaintEvent* event) override;
+    void changeEvent(QEvent* event) override;
 
-private slots:
+private:
     void updateElementText();
+    void updateTextColor();
+    void updateHeight();
 
-private:
     QPointer<const Element> _element;
+    uint64_t _shownRevision = 0;
     std::vector<QPointer<ElementDisplay>> _nexts;
     QPointer<ElementDisplay> _previous;
-    std::shared_ptr<QColor> _connectColor;
+    QColor _connectColor;
+    QColor _textColor;
+    bool _selected = false;
+    bool _columnExpanded = false;
+    int _lineHeight = 0;
     static bool _showConnections;
 };
 #endif // DISPLAY_H
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "equation_inbox.h"
+#include "math_elements.h"
+
+namespace {
+int64_t monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+} // namespace
+
+EquationInbox::EquationInbox(const std::shared_ptr<EquationQueue>& equations, QObject* parent)
+    : QObject(parent), _equations(equations)
+{
+    Node* const stub = new Node;
+    _head.store(stub, std::memory_order_relaxed);
+    _tail = stub;
+}
+
+EquationInbox::~EquationInbox()
+{
+    core::Equation discarded;
+    int64_t pushedNs;
+    while (pop(&discarded, &pushedNs)) {
+    }
+    delete _tail;
+}
+
+void EquationInbox::push(core::Equation equation)
+{
+    Node* const node = new Node;
+    node->equation = std::move(equation);
+    node->pushedNs = monotonicNs();
+    // Counted before the node can be popped, so a drain never takes the depth below zero.
+    _depth.fetch_add(1, std::memory_order_relaxed);
+    Node* const previous = _head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+
+    if (!_drainScheduled.exchange(true, std::memory_order_acq_rel))
+        QMetaObject::invokeMethod(this, &EquationInbox::drain, Qt::QueuedConnection);
+}
+
+// Only the inbox thread pops. A producer that has swapped _head but not yet linked its node
+// makes the list look shorter for a moment; its own drain request picks the node up.
+bool EquationInbox::pop(core::Equation* equation, int64_t* pushedNs)
+{
+    Node* const next = _tail->next.load(std::memory_order_acquire);
+    if (!next)
+        return false;
+    *equation = std::move(next->equation);
+    *pushedNs = next->pushedNs;
+    delete _tail;
+    _tail = next;
+    return true;
+}
+
+void EquationInbox::drain()
+{
+    // Reading the flag with acquire pairs with the producers' exchange, so every node linked
+    // before a producer saw a pending drain is visible below.
+    _drainScheduled.exchange(false, std::memory_order_acq_rel);
+    std::vector<core::Equation> equations;
+    core::Equation equation;
+    int64_t pushedNs = 0;
+    int64_t oldestNs = 0;
+    while (pop(&equation, &pushedNs)) {
+        if (equations.empty())
+            oldestNs = pushedNs;
+        equations.push_back(std::move(equation));
+    }
+    const size_t count = equations.size();
+    if (count == 0)
+        return;
+    _depth.fetch_sub(count, std::memory_order_relaxed);
+    _equations->appendCompleted(std::move(equations));
+
+    const int64_t latencyNs = monotonicNs() - oldestNs;
+    _metrics.drained += count;
+    ++_metrics.drains;
+    _metrics.lastDrainLatencyNs = latencyNs;
+    _metrics.maxDrainLatencyNs = std::max(_metrics.maxDrainLatencyNs, latencyNs);
+}
+
+EquationInboxMetrics EquationInbox::metrics() const
+{
+    EquationInboxMetrics result = _metrics;
+    result.depth = _depth.load(std::memory_order_relaxed);
+    return result;
+}
+
+#include "moc_equation_inbox.cpp"
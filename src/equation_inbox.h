@@ -0,0 +1,60 @@
+#ifndef EQUATION_INBOX_H
+#define EQUATION_INBOX_H
+
+#include <QObject>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "core/equation.h"
+
+class EquationQueue;
+
+struct EquationInboxMetrics
+{
+    size_t depth = 0;
+    uint64_t drained = 0;
+    uint64_t drains = 0;
+    // Time from the oldest push of a drain until that drain was applied.
+    int64_t lastDrainLatencyNs = 0;
+    int64_t maxDrainLatencyNs = 0;
+};
+
+// Lets any thread hand completed equations to the EquationQueue owned by the GUI thread. Pushes
+// go into a lock-free multi-producer single-consumer list; the first push after a drain posts
+// one drain to the GUI thread, which appends everything pushed so far with one notification.
+class EquationInbox : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EquationInbox(const std::shared_ptr<EquationQueue>& equations,
+                           QObject* parent = nullptr);
+    ~EquationInbox();
+
+    // Thread safe.
+    void push(core::Equation equation);
+    // Call from the inbox thread.
+    EquationInboxMetrics metrics() const;
+
+public slots:
+    void drain();
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        core::Equation equation;
+        int64_t pushedNs = 0;
+    };
+
+    bool pop(core::Equation* equation, int64_t* pushedNs);
+
+    std::shared_ptr<EquationQueue> _equations;
+    std::atomic<Node*> _head;
+    Node* _tail;
+    std::atomic<bool> _drainScheduled{false};
+    std::atomic<size_t> _depth{0};
+    EquationInboxMetrics _metrics;
+};
+
+#endif // EQUATION_INBOX_H
@@ -0,0 +1,124 @@
+#include <deque>
+
+#include <QFutureWatcher>
+#include <QLocalSocket>
+#include <QtConcurrent>
+
+#include "core/number_text.h"
+#include "equation_inbox.h"
+#include "evaluation_server.h"
+
+namespace {
+constexpr int g_batchLines = 512;
+constexpr int g_maxPendingLines = 16384;
+constexpr qint64 g_maxUnwrittenBytes = 1 << 20;
+constexpr qint64 g_readBufferSize = 1 << 20;
+const QByteArray g_errorResponse("error\n");
+
+QByteArray evaluateBatch(const QList<QByteArray>& lines, EquationInbox* mirror)
+{
+    QByteArray responses;
+    for (const QByteArray& line : lines) {
+        core::Equation equation;
+        if (!core::Equation::parse(std::string_view(line.constData(), line.size()), &equation)) {
+            responses += g_errorResponse;
+            continue;
+        }
+        responses += QByteArray::fromStdString(equation.back().text);
+        responses += '\n';
+        if (mirror)
+            mirror->push(std::move(equation));
+    }
+    return responses;
+}
+
+class EvaluationConnection : public QObject
+{
+public:
+    EvaluationConnection(QLocalSocket* socket, EvaluationServer* server, QThreadPool* pool)
+        : QObject(server), _socket(socket), _server(server), _pool(pool)
+    {
+        _socket->setParent(this);
+        _socket->setReadBufferSize(g_readBufferSize);
+        connect(_socket, &QLocalSocket::readyRead, this, &EvaluationConnection::readRequests);
+        connect(_socket, &QLocalSocket::bytesWritten, this, &EvaluationConnection::readRequests);
+        connect(_socket, &QLocalSocket::disconnected, this, &QObject::deleteLater);
+        readRequests();
+    }
+
+private:
+    using Watcher = QFutureWatcher<QByteArray>;
+
+    void readRequests()
+    {
+        if (_rejected)
+            return;
+        while (_pendingLines < g_maxPendingLines && _socket->bytesToWrite() < g_maxUnwrittenBytes &&
+               _socket->canReadLine()) {
+            QList<QByteArray> lines;
+            while (lines.size() < g_batchLines && _socket->canReadLine())
+                lines.append(_socket->readLine().trimmed());
+            _pendingLines += lines.size();
+
+            auto* watcher = new Watcher(this);
+            connect(watcher, &Watcher::finished, this, &EvaluationConnection::writeResponses);
+            watcher->setFuture(QtConcurrent::run(_pool, evaluateBatch, lines, _server->mirror()));
+            _inFlight.emplace_back(watcher, int(lines.size()));
+        }
+        // A line longer than the read buffer never becomes readable. It is answered with an error
+        // after the requests before it, then the connection is closed.
+        if (_inFlight.empty() && !_socket->canReadLine() &&
+            _socket->bytesAvailable() >= g_readBufferSize) {
+            _rejected = true;
+            _socket->write(g_errorResponse);
+            _socket->disconnectFromServer();
+        }
+    }
+
+    // Batches finish in any order but are answered strictly in the order they were read.
+    void writeResponses()
+    {
+        while (!_inFlight.empty() && _inFlight.front().first->isFinished()) {
+            Watcher* watcher = _inFlight.front().first;
+            _pendingLines -= _inFlight.front().second;
+            _inFlight.pop_front();
+            _socket->write(watcher->result());
+            watcher->deleteLater();
+        }
+        readRequests();
+    }
+
+    QLocalSocket* const _socket;
+    EvaluationServer* const _server;
+    QThreadPool* const _pool;
+    std::deque<std::pair<Watcher*, int>> _inFlight;
+    int _pendingLines = 0;
+    bool _rejected = false;
+};
+} // namespace
+
+EvaluationServer::EvaluationServer(QObject* parent) : QObject(parent)
+{
+    connect(&_server, &QLocalServer::newConnection, this, &EvaluationServer::acceptConnections);
+}
+
+EvaluationServer::~EvaluationServer()
+{
+    // Batches still running may push into the mirror, which can be destroyed right after us.
+    _server.close();
+    _pool.waitForDone();
+}
+
+bool EvaluationServer::listen(const QString& name)
+{
+    QLocalServer::removeServer(name);
+    return _server.listen(name);
+}
+
+void EvaluationServer::acceptConnections()
+{
+    while (QLocalSocket* socket = _server.nextPendingConnection())
+        new EvaluationConnection(socket, this, &_pool);
+}
+
+#include "moc_evaluation_server.cpp"
@@ -0,0 +1,41 @@
+#ifndef EVALUATION_SERVER_H
+#define EVALUATION_SERVER_H
+
+#include <QLocalServer>
+#include <QObject>
+#include <QThreadPool>
+
+class EquationInbox;
+
+// Serves expression evaluation over a local socket (a Unix domain socket or a Windows named
+// pipe). Each request is one expression per line, each response one line with the result or
+// "error", in request order. Requests are evaluated in batches on a thread pool of the server's
+// own and a connection stops reading once too many requests are in flight, so a fast client is
+// throttled by the socket buffers instead of growing memory. A request line longer than the
+// read buffer is answered with "error" and closes the connection.
+class EvaluationServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EvaluationServer(QObject* parent = nullptr);
+    ~EvaluationServer();
+
+    bool listen(const QString& name);
+    QString errorString() const { return _server.errorString(); }
+    // Successfully evaluated requests are also pushed into mirror, which has to outlive the
+    // server.
+    void setMirror(EquationInbox* mirror) { _mirror = mirror; }
+    EquationInbox* mirror() const { return _mirror; }
+
+private slots:
+    void acceptConnections();
+
+private:
+    QLocalServer _server;
+    EquationInbox* _mirror = nullptr;
+    // Only the batches run here, so destruction waits for them and not for unrelated work on the
+    // global pool.
+    QThreadPool _pool;
+};
+
+#endif // EVALUATION_SERVER_H
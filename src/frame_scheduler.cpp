@@ -0,0 +1,45 @@
+#include <QGuiApplication>
+#include <QScreen>
+
+#include "frame_scheduler.h"
+
+namespace {
+constexpr qreal g_defaultRefreshRate = 60;
+} // namespace
+
+FrameScheduler::FrameScheduler(QObject* parent) : QObject(parent)
+{
+    const QScreen* screen = QGuiApplication::primaryScreen();
+    const qreal refreshRate =
+        screen && screen->refreshRate() > 0 ? screen->refreshRate() : g_defaultRefreshRate;
+    _intervalMs = qMax(1, qRound(1000 / refreshRate));
+    _timer.setSingleShot(true);
+    _timer.setTimerType(Qt::PreciseTimer);
+    connect(&_timer, &QTimer::timeout, this, &FrameScheduler::tick);
+}
+
+// The first request after an idle interval is served on the next pass of the event loop, so a
+// single keystroke shows without delay, later ones wait for the rest of the interval.
+void FrameScheduler::requestFrame()
+{
+    if (_timer.isActive())
+        return;
+    const qint64 elapsed = _sinceLastFrame.isValid() ? _sinceLastFrame.elapsed() : _intervalMs;
+    _timer.start(int(qMax<qint64>(0, _intervalMs - elapsed)));
+}
+
+void FrameScheduler::flush()
+{
+    if (!_timer.isActive())
+        return;
+    _timer.stop();
+    tick();
+}
+
+void FrameScheduler::tick()
+{
+    _sinceLastFrame.start();
+    emit frame();
+}
+
+#include "moc_frame_scheduler.cpp"
@@ -0,0 +1,32 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+// Paces work to the refresh rate of the primary screen: any number of requestFrame() calls
+// between two ticks result in a single frame(), so fast edits are laid out and painted once per
+// refresh instead of once per edit.
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FrameScheduler(QObject* parent = nullptr);
+
+    void requestFrame();
+    bool framePending() const { return _timer.isActive(); }
+    // Emits a pending frame() right away, for input that needs the frame's result.
+    void flush();
+
+signals:
+    void frame();
+
+private:
+    void tick();
+
+    QTimer _timer;
+    QElapsedTimer _sinceLastFrame;
+    int _intervalMs;
+};
+#endif // FRAME_SCHEDULER_H
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "history_index.h"
+
+namespace {
+constexpr int g_gramLength = 3;
+
+uint64_t trigramKey(const QChar* chars)
+{
+    return (uint64_t(chars[0].unicode()) << 32) | (uint64_t(chars[1].unicode()) << 16) |
+           chars[2].unicode();
+}
+
+std::vector<uint64_t> distinctTrigrams(const QString& text)
+{
+    std::vector<uint64_t> keys;
+    for (int i = 0; i + g_gramLength <= text.size(); ++i)
+        keys.push_back(trigramKey(text.constData() + i));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+std::vector<size_t> sortedIds(HistoryIndex::ValueIndex::const_iterator first,
+                              HistoryIndex::ValueIndex::const_iterator last)
+{
+    std::vector<size_t> ids;
+    for (; first != last; ++first)
+        ids.push_back(first->second);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+} // namespace
+
+void HistoryIndex::add(size_t id, double value, const QString& text)
+{
+    const auto valuePosition = std::isnan(value) ? _values.end() : _values.emplace(value, id);
+    if (_entries.empty() || _entries.back().id < id) {
+        _entries.push_back({id, text, valuePosition, true});
+    } else {
+        // An edited equation, back in the slot remove() left.
+        const auto found = findEntry(id);
+        if (found == _entries.end() || found->id != id)
+            _entries.insert(found, {id, text, valuePosition, true});
+        else
+            *found = {id, text, valuePosition, true};
+    }
+    for (uint64_t key : distinctTrigrams(text)) {
+        std::deque<size_t>& postings = _trigrams[key];
+        if (postings.empty() || postings.back() < id)
+            postings.push_back(id);
+        else
+            postings.insert(std::lower_bound(postings.begin(), postings.end(), id), id);
+    }
+}
+
+void HistoryIndex::remove(size_t id)
+{
+    const auto found = findEntry(id);
+    if (found == _entries.end() || found->id != id || !found->live)
+        return;
+    if (found->value != _values.end())
+        _values.erase(found->value);
+    for (uint64_t key : distinctTrigrams(found->text)) {
+        const auto postings = _trigrams.find(key);
+        if (postings == _trigrams.end())
+            continue;
+        const auto posting =
+            std::lower_bound(postings->second.begin(), postings->second.end(), id);
+        if (posting != postings->second.end() && *posting == id)
+            postings->second.erase(posting);
+        if (postings->second.empty())
+            _trigrams.erase(postings);
+    }
+    *found = {id, QString(), _values.end(), false};
+}
+
+void HistoryIndex::removeBefore(size_t id)
+{
+    while (!_entries.empty() && _entries.front().id < id) {
+        const Entry& oldest = _entries.front();
+        if (oldest.value != _values.end())
+            _values.erase(oldest.value);
+        for (uint64_t key : distinctTrigrams(oldest.text)) {
+            auto postings = _trigrams.find(key);
+            if (postings == _trigrams.end())
+                continue;
+            if (!postings->second.empty() && postings->second.front() == oldest.id)
+                postings->second.pop_front();
+            if (postings->second.empty())
+                _trigrams.erase(postings);
+        }
+        _entries.pop_front();
+    }
+}
+
+void HistoryIndex::clear()
+{
+    _entries.clear();
+    _values.clear();
+    _trigrams.clear();
+}
+
+std::vector<size_t> HistoryIndex::findValue(double value) const
+{
+    const double epsilon = std::numeric_limits<double>::epsilon();
+    return sortedIds(_values.lower_bound(value - epsilon), _values.upper_bound(value + epsilon));
+}
+
+std::vector<size_t> HistoryIndex::findRange(double low, double high) const
+{
+    if (low > high)
+        return {};
+    return sortedIds(_values.lower_bound(low), _values.upper_bound(high));
+}
+
+std::vector<size_t> HistoryIndex::findText(const QString& needle) const
+{
+    std::vector<size_t> ids;
+    if (needle.size() < g_gramLength) {
+        for (const auto& e : _entries) {
+            if (e.live && e.text.contains(needle))
+                ids.push_back(e.id);
+        }
+        return ids;
+    }
+
+    const std::deque<size_t>* candidates = nullptr;
+    for (uint64_t key : distinctTrigrams(needle)) {
+        const auto postings = _trigrams.find(key);
+        if (postings == _trigrams.end())
+            return ids;
+        if (!candidates || postings->second.size() < candidates->size())
+            candidates = &postings->second;
+    }
+    for (size_t id : *candidates) {
+        const Entry* e = entry(id);
+        if (e && e->live && e->text.contains(needle))
+            ids.push_back(id);
+    }
+    return ids;
+}
+
+std::deque<HistoryIndex::Entry>::iterator HistoryIndex::findEntry(size_t id)
+{
+    return std::lower_bound(_entries.begin(), _entries.end(), id,
+                            [](const Entry& e, size_t id) { return e.id < id; });
+}
+
+const HistoryIndex::Entry* HistoryIndex::entry(size_t id) const
+{
+    const auto found = std::lower_bound(_entries.begin(), _entries.end(), id,
+                                        [](const Entry& e, size_t id) { return e.id < id; });
+    if (found == _entries.end() || found->id != id)
+        return nullptr;
+    return &*found;
+}
@@ -0,0 +1,50 @@
+#ifndef HISTORY_INDEX_H
+#define HISTORY_INDEX_H
+
+#include <QString>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// Search indexes over completed equations, keyed by the identifiers of EquationQueue::firstId().
+// Equations are added in increasing identifier order and evicted from the oldest, so every
+// posting list stays sorted and eviction only ever touches list fronts. An edited equation is
+// removed and added again, which only touches its own value and posting list entries.
+class HistoryIndex
+{
+public:
+    using ValueIndex = std::multimap<double, size_t>;
+
+    void add(size_t id, double value, const QString& text);
+    // Takes out the value and text added with id, until id is added again.
+    void remove(size_t id);
+    void removeBefore(size_t id);
+    void clear();
+    size_t size() const { return _entries.size(); }
+
+    // All queries return matching identifiers in increasing order.
+    std::vector<size_t> findValue(double value) const;
+    std::vector<size_t> findRange(double low, double high) const;
+    std::vector<size_t> findText(const QString& needle) const;
+
+private:
+    struct Entry
+    {
+        size_t id;
+        QString text;
+        ValueIndex::iterator value;
+        // False between remove() and the add() of the edited equation.
+        bool live;
+    };
+
+    const Entry* entry(size_t id) const;
+    std::deque<Entry>::iterator findEntry(size_t id);
+
+    std::deque<Entry> _entries;
+    ValueIndex _values;
+    std::unordered_map<uint64_t, std::deque<size_t>> _trigrams;
+};
+
+#endif // HISTORY_INDEX_H
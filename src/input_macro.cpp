@@ -0,0 +1,175 @@
+#include <cctype>
+
+#include <QFile>
+
+#include "input_macro.h"
+#include "math_elements.h"
+
+extern const QString g_plus;
+extern const QString g_minus;
+extern const QString g_multiply;
+extern const QString g_divide;
+extern const QString g_equal;
+extern const QString g_openParenthesis;
+extern const QString g_closeParenthesis;
+extern const QString g_and;
+extern const QString g_or;
+extern const QString g_xor;
+extern const QString g_shiftLeft;
+extern const QString g_shiftRight;
+
+namespace {
+constexpr char g_commentStart = '#';
+} // namespace
+
+bool applyInput(EquationQueue& equations, Input input)
+{
+    const char code = char(input);
+    if (code >= '0' && code <= '9') {
+        equations.append(uint8_t(code - '0'));
+        return true;
+    }
+    if (code >= 'A' && code <= 'F') {
+        equations.append(uint8_t(code - 'A' + 10));
+        return true;
+    }
+    switch (input) {
+    case Input::Plus:
+        equations.append(g_plus);
+        return true;
+    case Input::Minus:
+        equations.append(g_minus);
+        return true;
+    case Input::Multiply:
+        equations.append(g_multiply);
+        return true;
+    case Input::Divide:
+        equations.append(g_divide);
+        return true;
+    case Input::Equal:
+        equations.append(g_equal);
+        return true;
+    case Input::Open:
+        equations.append(g_openParenthesis);
+        return true;
+    case Input::Close:
+        equations.append(g_closeParenthesis);
+        return true;
+    case Input::And:
+        equations.append(g_and);
+        return true;
+    case Input::Or:
+        equations.append(g_or);
+        return true;
+    case Input::Xor:
+        equations.append(g_xor);
+        return true;
+    case Input::ShiftLeft:
+        equations.append(g_shiftLeft);
+        return true;
+    case Input::ShiftRight:
+        equations.append(g_shiftRight);
+        return true;
+    case Input::Decimal:
+        equations.appendDicimal();
+        return true;
+    case Input::Percent:
+        equations.applyPercent();
+        return true;
+    case Input::Sign:
+        equations.toggleSign();
+        return true;
+    case Input::Backspace:
+        equations.tryPopLastCharacter();
+        return true;
+    case Input::Clear:
+        equations.clearEntry();
+        return true;
+    }
+    return false;
+}
+
+bool inputFromKeyText(const QString& text, Input* input)
+{
+    if (text.size() != 1)
+        return false;
+    const QChar c = text[0];
+    if (c >= QChar('0') && c <= QChar('9')) {
+        *input = digitInput(uint8_t(c.unicode() - '0'));
+        return true;
+    }
+    const QChar upper = c.toUpper();
+    if (upper >= QChar('A') && upper <= QChar('F')) {
+        *input = digitInput(uint8_t(upper.unicode() - 'A' + 10));
+        return true;
+    }
+    if (c == g_multiply[0]) {
+        *input = Input::Multiply;
+        return true;
+    }
+    if (c == g_divide[0]) {
+        *input = Input::Divide;
+        return true;
+    }
+    switch (c.unicode()) {
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+    case '=':
+    case '(':
+    case ')':
+    case '.':
+    case '%':
+    case '&':
+    case '|':
+    case '^':
+    case '<':
+    case '>':
+        *input = Input(char(c.unicode()));
+        return true;
+    case ',':
+        *input = Input::Decimal;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool InputRecorder::save(const QString& path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    return file.write(_inputs) == _inputs.size();
+}
+
+bool loadInputMacro(const QString& path, QByteArray* inputs)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    inputs->clear();
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        const QByteArray trimmed = line.trimmed();
+        if (trimmed.startsWith(g_commentStart))
+            continue;
+        for (char code : trimmed) {
+            if (!std::isspace(static_cast<unsigned char>(code)))
+                inputs->append(code);
+        }
+    }
+    return true;
+}
+
+int replayInputMacro(EquationQueue& equations, const QByteArray& inputs)
+{
+    int applied = 0;
+    equations.beginBatch();
+    for (char code : inputs) {
+        if (applyInput(equations, Input(code)))
+            ++applied;
+    }
+    equations.endBatch();
+    return applied;
+}
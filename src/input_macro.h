@@ -0,0 +1,56 @@
+#ifndef INPUT_MACRO_H
+#define INPUT_MACRO_H
+
+#include <QByteArray>
+#include <QString>
+
+class EquationQueue;
+
+// Every input is stored as one printable character, so a recorded session is a compact text
+// file such as "12+3.5=n*4=". Whitespace is ignored and '#' starts a comment line. The digits
+// of programmer mode above 9 are 'A' to 'F', and '<' and '>' stand for the shifts.
+enum class Input : char {
+    Plus = '+',
+    Minus = '-',
+    Multiply = '*',
+    Divide = '/',
+    Equal = '=',
+    Open = '(',
+    Close = ')',
+    And = '&',
+    Or = '|',
+    Xor = '^',
+    ShiftLeft = '<',
+    ShiftRight = '>',
+    Decimal = '.',
+    Percent = '%',
+    Sign = 'n',
+    Backspace = 'b',
+    Clear = 'c'
+};
+
+inline Input digitInput(uint8_t digit)
+{
+    return Input(digit < 10 ? '0' + digit : 'A' + digit - 10);
+}
+// Maps the text of a key press to an input, accepting × ÷ ',' and lowercase hexadecimal digits
+// besides the recorded codes.
+bool inputFromKeyText(const QString& text, Input* input);
+bool applyInput(EquationQueue& equations, Input input);
+
+class InputRecorder
+{
+public:
+    void record(Input input) { _inputs.append(char(input)); }
+    const QByteArray& inputs() const { return _inputs; }
+    bool save(const QString& path) const;
+
+private:
+    QByteArray _inputs;
+};
+
+bool loadInputMacro(const QString& path, QByteArray* inputs);
+// Applies all inputs with a single change notification and returns how many were valid.
+int replayInputMacro(EquationQueue& equations, const QByteArray& inputs);
+
+#endif // INPUT_MACRO_H
@@ -1,14 +1,103 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
 #include <QIcon>
+#include <cstring>
+#include <memory>
+#include "evaluation_server.h"
 #include "main_window.h"
+#include "startup_profile.h"
+
+namespace {
+const char g_headlessArgument[] = "--headless";
+
+bool hasArgument(int argc, char* argv[], const char* argument)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], argument) == 0)
+            return true;
+    }
+    return false;
+}
+} // namespace
 
 int main(int argc, char* argv[])
 {
-    QApplication a(argc, argv);
-    QIcon icon;
-    icon.addFile(QStringLiteral(":/App/app_icon.png"));
-    a.setWindowIcon(icon);
-    MainWindow mainWindow;
-    mainWindow.show();
-    return a.exec();
+    startStartupProfile();
+    // The headless server must not touch QtGui, so the application type is chosen before the
+    // command line parser is available.
+    const bool headless = hasArgument(argc, argv, g_headlessArgument);
+    std::unique_ptr<QCoreApplication> a(headless ? new QCoreApplication(argc, argv)
+                                                 : new QApplication(argc, argv));
+    markStartupPhase("application");
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption recordOption(QStringLiteral("record"),
+                                          QStringLiteral("Record all inputs into <file>."),
+                                          QStringLiteral("file"));
+    const QCommandLineOption replayOption(QStringLiteral("replay"),
+                                          QStringLiteral("Replay the inputs recorded in <file>."),
+                                          QStringLiteral("file"));
+    const QCommandLineOption serverOption(
+        QStringLiteral("server"), QStringLiteral("Evaluate expressions sent to local socket <name>."),
+        QStringLiteral("name"));
+    const QCommandLineOption headlessOption(
+        QStringLiteral("headless"), QStringLiteral("Run only the evaluation server, without a window."));
+    const QCommandLineOption mirrorOption(
+        QStringLiteral("mirror"),
+        QStringLiteral("Show the expressions evaluated by the server in the history."));
+    parser.addOptions({recordOption, replayOption, serverOption, headlessOption, mirrorOption});
+    parser.process(*a);
+    markStartupPhase("command line");
+
+    if (headless && !parser.isSet(serverOption)) {
+        qWarning() << "--headless requires --server";
+        return 1;
+    }
+    if (headless && parser.isSet(mirrorOption)) {
+        qWarning() << "--mirror shows requests in the window, which --headless does not open";
+        return 1;
+    }
+    // The window is created first so that the server, which may mirror into its history, is
+    // destroyed before it.
+    std::unique_ptr<MainWindow> mainWindow;
+    if (!headless) {
+        QIcon icon;
+        icon.addFile(QStringLiteral(":/App/app_icon.png"));
+        QApplication::setWindowIcon(icon);
+        mainWindow = std::make_unique<MainWindow>();
+        markStartupPhase("main window");
+    }
+    std::unique_ptr<EvaluationServer> server;
+    if (parser.isSet(serverOption)) {
+        server = std::make_unique<EvaluationServer>();
+        if (!server->listen(parser.value(serverOption))) {
+            qWarning() << "Cannot listen on" << parser.value(serverOption) << server->errorString();
+            return 1;
+        }
+        if (mainWindow && parser.isSet(mirrorOption))
+            server->setMirror(mainWindow->inbox());
+    }
+    if (headless)
+        return a->exec();
+
+    if (parser.isSet(recordOption))
+        mainWindow->startRecording(parser.value(recordOption));
+    finishStartupProfileOnFirstFrame(mainWindow.get());
+    mainWindow->show();
+    markStartupPhase("show");
+    if (parser.isSet(replayOption)) {
+        QByteArray inputs;
+        if (!loadInputMacro(parser.value(replayOption), &inputs)) {
+            qWarning() << "Cannot read input recording" << parser.value(replayOption);
+            return 1;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        const int applied = mainWindow->replay(inputs);
+        qInfo() << "Replayed" << applied << "inputs in" << timer.nsecsElapsed() / 1e6 << "ms";
+    }
+    return a->exec();
 }
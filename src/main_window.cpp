@@ -1,56 +1,89 @@
 
+#include <QApplication>
+#include <QClipboard>
 #include <QKeyEvent>
 #include <QDebug>
+#include <QProgressDialog>
+#include <QTimer>
 
+#include "bulk_evaluator.h"
+#include "equation_inbox.h"
+#include "input_macro.h"
 #include "main_window.h"
+#include "memory_accounting.h"
+#include "results_store.h"
+#include "startup_profile.h"
 #include "ui_main_window.h"
 
 namespace {
-constexpr QChar g_minusSign = '-';
-constexpr QChar g_equalSign = '=';
-const QString g_signOperatorText("+/-");
-const QString g_percentOperatorText("%");
 constexpr QSize g_windowSize(640, 300);
 const QFont g_buttonFont(QStringLiteral("Arial"), 25);
 const QString g_windowTitle("CalculatorWithHistory");
+const char g_resultsStoreVariable[] = "CALCULATOR_RESULTS_STORE";
+constexpr int g_resultsStoreSaveInterval = 30000;
+const QString g_pasteProgressText("Evaluating pasted expressions...");
+const QString g_pasteCancelText("Cancel");
+constexpr int g_pasteProgressDelay = 300;
 }
 
-extern const QString g_plus;
-extern const QString g_minus;
-extern const QString g_multiply;
-extern const QString g_divide;
-
 MainWindow::MainWindow(QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
-    connect(ui->digit0, &QPushButton::clicked, this, [this]{ digitClicked(0); });
-    connect(ui->digit1, &QPushButton::clicked, this, [this]{ digitClicked(1); });
-    connect(ui->digit2, &QPushButton::clicked, this, [this]{ digitClicked(2); });
-    connect(ui->digit3, &QPushButton::clicked, this, [this]{ digitClicked(3); });
-    connect(ui->digit4, &QPushButton::clicked, this, [this]{ digitClicked(4); });
-    connect(ui->digit5, &QPushButton::clicked, this, [this]{ digitClicked(5); });
-    connect(ui->digit6, &QPushButton::clicked, this, [this]{ digitClicked(6); });
-    connect(ui->digit7, &QPushButton::clicked, this, [this]{ digitClicked(7); });
-    connect(ui->digit8, &QPushButton::clicked, this, [this]{ digitClicked(8); });
-    connect(ui->digit9, &QPushButton::clicked, this, [this]{ digitClicked(9); });
-
-    connect(ui->plus, &QPushButton::clicked, this,[this]{ binaryOperatorClicked(g_plus); });
-    connect(ui->minus, &QPushButton::clicked, this,[this]{ binaryOperatorClicked(g_minus); });
-    connect(ui->multiply, &QPushButton::clicked, this,[this]{ binaryOperatorClicked(g_multiply); });
-    connect(ui->divide, &QPushButton::clicked, this,[this]{ binaryOperatorClicked(g_divide); });
-
-    connect(ui->sign, &QPushButton::clicked, this,[this]{ unaryOperatorClicked(g_signOperatorText); });
-    connect(ui->percent, &QPushButton::clicked, this,[this]{ unaryOperatorClicked(g_percentOperatorText); });
-
-    connect(ui->equal, &QPushButton::clicked, this, &MainWindow::equalClicked);
-    connect(ui->clear, &QPushButton::clicked, this, &MainWindow::clear);
-    connect(ui->period, &QPushButton::clicked, this, &MainWindow::periodClicked);
+    markStartupPhase("main window ui");
+    connect(ui->digit0, &QPushButton::clicked, this, [this]{ handleInput(digitInput(0)); });
+    connect(ui->digit1, &QPushButton::clicked, this, [this]{ handleInput(digitInput(1)); });
+    connect(ui->digit2, &QPushButton::clicked, this, [this]{ handleInput(digitInput(2)); });
+    connect(ui->digit3, &QPushButton::clicked, this, [this]{ handleInput(digitInput(3)); });
+    connect(ui->digit4, &QPushButton::clicked, this, [this]{ handleInput(digitInput(4)); });
+    connect(ui->digit5, &QPushButton::clicked, this, [this]{ handleInput(digitInput(5)); });
+    connect(ui->digit6, &QPushButton::clicked, this, [this]{ handleInput(digitInput(6)); });
+    connect(ui->digit7, &QPushButton::clicked, this, [this]{ handleInput(digitInput(7)); });
+    connect(ui->digit8, &QPushButton::clicked, this, [this]{ handleInput(digitInput(8)); });
+    connect(ui->digit9, &QPushButton::clicked, this, [this]{ handleInput(digitInput(9)); });
+
+    connect(ui->plus, &QPushButton::clicked, this,[this]{ handleInput(Input::Plus); });
+    connect(ui->minus, &QPushButton::clicked, this,[this]{ handleInput(Input::Minus); });
+    connect(ui->multiply, &QPushButton::clicked, this,[this]{ handleInput(Input::Multiply); });
+    connect(ui->divide, &QPushButton::clicked, this,[this]{ handleInput(Input::Divide); });
+
+    connect(ui->sign, &QPushButton::clicked, this,[this]{ handleInput(Input::Sign); });
+    connect(ui->percent, &QPushButton::clicked, this,[this]{ handleInput(Input::Percent); });
+
+    connect(ui->equal, &QPushButton::clicked, this, [this]{ handleInput(Input::Equal); });
+    connect(ui->clear, &QPushButton::clicked, this, [this]{ handleInput(Input::Clear); });
+    connect(ui->period, &QPushButton::clicked, this, [this]{ handleInput(Input::Decimal); });
 
     _equationQueue = std::make_shared<EquationQueue>();
+    _inbox = new EquationInbox(_equationQueue, this);
+    _bulkEvaluator = new BulkEvaluator(this);
+    connect(_bulkEvaluator, &BulkEvaluator::finished, this, &MainWindow::bulkEvaluationFinished);
+    connect(_bulkEvaluator, &BulkEvaluator::columnFinished, this, &MainWindow::columnPasted);
+    connect(_bulkEvaluator, &BulkEvaluator::columnUnsupported, this, [this] {
+        if (_pasteProgress)
+            _pasteProgress->deleteLater();
+        qWarning() << "Programmer mode does not support pasted columns";
+    });
+    connect(_bulkEvaluator, &BulkEvaluator::canceled, this, [this] {
+        if (_pasteProgress)
+            _pasteProgress->deleteLater();
+    });
     static_cast<Display*>(ui->display->widget())->setEquations(_equationQueue);
 
+    _resultsStorePath = qEnvironmentVariable(g_resultsStoreVariable);
+    if (!_resultsStorePath.isEmpty()) {
+        // Every save appends the equations completed since the previous one, the store itself is
+        // never read here: the panels show the session, and ResultsScan scans the whole store.
+        _resultsStore = std::make_unique<ResultsStoreWriter>();
+        connect(_equationQueue.get(), &EquationQueue::equationCompleted, this,
+                [this](const core::Equation& equation) { _resultsStore->append(equation); });
+        // Saved while the window is open too, so a crash loses at most one interval.
+        auto* saveTimer = new QTimer(this);
+        connect(saveTimer, &QTimer::timeout, this, &MainWindow::saveResultsStore);
+        saveTimer->start(g_resultsStoreSaveInterval);
+    }
+
     setWindowTitle(g_windowTitle);
     setFixedSize(g_windowSize);
     const auto allPButtons = findChildren<QPushButton*>();
@@ -63,61 +96,67 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    dumpMemoryUsage();
+    saveResultsStore();
+    if (_recorder && !_recorder->save(_recordPath))
+        qWarning() << "Failed to save input recording to" << _recordPath;
     delete ui;
 }
 
-void MainWindow::keyPressEvent(QKeyEvent* event)
+void MainWindow::saveResultsStore()
 {
-    if (event->key() == Qt::Key_Enter) {
-        enterClicked();
-    } else if (event->key() == Qt::Key_Backspace) {
-        _equationQueue->tryPopLastCharacter();
-    }
-    QWidget::keyPressEvent(event);
+    if (_resultsStore && !_resultsStore->save(_resultsStorePath))
+        qWarning() << "Failed to save results store to" << _resultsStorePath;
 }
 
-void MainWindow::digitClicked(uint8_t digit)
+void MainWindow::startRecording(const QString& path)
 {
-    assert(digit >=0 && digit <= 9);
-    _equationQueue->append(digit);
+    _recorder = std::make_unique<InputRecorder>();
+    _recordPath = path;
 }
 
-void MainWindow::unaryOperatorClicked(const QString& op)
+int MainWindow::replay(const QByteArray& inputs)
 {
-    if (_equationQueue->empty() || _equationQueue->back().empty() ||
-        !dynamic_cast<Number*>(_equationQueue->back().back().get()))
-        return;
-    if (_equationQueue->back().completed()){
-        Equation equation;
-        equation.push_back(std::make_shared<Number>(static_cast<Number*>(_equationQueue->back().back().get())->value()));
-        _equationQueue->push_back((equation));
-    }
-    auto* const number = static_cast<Number*>(_equationQueue->back().back().get());
-    const auto numberText = number->text();
-    if (op == g_signOperatorText) {
-        if (numberText[0] == g_minusSign) {
-            number->trySetValue(numberText.right(numberText.size() - 1));
-            emit _equationQueue->changed();
-        } else {
-            number->trySetValue(QString(g_minusSign).append(numberText));
-            emit _equationQueue->changed();
-        }
-    } else if (op == g_percentOperatorText) {
-        number->trySetValue(QString::number(numberText.toDouble() / 100));
-        emit _equationQueue->changed();
+    if (_recorder) {
+        for (char code : inputs)
+            _recorder->record(Input(code));
     }
+    return replayInputMacro(*_equationQueue, inputs);
 }
 
-void MainWindow::binaryOperatorClicked(const QString& op)
+void MainWindow::keyPressEvent(QKeyEvent* event)
 {
-    _equationQueue->append(op);
+    if (event->matches(QKeySequence::Paste)) {
+        pasteExpressions();
+        return;
+    }
+    Input input;
+    switch (event->key()) {
+    case Qt::Key_Enter:
+    case Qt::Key_Return:
+        enterClicked();
+        return;
+    case Qt::Key_Backspace:
+        handleInput(Input::Backspace);
+        return;
+    case Qt::Key_Escape:
+    case Qt::Key_Delete:
+        handleInput(Input::Clear);
+        return;
+    default:
+        if (inputFromKeyText(event->text(), &input)) {
+            handleInput(input);
+            return;
+        }
+    }
+    QWidget::keyPressEvent(event);
 }
 
-void MainWindow::periodClicked() { _equationQueue->appendDicimal(); }
-
-void MainWindow::equalClicked()
+void MainWindow::handleInput(Input input)
 {
-    _equationQueue->append(g_equalSign);
+    if (_recorder)
+        _recorder->record(input);
+    applyInput(*_equationQueue, input);
 }
 
 void MainWindow::enterClicked()
@@ -130,16 +169,38 @@ void MainWindow::enterClicked()
         ui->equal->animateClick();
 }
 
-void MainWindow::clear()
+void MainWindow::pasteExpressions()
 {
-    if (_equationQueue->empty())
+    const QString text = QApplication::clipboard()->text();
+    if (text.trimmed().isEmpty() || _bulkEvaluator->isRunning())
         return;
-    if (_equationQueue->back().empty())
-        _equationQueue->clear();
-    else if (_equationQueue->back().completed()) {
-        _equationQueue->emplace_back();
-    } else {
-        _equationQueue->back().clear();
-    }
-    emit _equationQueue->changed();
+    _pasteProgress = new QProgressDialog(g_pasteProgressText, g_pasteCancelText, 0, 0, this);
+    _pasteProgress->setWindowModality(Qt::WindowModal);
+    _pasteProgress->setMinimumDuration(g_pasteProgressDelay);
+    _pasteProgress->setAutoReset(false);
+    connect(_bulkEvaluator, &BulkEvaluator::progressRangeChanged, _pasteProgress,
+            &QProgressDialog::setRange);
+    connect(_bulkEvaluator, &BulkEvaluator::progressValueChanged, _pasteProgress,
+            &QProgressDialog::setValue);
+    connect(_pasteProgress, &QProgressDialog::canceled, _bulkEvaluator, &BulkEvaluator::cancel);
+    _bulkEvaluator->start(text, _equationQueue->arithmetic(), _equationQueue->base());
+}
+
+void MainWindow::bulkEvaluationFinished(std::vector<core::Equation> equations, int invalidLines)
+{
+    if (_pasteProgress)
+        _pasteProgress->deleteLater();
+    if (invalidLines > 0)
+        qWarning() << "Skipped" << invalidLines << "pasted lines that are not valid expressions";
+    _equationQueue->appendCompleted(std::move(equations));
+}
+
+void MainWindow::columnPasted(std::vector<double> values, int invalidLines)
+{
+    if (_pasteProgress)
+        _pasteProgress->deleteLater();
+    if (invalidLines > 0)
+        qWarning() << "Skipped" << invalidLines << "pasted lines that are not numbers";
+    if (!_equationQueue->appendColumn(std::move(values)))
+        qWarning() << "A pasted column needs a place where a number can be typed";
 }
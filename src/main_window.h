@@ -1,9 +1,16 @@
 #ifndef MAIN_WINDOW_H
 #define MAIN_WINDOW_H
 
+#include <QPointer>
 #include <QWidget>
+#include "input_macro.h"
 #include "math_elements.h"
 
+class BulkEvaluator;
+class EquationInbox;
+class QProgressDialog;
+class ResultsStoreWriter;
+
 namespace Ui {
 class MainWindow;
 }
@@ -15,22 +22,34 @@ class MainWindow : public QWidget
 public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+    const std::shared_ptr<EquationQueue>& equations() const { return _equationQueue; }
+    // Thread safe entry point for equations completed outside of the GUI thread.
+    EquationInbox* inbox() const { return _inbox; }
+    // Records every input from now on and saves it to path when the window is destroyed.
+    void startRecording(const QString& path);
+    int replay(const QByteArray& inputs);
 
 protected:
     void keyPressEvent(QKeyEvent* event) override;
 
 private slots:
-    void digitClicked(uint8_t digit);
-    void unaryOperatorClicked(const QString& op);
-    void binaryOperatorClicked(const QString &op);
-    void periodClicked();
-    void equalClicked();
+    void handleInput(Input input);
     void enterClicked();
-    void clear();
+    void pasteExpressions();
+    void bulkEvaluationFinished(std::vector<core::Equation> equations, int invalidLines);
+    void columnPasted(std::vector<double> values, int invalidLines);
+    void saveResultsStore();
 
 private:
     Ui::MainWindow *ui;
     std::shared_ptr<EquationQueue> _equationQueue;
+    std::unique_ptr<ResultsStoreWriter> _resultsStore;
+    QString _resultsStorePath;
+    std::unique_ptr<InputRecorder> _recorder;
+    QString _recordPath;
+    EquationInbox* _inbox;
+    BulkEvaluator* _bulkEvaluator;
+    QPointer<QProgressDialog> _pasteProgress;
 };
 
 #endif // MAIN_WINDOW_H
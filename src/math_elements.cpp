@@ -1,261 +1,524 @@
-
-#include <deque>
+#include <algorithm>
+#include <cassert>
 #include <stdexcept>
 
 #include <QString>
-#include <QDebug>
+#include <QtConcurrent>
 
+#include "core/column.h"
+#include "core/number_text.h"
 #include "math_elements.h"
+#include "memory_accounting.h"
 
 extern const QString g_plus("+");
 extern const QString g_minus("-");
 extern const QString g_multiply("×");
 extern const QString g_divide("÷");
 extern const QString g_equal("=");
-extern const QString g_point(".");
-const int g_minimumElementCountToCalc = 4;
+extern const QString g_openParenthesis("(");
+extern const QString g_closeParenthesis(")");
+extern const QString g_and("&");
+extern const QString g_or("|");
+extern const QString g_xor("^");
+extern const QString g_shiftLeft("<<");
+extern const QString g_shiftRight(">>");
 
 namespace {
-double calculateImpl(double left, double right, const QString& op)
-{
-    if (op == g_plus) {
-        return left + right;
-    } else if (op == g_minus) {
-        return left - right;
-    } else if (op == g_multiply) {
-        return left * right;
-    } else if (op == g_divide) {
-        return left / right;
-    } else {
-        throw std::invalid_argument("Invalid arguments");
-        return -1;
+// Long enough for a prefixed 64-bit binary number.
+constexpr int g_numberBufferSize = int(core::g_maxIntegerText);
+// Rows per task when a column is evaluated on the thread pool.
+constexpr size_t g_columnRowsPerTask = 65536;
+
+qsizetype lineTextSize(const Equation& equation)
+{
+    return equation.text().size() + (equation.completed() ? 1 : 0);
+}
+
+// Number text is ASCII, so it is narrowed on the stack instead of through a QByteArray. Text
+// that does not parse reads as 0, like QString::toDouble().
+double parseValue(const QString& text)
+{
+    char buffer[g_numberBufferSize];
+    if (text.size() > g_numberBufferSize)
+        return 0;
+    for (int i = 0; i < text.size(); ++i) {
+        const char16_t c = text[i].unicode();
+        if (c > 0x7f)
+            return 0;
+        buffer[i] = char(c);
     }
+    double value;
+    return core::parseNumber(std::string_view(buffer, size_t(text.size())), &value) ? value : 0;
 }
 
-bool isEqualWithEpsilon(double a, double b)
+// Column rows are accounted to MemoryCategory::Columns until the last number standing for them
+// goes. They do not change size once made.
+std::shared_ptr<std::vector<double>> makeColumnRows(std::vector<double> rows)
 {
-    return std::abs(a - b) < std::numeric_limits<double>::epsilon();
+    const qint64 bytes = sharedBytes(qint64(sizeof(rows) + rows.capacity() * sizeof(double)));
+    accountConstruction(MemoryCategory::Columns, bytes);
+    return std::shared_ptr<std::vector<double>>(
+        new std::vector<double>(std::move(rows)), [bytes](std::vector<double>* column) {
+            accountDestruction(MemoryCategory::Columns, bytes);
+            delete column;
+        });
+}
+
+// Evaluates a completed line for every row of its columns, the shortest one sets the number of
+// rows. Ranges of rows go to the thread pool, so that long columns use every core.
+ColumnValues evaluateColumns(const core::Equation& equation,
+                             const std::vector<core::ColumnOperand>& operands, size_t rows)
+{
+    auto results = makeColumnRows(std::vector<double>(rows));
+    std::vector<size_t> firstRows((rows + g_columnRowsPerTask - 1) / g_columnRowsPerTask);
+    for (size_t task = 0; task < firstRows.size(); ++task)
+        firstRows[task] = task * g_columnRowsPerTask;
+    QtConcurrent::blockingMap(firstRows, [&](size_t first) {
+        // Rows with special values show them, the status of each row is not kept.
+        core::Status status = core::Status::Ok;
+        const size_t count = std::min(g_columnRowsPerTask, rows - first);
+        if (!core::evaluateColumn(equation, operands, first, count, results->data(), &status))
+            std::fill_n(results->begin() + first, count, 0.0);
+    });
+    return results;
 }
 } // namespace
-double Equation::calculate() const
+
+bool operatorFromText(const QString& text, core::Op* op)
+{
+    if (text == g_plus) {
+        *op = core::Op::Plus;
+    } else if (text == g_minus) {
+        *op = core::Op::Minus;
+    } else if (text == g_multiply) {
+        *op = core::Op::Multiply;
+    } else if (text == g_divide) {
+        *op = core::Op::Divide;
+    } else if (text == g_equal) {
+        *op = core::Op::Equal;
+    } else if (text == g_openParenthesis) {
+        *op = core::Op::Open;
+    } else if (text == g_closeParenthesis) {
+        *op = core::Op::Close;
+    } else if (text == g_and) {
+        *op = core::Op::And;
+    } else if (text == g_or) {
+        *op = core::Op::Or;
+    } else if (text == g_xor) {
+        *op = core::Op::Xor;
+    } else if (text == g_shiftLeft) {
+        *op = core::Op::ShiftLeft;
+    } else if (text == g_shiftRight) {
+        *op = core::Op::ShiftRight;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+double Equation::result() const
 {
-    if (size() < g_minimumElementCountToCalc)
+    if (!completed())
         throw std::invalid_argument("Invalid");
-    std::deque<std::shared_ptr<Element>> calcuationStack;
-    calcuationStack.push_back((*this)[0]);
-    for (int i = 1; i < size() - (_completed ? 3 : 1); ++i) {
-        if (calcuationStack.empty() || dynamic_cast<Operator*>((*this)[i].get())) {
-            calcuationStack.push_back((*this)[i]);
-            continue;
-        }
-        if (!calcuationStack.empty() && dynamic_cast<Operator*>(calcuationStack.back().get())) {
-            if (calcuationStack.back()->text() == g_multiply ||
-                calcuationStack.back()->text() == g_divide) {
-                const QString op = calcuationStack.back()->text();
-                calcuationStack.pop_back();
-                double value = calcuationStack.back()->text().toDouble();
-                calcuationStack.pop_back();
-                calcuationStack.push_back(std::make_shared<Number>(
-                    calculateImpl(value, static_cast<Number*>((*this)[i].get())->value(), op)));
-                continue;
+    return static_cast<Number*>(back().get())->value();
+}
+
+void Equation::syncFrom(const core::Equation& equation, ValueChanges* changes)
+{
+    const auto& tokens = equation.tokens();
+    const auto removeNumber = [changes](const Element* element) {
+        if (const auto* number = dynamic_cast<const Number*>(element))
+            changes->removed.push_back(number->value());
+    };
+    for (size_t i = tokens.size(); i < size(); ++i)
+        removeNumber((*this)[i].get());
+    if (size() > tokens.size())
+        resize(tokens.size());
+    // Tokens before the first one the core changed, or before this line's end, are up to date.
+    size_t firstChanged = size();
+    for (size_t i = std::min(equation.firstChangedToken(), size()); i < tokens.size(); ++i) {
+        const core::Token& token = tokens[i];
+        const QString text = token.isNumber ? QString::fromStdString(token.text)
+                                            : QString::fromUtf8(core::symbol(token.op));
+        const core::Status status = equation.completed() && i + 1 == tokens.size()
+                                        ? equation.status()
+                                        : core::Status::Ok;
+        auto* number = i < size() ? dynamic_cast<Number*>((*this)[i].get()) : nullptr;
+        if (i < firstChanged && (*this)[i]->text() != text)
+            firstChanged = i;
+        if (i == size()) {
+            push_back(token.isNumber ? std::shared_ptr<Element>(std::make_shared<Number>(text))
+                                     : std::make_shared<Operator>(text));
+            if (token.isNumber)
+                changes->added.push_back(static_cast<Number*>(back().get())->value());
+        } else if (token.isNumber && number) {
+            const double previous = number->value();
+            number->setText(text);
+            if (!ValueClusters::sameValue(previous, number->value())) {
+                changes->removed.push_back(previous);
+                changes->added.push_back(number->value());
             }
+        } else if (token.isNumber) {
+            (*this)[i] = std::make_shared<Number>(text);
+            changes->added.push_back(static_cast<Number*>((*this)[i].get())->value());
+        } else if (number || (*this)[i]->text() != text) {
+            removeNumber((*this)[i].get());
+            (*this)[i] = std::make_shared<Operator>(text);
+        }
+        if (token.isNumber) {
+            static_cast<Number*>((*this)[i].get())->setStatus(status);
+        } else {
+            const bool paired = core::isParenthesis(token.op) && token.partner != core::g_noPartner;
+            static_cast<Operator*>((*this)[i].get())->setPairing(int(token.depth), paired);
         }
-        calcuationStack.push_back((*this)[i]);
     }
-
-    double resultSoFar = calcuationStack.front()->text().toDouble();
-    calcuationStack.pop_front();
-    while (!calcuationStack.empty()) {
-        QString op = calcuationStack.front()->text();
-        calcuationStack.pop_front();
-        double right = calcuationStack.front()->text().toDouble();
-        calcuationStack.pop_front();
-        resultSoFar = calculateImpl(resultSoFar, right, op);
+    firstChanged = std::min(firstChanged, _textEnds.size());
+    _textEnds.resize(firstChanged);
+    _text.truncate(firstChanged > 0 ? _textEnds.back() : 0);
+    for (size_t i = firstChanged; i < size(); ++i) {
+        _text.append((*this)[i]->text());
+        _textEnds.push_back(_text.size());
     }
-    return resultSoFar;
+    _completed = equation.completed();
 }
 
-void Equation::append(uint8_t digit)
+qint64 Element::accountedBytes(size_t size) const
 {
-    if (completed())
+    return sharedBytes(objectBytes(size)) + stringBytes(_text);
+}
+
+Number::Number(const QString& text) : Element(text), _value(parseValue(text))
+{
+    accountConstruction(MemoryCategory::Elements, accountedBytes(sizeof(Number)));
+}
+
+Number::~Number() { accountDestruction(MemoryCategory::Elements, accountedBytes(sizeof(Number))); }
+
+void Number::setText(const QString& text)
+{
+    if (_text == text)
         return;
-    if (empty() || !dynamic_cast<Number*>(back().get())) {
-        push_back(std::make_shared<Number>(digit));
-    } else if (auto* casted = dynamic_cast<Number*>(back().get())) {
-        casted->appendDigit(digit);
-    }
+    const qint64 textBytes = stringBytes(_text);
+    _text = text;
+    accountResize(MemoryCategory::Elements, stringBytes(_text) - textBytes);
+    _value = parseValue(text);
+    ++_revision;
 }
 
-void Equation::append(const QString& op)
+void Number::setStatus(core::Status status)
 {
-    if (empty() || completed() || dynamic_cast<Operator*>(back().get()))
+    if (_status == status)
         return;
-    if (size() < 3 && op == g_equal)
+    _status = status;
+    ++_revision;
+}
+
+void Number::setColumn(const ColumnValues& column)
+{
+    if (_column == column)
         return;
-    push_back(std::make_shared<Operator>(op));
-    if (op == g_equal) {
-        const double result = calculate();
-        push_back(std::make_shared<Number>(result));
-        _completed = true;
-    }
+    _column = column;
+    ++_revision;
 }
 
-void Equation::appendDecimal()
+Operator::Operator(const QString& op) : Element(op)
 {
-    if (completed())
+    accountConstruction(MemoryCategory::Elements, accountedBytes(sizeof(Operator)));
+}
+
+Operator::~Operator()
+{
+    accountDestruction(MemoryCategory::Elements, accountedBytes(sizeof(Operator)));
+}
+
+void Operator::setPairing(int depth, bool paired)
+{
+    if (_depth == depth && _paired == paired)
         return;
-    if (empty() || !dynamic_cast<Number*>(back().get())) {
-        auto number = std::make_shared<Number>(0);
-        number->appendDecimal();
-        push_back(number);
-    } else if (dynamic_cast<Number*>(back().get())) {
-        dynamic_cast<Number*>(back().get())->appendDecimal();
-    }
+    _depth = depth;
+    _paired = paired;
+    ++_revision;
 }
 
-QString Equation::text() const
+EquationQueue::EquationQueue(size_t sizeLimit) : _history(sizeLimit)
 {
-    QString result;
-    for (const auto& element : *this) {
-        result.append(element->text());
-    }
-    return result;
+    _history.setCompletionObserver([this](size_t id, const core::Equation& equation) {
+        _index.add(id, equation.result(), QString::fromStdString(equation.text()));
+        _resultSeries.append(equation.result());
+        emit equationCompleted(equation);
+    });
 }
 
-bool Equation::tryPopCharacter()
+void EquationQueue::append(uint8_t digit)
 {
-    if (empty())
-        return true;
-    if (dynamic_cast<Operator*>(back().get())) {
-        pop_back();
-        return true;
-    }
-    auto* const number = static_cast<Number*>(back().get());
-    QString numberText = number->text();
-    if (numberText.isEmpty()) {
-        pop_back();
-        return tryPopCharacter();
-    }
-    numberText.resize(numberText.size() - 1);
-    const bool successful = number->trySetValue(numberText);
-    if (!successful) {
-        pop_back();
-    }
-    return true;
+    _history.append(digit);
+    sync();
 }
 
-Number::Number(double v) : Element(QString::number(v, 'g', 15)) {}
+void EquationQueue::appendDicimal()
+{
+    _history.appendDecimal();
+    sync();
+}
 
-void Number::setValue(double v)
+void EquationQueue::append(const QString& op)
 {
-    auto text = QString::number(v, 'g', 15);
-    if (_text == text)
+    core::Op coreOp;
+    if (!operatorFromText(op, &coreOp))
         return;
-    _text = text;
-    emit changed();
+    _history.append(coreOp);
+    sync();
 }
 
-bool Number::trySetValue(const QString& s)
+void EquationQueue::tryPopLastCharacter()
+{
+    _history.tryPopLastCharacter();
+    sync();
+}
+
+void EquationQueue::appendCompleted(std::vector<core::Equation> equations)
+{
+    if (equations.empty())
+        return;
+    _history.appendCompleted(std::move(equations));
+    sync();
+}
+
+void EquationQueue::toggleSign()
+{
+    _history.toggleSign();
+    sync();
+}
+
+void EquationQueue::applyPercent()
+{
+    _history.applyPercent();
+    sync();
+}
+
+void EquationQueue::clearEntry()
+{
+    _history.clearEntry();
+    sync();
+}
+
+void EquationQueue::clear()
 {
-    bool ok;
-    s.toDouble(&ok);
-    if (!ok)
+    _history.clear();
+    sync();
+}
+
+bool EquationQueue::editNumber(size_t id, size_t tokenIndex, const QString& text)
+{
+    std::vector<size_t> changedIds;
+    if (!_history.editNumber(id, tokenIndex, text.toStdString(), &changedIds))
         return false;
-    _text = s;
-    emit changed();
+    if (changedIds.empty())
+        return true;
+    // Each edited line leaves the index with its old result and text and comes back with the new.
+    for (const size_t changedId : changedIds) {
+        const size_t position = changedId - firstId();
+        _index.remove(changedId);
+        syncLine(position, _history.at(changedId));
+        if ((*this)[position].completed())
+            _index.add(changedId, (*this)[position].result(), (*this)[position].text());
+    }
+    updateResultSeries(changedIds);
+    emit linesEdited(changedIds);
+    notifyChanged();
     return true;
 }
 
-void Number::appendDigit(uint8_t digit)
+bool EquationQueue::appendColumn(std::vector<double> values)
 {
-    assert(digit >= 0 && digit <= 9);
-    _text += QString::number(digit, 'g', 15);
-    emit changed();
+    if (values.empty() || arithmetic() == core::Arithmetic::Integer)
+        return false;
+    const std::string text = core::formatNumber(values.front());
+    if (!_history.appendNumber(text))
+        return false;
+    if (values.size() > 1) {
+        const size_t id = _history.firstId() + _history.size() - 1;
+        _columns[id].operands.push_back(
+            {_history.back().size() - 1, text,
+             makeColumnRows(std::move(values))});
+    }
+    sync();
+    return true;
 }
 
-void Number::appendDecimal()
+void EquationQueue::beginBatch() { ++_batchDepth; }
+
+void EquationQueue::endBatch()
 {
-    bool ok;
-    const QString newText = _text + QChar('.');
-    auto parsed = newText.toDouble(&ok);
-    if (ok) {
-        _text = newText;
+    assert(_batchDepth > 0);
+    if (--_batchDepth == 0 && _changePending) {
+        _changePending = false;
         emit changed();
     }
 }
 
-bool operator==(const Number &a, const Number &b)
+// Typing only edits the last line, appends or drops lines from the front, so the lines before the
+// previous last one are already up to date. editNumber() syncs the older lines it recomputes.
+void EquationQueue::sync()
 {
-    return std::abs(a._text.toDouble() - b._text.toDouble()) < std::numeric_limits<double>::epsilon();
+    // The values of dropped lines leave their clusters after the new lines joined them, so that
+    // a value carried into a new line keeps its color.
+    std::vector<Equation> dropped;
+    while (!empty() && _firstLineId < _history.firstId()) {
+        _textSize -= lineTextSize(front());
+        dropped.push_back(std::move(front()));
+        pop_front();
+        ++_firstLineId;
+    }
+    if (empty())
+        _firstLineId = _history.firstId();
+    while (size() > _history.size()) {
+        _textSize -= lineTextSize(back());
+        dropped.push_back(std::move(back()));
+        pop_back();
+    }
+    _columns.erase(_columns.begin(), _columns.lower_bound(_history.firstId()));
+    _columns.erase(_columns.lower_bound(_history.firstId() + _history.size()), _columns.end());
+    for (size_t i = empty() ? 0 : size() - 1; i < _history.size(); ++i) {
+        if (i == size())
+            emplace_back();
+        syncLine(i, _history[i]);
+    }
+    for (const Equation& line : dropped)
+        countValues(line, false);
+    _index.removeBefore(_history.firstId());
+    notifyChanged();
 }
 
-Operator::Operator(const QString& op) : Element(op) {}
+void EquationQueue::syncLine(size_t position, const core::Equation& equation)
+{
+    Equation& line = (*this)[position];
+    _textSize -= lineTextSize(line);
+    Equation::ValueChanges changes;
+    line.syncFrom(equation, &changes);
+    _textSize += lineTextSize(line);
+    // Added first, so that a value the line keeps never leaves its cluster and frees its color.
+    for (const double value : changes.added)
+        _valueClusters.add(value);
+    for (const double value : changes.removed)
+        _valueClusters.remove(value);
+    syncColumns(position, equation);
+    _history.clearChanges(firstId() + position);
+}
 
-void EquationQueue::append(uint8_t digit)
+// A column stays with its number while the number keeps the text of the first row, results
+// are evaluated again whenever the completed line's text or one of its columns changes.
+void EquationQueue::syncColumns(size_t position, const core::Equation& equation)
 {
-    assert(digit >= 0 && digit <= 9);
-    if (empty() || back().completed()) {
-        Equation equation;
-        equation.append(digit);
-        push_back(equation);
-    } else {
-        back().append(digit);
+    const size_t id = firstId() + position;
+    const auto& tokens = equation.tokens();
+    auto found = _columns.find(id);
+    if (found != _columns.end()) {
+        auto& operands = found->second.operands;
+        operands.erase(std::remove_if(operands.begin(), operands.end(),
+                                      [&tokens](const ColumnOperand& operand) {
+                                          return operand.token >= tokens.size() ||
+                                                 !tokens[operand.token].isNumber ||
+                                                 tokens[operand.token].text != operand.text;
+                                      }),
+                       operands.end());
+        if (operands.empty()) {
+            _columns.erase(found);
+            found = _columns.end();
+        }
+    }
+    // The first number is still the result of a column line: it stands for all of its results.
+    const auto source = _columns.find(equation.source());
+    if (source != _columns.end() && source->second.results && !tokens.empty() &&
+        _history.contains(equation.source()) &&
+        tokens.front().text == _history.at(equation.source()).back().text) {
+        if (found == _columns.end())
+            found = _columns.emplace(id, ColumnLine()).first;
+        auto& operands = found->second.operands;
+        auto first = std::find_if(operands.begin(), operands.end(),
+                                  [](const ColumnOperand& operand) { return operand.token == 0; });
+        if (first == operands.end())
+            first = operands.insert(operands.end(), ColumnOperand{0, tokens.front().text, nullptr});
+        if (first->values != source->second.results) {
+            first->values = source->second.results;
+            found->second.evaluatedText.clear();
+        }
+    }
+    ColumnLine* columns = found != _columns.end() ? &found->second : nullptr;
+    if (columns && !equation.completed()) {
+        columns->results.reset();
+        columns->evaluatedText.clear();
+    } else if (columns && columns->evaluatedText != equation.text()) {
+        std::vector<core::ColumnOperand> operands;
+        size_t rows = columns->operands.front().values->size();
+        for (const ColumnOperand& operand : columns->operands) {
+            operands.push_back({operand.token, operand.values->data()});
+            rows = std::min(rows, operand.values->size());
+        }
+        columns->results = evaluateColumns(equation, operands, rows);
+        columns->evaluatedText = equation.text();
+    }
+
+    Equation& line = (*this)[position];
+    for (size_t i = 0; i < line.size(); ++i) {
+        auto* number = dynamic_cast<Number*>(line[i].get());
+        if (!number)
+            continue;
+        ColumnValues column;
+        if (columns && equation.completed() && i + 1 == line.size())
+            column = columns->results;
+        for (size_t j = 0; columns && !column && j < columns->operands.size(); ++j) {
+            if (columns->operands[j].token == i)
+                column = columns->operands[j].values;
+        }
+        number->setColumn(column);
     }
-    popFrontIfExceedLimit();
-    emit changed();
 }
 
-void EquationQueue::appendDicimal()
+void EquationQueue::countValues(const Equation& line, bool add)
 {
-    if (empty() || back().completed()) {
-        emplace_back();
+    for (const auto& element : line) {
+        const auto* number = dynamic_cast<const Number*>(element.get());
+        if (!number)
+            continue;
+        if (add)
+            _valueClusters.add(number->value());
+        else
+            _valueClusters.remove(number->value());
     }
-    back().appendDecimal();
-    popFrontIfExceedLimit();
-    emit changed();
 }
 
-void EquationQueue::append(const QString& op)
+// Lines complete in identifier order, so the completed lines still kept are the tail of the
+// series. ids are in ascending order.
+void EquationQueue::updateResultSeries(const std::vector<size_t>& ids)
 {
-    if (empty())
-        return;
-    if (back().completed()) {
-        Equation equation;
-        equation.push_back(
-            std::make_shared<Number>(static_cast<Number*>(back().back().get())->value()));
-        equation.append(op);
-        push_back((equation));
-        popFrontIfExceedLimit();
-        emit changed();
-        return;
+    size_t index = _resultSeries.size();
+    auto id = ids.rbegin();
+    for (size_t i = _history.size(); i-- > 0 && id != ids.rend();) {
+        const size_t lineId = _history.firstId() + i;
+        while (id != ids.rend() && *id > lineId)
+            ++id;
+        if (!_history[i].completed())
+            continue;
+        --index;
+        if (id != ids.rend() && *id == lineId)
+            _resultSeries.set(index, _history[i].result());
     }
-    back().append(op);
-    popFrontIfExceedLimit();
-    emit changed();
 }
 
-void EquationQueue::tryPopLastCharacter()
+void EquationQueue::notifyChanged()
 {
-    if (empty() || back().completed() || back().empty())
+    if (_batchDepth > 0) {
+        _changePending = true;
         return;
-    back().tryPopCharacter();
+    }
     emit changed();
 }
 
-void EquationQueue::popFrontIfExceedLimit()
-{
-    while (size() > _sizeLimit)
-        pop_front();
-}
-
 QString EquationQueue::text() const
 {
     QString result;
-    for (const auto& e : *this) {
-        result.append(e.text());
-        if (e.completed()) {
-            result.append('\n');
-        }
-    }
+    result.reserve(_textSize);
+    forEachTextChunk([&result](const QString& chunk) { result.append(chunk); });
     return result;
 }
@@ -3,83 +3,225 @@
 
 #include <QObject>
 #include <QString>
+#include <cstdint>
 #include <deque>
+#include <map>
 #include <memory>
+#include <vector>
 
+#include "core/history.h"
+#include "core/result_series.h"
+#include "history_index.h"
+#include "value_clusters.h"
+
+// Elements do not signal their edits: every edit bumps revision(), which displays compare
+// against the one they last showed when the display lays out its next frame.
 class Element : public QObject
 {
     Q_OBJECT
 public:
     virtual ~Element() = default;
     virtual QString text() const { return _text; }
-
-signals:
-    void changed();
+    uint64_t revision() const { return _revision; }
 
 protected:
     Element() = default;
     explicit Element(const QString& text): _text(text) {}
+    // The estimated bytes of an element of size bytes made by std::make_shared, with its text,
+    // as reported to MemoryCategory::Elements.
+    qint64 accountedBytes(size_t size) const;
     QString _text;
+    uint64_t _revision = 0;
 };
 
-// this implementation will loss precision!
+// The rows of a number in column mode, the first one is the number's own value.
+using ColumnValues = std::shared_ptr<const std::vector<double>>;
+
+// Holds the number text shown in the history and the value parsed from it whenever it is set,
+// so that painting and recalculation never parse text.
 class Number : public Element
 {
 public:
-    explicit Number(double v);
-    ~Number() = default;
-
-    double value() const { return _text.toDouble(); }
-    void setValue(double v);
-    bool trySetValue(const QString& s);
-    void appendDigit(uint8_t digit);
-    void appendDecimal();
-    friend bool operator==(const Number& a, const Number& b);
+    explicit Number(const QString& text);
+    ~Number();
+
+    double value() const { return _value; }
+    void setText(const QString& text);
+    // Status of the equation when this number is its result, Status::Ok otherwise.
+    core::Status status() const { return _status; }
+    void setStatus(core::Status status);
+    // Null unless the number stands for a column, see EquationQueue::appendColumn().
+    const ColumnValues& column() const { return _column; }
+    void setColumn(const ColumnValues& column);
+
+private:
+    double _value = 0;
+    core::Status _status = core::Status::Ok;
+    ColumnValues _column;
 };
 
 class Operator : public Element
 {
 public:
     explicit Operator(const QString& op);
-    ~Operator() = default;
+    ~Operator();
+
+    // For parentheses: the nesting depth and whether the matching one has been typed, as the
+    // core pairs them while the line is typed.
+    int depth() const { return _depth; }
+    bool paired() const { return _paired; }
+    void setPairing(int depth, bool paired);
+
+private:
+    int _depth = 0;
+    bool _paired = false;
 };
 
+// Maps the operator texts g_plus ... g_closeParenthesis and g_and ... g_shiftRight to the core
+// operators.
+bool operatorFromText(const QString& text, core::Op* op);
+
+// The displayable form of a core::Equation: one Element per token, so that displays can follow
+// individual numbers as they are edited. Arithmetic is done by the core.
 class Equation : public std::vector<std::shared_ptr<Element>>
 {
 public:
     Equation() = default;
-    double calculate() const;
-    QString text() const;
+    double result() const;
+    // The element texts concatenated, kept by syncFrom() so that reading it copies nothing.
+    const QString& text() const { return _text; }
     bool completed() const { return _completed; }
 
-    void append(uint8_t digit);
-    void append(const QString& op);
-    void appendDecimal();
-    bool tryPopCharacter();
+    // Values of the numbers a syncFrom() took away and brought in, a number whose value did not
+    // change is in neither.
+    struct ValueChanges
+    {
+        std::vector<double> added;
+        std::vector<double> removed;
+    };
+
+    // Updates the elements to show equation from its first changed token on, keeping those whose
+    // kind did not change, and rewrites the text from the first element whose text changed.
+    void syncFrom(const core::Equation& equation, ValueChanges* changes);
 
 private:
+    QString _text;
+    // End of each element's text within _text.
+    std::vector<qsizetype> _textEnds;
     bool _completed = false;
 };
 
+// Adapts a core::History to the GUI: edits are forwarded to the history and the affected lines
+// are mirrored into Equations, so only the lines that are kept get Elements.
 class EquationQueue : public QObject, public std::deque<Equation>
 {
     Q_OBJECT
 public:
-    explicit EquationQueue(size_t sizeLimit = 32) : std::deque<Equation>(), _sizeLimit(sizeLimit){};
+    explicit EquationQueue(size_t sizeLimit = 32);
 
+    // The lines, each completed one followed by '\n', in a single allocation of textSize().
     QString text() const;
+    qsizetype textSize() const { return _textSize; }
+    // Calls chunk with each line's text and line break in order, without copying. The
+    // references are valid until the next edit.
+    template<typename Function>
+    void forEachTextChunk(Function chunk) const;
+    const core::History& history() const { return _history; }
+    const core::RunningStatistics& statistics() const { return _history.statistics(); }
+    const HistoryIndex& index() const { return _index; }
+    // Clusters of the values of all numbers in the lines.
+    const ValueClusters& valueClusters() const { return _valueClusters; }
+    // The result of every line completed in this session in order, evicted and cleared lines
+    // included; edits of kept lines update their results.
+    const core::ResultSeries& resultSeries() const { return _resultSeries; }
+    // Identifier of front(), identifiers keep increasing across evictions and clears.
+    size_t firstId() const { return _history.firstId(); }
+    core::Arithmetic arithmetic() const { return _history.arithmetic(); }
+    void setArithmetic(core::Arithmetic arithmetic) { _history.setArithmetic(arithmetic); }
+    core::Base base() const { return _history.base(); }
+    void setBase(core::Base base) { _history.setBase(base); }
 
     void append(uint8_t digit);
     void appendDicimal();
     void append(const QString& op);
     void tryPopLastCharacter();
+    // Appends already completed equations with a single change notification.
+    void appendCompleted(std::vector<core::Equation> equations);
+    void toggleSign();
+    void applyPercent();
+    // Clears the current line, or starts a new one after a completed line, or clears the whole
+    // history when the current line is already empty.
+    void clearEntry();
+    void clear();
+    // Replaces a number of a completed line and recomputes the lines continuing from its
+    // result, see core::History::editNumber().
+    bool editNumber(size_t id, size_t tokenIndex, const QString& text);
+    // Column mode: appends the first of values, which keep 15 significant digits like any
+    // number in the history, as a number that stands for all of them. Once its line completes,
+    // the line is evaluated for every row and its result stands for the results of all rows;
+    // a line continuing from that result takes them along. A number stops standing for a
+    // column as soon as its text changes. Fails where no number can be appended and in
+    // programmer mode, whose integers columns of doubles do not fit.
+    bool appendColumn(std::vector<double> values);
+
+    // changed() is emitted once when the outermost batch ends instead of once per edit. Displays
+    // collect it into their next frame either way.
+    void beginBatch();
+    void endBatch();
 
 signals:
     void changed();
+    void equationCompleted(const core::Equation& equation);
+    // Emitted before changed() with the identifiers of the lines an edit recomputed.
+    void linesEdited(const std::vector<size_t>& ids);
 
 private:
-    void popFrontIfExceedLimit();
-
-    size_t _sizeLimit;
+    struct ColumnOperand
+    {
+        size_t token;
+        // The number text of the first row, the column is dropped once the token differs.
+        std::string text;
+        ColumnValues values;
+    };
+
+    struct ColumnLine
+    {
+        std::vector<ColumnOperand> operands;
+        // The completed line the results were evaluated for.
+        std::string evaluatedText;
+        ColumnValues results;
+    };
+
+    void sync();
+    // Updates the line at position, keeping textSize() and the value clusters up to date.
+    void syncLine(size_t position, const core::Equation& equation);
+    // Keeps the columns of the line at position in step with its tokens and hands them to its
+    // numbers.
+    void syncColumns(size_t position, const core::Equation& equation);
+    void countValues(const Equation& line, bool add);
+    void updateResultSeries(const std::vector<size_t>& ids);
+    void notifyChanged();
+
+    core::History _history;
+    size_t _firstLineId = 0;
+    int _batchDepth = 0;
+    bool _changePending = false;
+    qsizetype _textSize = 0;
+    HistoryIndex _index;
+    ValueClusters _valueClusters;
+    core::ResultSeries _resultSeries;
+    // Line identifier to the columns of that line.
+    std::map<size_t, ColumnLine> _columns;
 };
+
+template<typename Function>
+void EquationQueue::forEachTextChunk(Function chunk) const
+{
+    static const QString lineBreak("\n");
+    for (const Equation& equation : *this) {
+        chunk(equation.text());
+        if (equation.completed())
+            chunk(lineBreak);
+    }
+}
 #endif // MATH_ELEMENTS_H
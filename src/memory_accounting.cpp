@@ -0,0 +1,106 @@
+#include <array>
+#include <atomic>
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtDebug>
+
+#include "memory_accounting.h"
+
+namespace {
+const char g_memoryDumpVariable[] = "CALCULATOR_MEMORY_DUMP";
+constexpr std::array<const char*, size_t(MemoryCategory::Count)> g_categoryNames = {
+    "elements", "columns", "elementDisplays", "elementPaths"};
+// QObjectPrivate, and QLabelPrivate with the QWidgetData and extra data a label allocates.
+constexpr qint64 g_objectPrivateBytes = 120;
+constexpr qint64 g_labelPrivateBytes = 1024;
+// Vtable pointer and use and weak counts.
+constexpr qint64 g_sharedControlBytes = sizeof(void*) + 2 * sizeof(int);
+
+struct Counter
+{
+    std::atomic<qint64> count{0};
+    std::atomic<qint64> bytes{0};
+};
+
+std::array<Counter, size_t(MemoryCategory::Count)> g_counters;
+
+QJsonObject toJson(const MemoryUsage& usage)
+{
+    return {{QStringLiteral("count"), usage.count}, {QStringLiteral("bytes"), usage.bytes}};
+}
+} // namespace
+
+void accountConstruction(MemoryCategory category, qint64 bytes)
+{
+    Counter& counter = g_counters[size_t(category)];
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+    counter.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void accountDestruction(MemoryCategory category, qint64 bytes)
+{
+    Counter& counter = g_counters[size_t(category)];
+    counter.count.fetch_sub(1, std::memory_order_relaxed);
+    counter.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void accountResize(MemoryCategory category, qint64 difference)
+{
+    g_counters[size_t(category)].bytes.fetch_add(difference, std::memory_order_relaxed);
+}
+
+MemoryUsage memoryUsage(MemoryCategory category)
+{
+    const Counter& counter = g_counters[size_t(category)];
+    return {counter.count.load(std::memory_order_relaxed),
+            counter.bytes.load(std::memory_order_relaxed)};
+}
+
+MemoryUsage totalMemoryUsage()
+{
+    MemoryUsage total;
+    for (size_t i = 0; i < size_t(MemoryCategory::Count); ++i) {
+        const MemoryUsage usage = memoryUsage(MemoryCategory(i));
+        total.count += usage.count;
+        total.bytes += usage.bytes;
+    }
+    return total;
+}
+
+const char* memoryCategoryName(MemoryCategory category)
+{
+    return g_categoryNames[size_t(category)];
+}
+
+QByteArray memoryUsageJson()
+{
+    QJsonObject json;
+    for (size_t i = 0; i < size_t(MemoryCategory::Count); ++i)
+        json.insert(QLatin1String(g_categoryNames[i]), toJson(memoryUsage(MemoryCategory(i))));
+    json.insert(QStringLiteral("total"), toJson(totalMemoryUsage()));
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+void dumpMemoryUsage()
+{
+    const QString path = qEnvironmentVariable(g_memoryDumpVariable);
+    if (path.isEmpty())
+        return;
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(memoryUsageJson() + '\n') < 0)
+        qWarning() << "Failed to write memory usage to" << path;
+}
+
+qint64 objectBytes(size_t size) { return qint64(size) + g_objectPrivateBytes; }
+
+qint64 labelBytes(size_t size) { return qint64(size) + g_labelPrivateBytes; }
+
+qint64 sharedBytes(qint64 bytes) { return bytes + g_sharedControlBytes; }
+
+qint64 stringBytes(const QString& text)
+{
+    return text.capacity() > 0 ? qint64(sizeof(QArrayData) + text.capacity() * sizeof(QChar)) : 0;
+}
@@ -0,0 +1,43 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <QByteArray>
+#include <QString>
+#include <cstddef>
+
+// Kinds of objects a session accumulates, counted while they are alive.
+enum class MemoryCategory { Elements, Columns, ElementDisplays, ElementPaths, Count };
+
+struct MemoryUsage
+{
+    qint64 count = 0;
+    qint64 bytes = 0;
+};
+
+// Constructors and destructors report their object with the bytes it is estimated to hold,
+// objects that grow or shrink while alive report the difference. The counters are atomic, as
+// column rows may be released on the thread pool.
+void accountConstruction(MemoryCategory category, qint64 bytes);
+void accountDestruction(MemoryCategory category, qint64 bytes);
+void accountResize(MemoryCategory category, qint64 difference);
+
+MemoryUsage memoryUsage(MemoryCategory category);
+MemoryUsage totalMemoryUsage();
+// "elements", "columns", "elementDisplays" or "elementPaths".
+const char* memoryCategoryName(MemoryCategory category);
+// {"elements": {"count": 12, "bytes": 3456}, ..., "total": {"count": ..., "bytes": ...}}
+QByteArray memoryUsageJson();
+// Writes memoryUsageJson() to the file named by the CALCULATOR_MEMORY_DUMP environment variable,
+// if it is set.
+void dumpMemoryUsage();
+
+// Estimates of what an object of size bytes holds: Qt does not expose the size of the private
+// data behind a QObject or a QLabel, so those are rough figures for 64-bit Qt 6.
+qint64 objectBytes(size_t size);
+qint64 labelBytes(size_t size);
+// The control block of a std::make_shared allocation, next to the object.
+qint64 sharedBytes(qint64 bytes);
+// The heap block of a QString that is not shared with another.
+qint64 stringBytes(const QString& text);
+
+#endif // MEMORY_ACCOUNTING_H
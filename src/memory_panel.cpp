@@ -0,0 +1,55 @@
+#include <QStringBuilder>
+
+#include "display.h"
+#include "memory_accounting.h"
+#include "memory_panel.h"
+
+namespace {
+constexpr int g_panelMargin = 6;
+const QString g_panelStyleSheet(QStringLiteral("QLabel{"
+                                               "background-color: rgba(241, 241, 241, 230);"
+                                               "border: 1px solid rgb(196, 199, 199);"
+                                               "border-radius: 6px;"
+                                               "padding: 3px;"
+                                               "color: rgb(68, 68, 68);}"));
+const QString g_memoryTitle("Memory (estimated)");
+
+QString formatUsage(const char* name, const MemoryUsage& usage)
+{
+    return QLatin1String(name) % QStringLiteral(" ") % QString::number(usage.count) %
+           QStringLiteral(" · ") % QString::number(usage.bytes / 1024.0, 'f', 1) %
+           QStringLiteral(" KB");
+}
+} // namespace
+
+MemoryPanel::MemoryPanel(Display* display, QWidget* parent) : QLabel(parent)
+{
+    setStyleSheet(g_panelStyleSheet);
+    setTextFormat(Qt::PlainText);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    connect(display, &Display::linesChanged, this, &MemoryPanel::refresh);
+}
+
+void MemoryPanel::refresh()
+{
+    if (!isVisible())
+        return;
+    QString text = g_memoryTitle;
+    for (size_t i = 0; i < size_t(MemoryCategory::Count); ++i) {
+        const auto category = MemoryCategory(i);
+        text += QChar('\n') % formatUsage(memoryCategoryName(category), memoryUsage(category));
+    }
+    text += QChar('\n') % formatUsage("total", totalMemoryUsage());
+    setText(text);
+    adjustSize();
+    move(parentWidget()->width() - width() - g_panelMargin,
+         (parentWidget()->height() - height()) / 2);
+}
+
+void MemoryPanel::showEvent(QShowEvent* event)
+{
+    QLabel::showEvent(event);
+    refresh();
+}
+
+#include "moc_memory_panel.cpp"
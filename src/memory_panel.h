@@ -0,0 +1,23 @@
+#ifndef MEMORY_PANEL_H
+#define MEMORY_PANEL_H
+
+#include <QLabel>
+
+class Display;
+
+// Lists the live objects and estimated bytes of each MemoryCategory, refreshed as the display
+// lays out lines, see memory_accounting.h.
+class MemoryPanel : public QLabel
+{
+    Q_OBJECT
+public:
+    MemoryPanel(Display* display, QWidget* parent);
+
+public slots:
+    void refresh();
+
+protected:
+    void showEvent(QShowEvent* event) override;
+};
+
+#endif // MEMORY_PANEL_H
@@ -2,27 +2,107 @@
 #include "ui_menu.h"
 #include <QGraphicsBlurEffect>
 #include <QPainter>
+#include <iterator>
+
+extern const QString g_menuStyleSheet(QStringLiteral("QFrame#Menu{"
+                                                     "border-width: 4px;"
+                                                     "background-color: rgb(241, 241, 241);"
+                                                     "border: 1px solid;"
+                                                     "border-color: rgb(196, 199, 199);"
+                                                     "border-top-right-radius: 6px;"
+                                                     "border-bottom-right-radius: 6px;"
+                                                     "border-left-width: 0px;"
+                                                     "}"
+                                                     "QToolButton{"
+                                                     "background-color: rgb(241, 241, 241);"
+                                                     "border: 1px solid rgb(0, 0, 0, 0);"
+                                                     "border-radius: 4px;"
+                                                     "qproperty-iconSize: 24px;"
+                                                     "}"
+                                                     "QToolButton:checked{"
+                                                     "border: 1px solid rgb(196, 196, 196);"
+                                                     "}"
+                                                     "QToolButton:hover{"
+                                                     "background-color: rgb(229, 229, 229);"
+                                                     "}"
+                                                     "QToolButton:hover:checked{"
+                                                     "border: 1px solid rgb(196, 196, 196);"
+                                                     "}"
+                                                     "QToolButton:pressed{"
+                                                     "background-color: rgba(120, 120, 120, 50);"
+                                                     "}"));
 
 namespace {
-constexpr QSize g_menuSize(43, 142);
+constexpr QSize g_menuSize(43, 373);
 const QString g_copiedText = "Copied!";
+// The base button steps through these in programmer mode and shows the current one.
+constexpr core::Base g_bases[] = {core::Base::Decimal, core::Base::Hexadecimal,
+                                  core::Base::Octal, core::Base::Binary};
+const QString g_baseNames[] = {"DEC", "HEX", "OCT", "BIN"};
 }
 
 Menu::Menu(QWidget* parent) : QFrame(parent), ui(new Ui::Menu)
 {
     ui->setupUi(this);
+    setStyleSheet(g_menuStyleSheet);
     setFixedSize(g_menuSize);
     QIcon icon;
     icon.addFile(QString::fromUtf8(":/Button/correct.png"), QSize(), QIcon::Normal, QIcon::Off);
     ui->copyButton->setClickedIcon(icon);
-    ui->copyButton->bubbleWidget()->setBoundary(parent);
-    ui->copyButton->bubbleWidget()->setText(g_copiedText);
+    ui->copyButton->setBubbleBoundary(parent);
+    ui->copyButton->setBubbleText(g_copiedText);
 }
 
 Menu::~Menu() { delete ui; }
 
+void Menu::raiseBubble() { ui->copyButton->raiseBubble(); }
+
+// The copy button's bubble lives in the parent, so it follows the menu as it slides.
+void Menu::moveEvent(QMoveEvent* event)
+{
+    ui->copyButton->followBubble();
+    QFrame::moveEvent(event);
+}
+
 void Menu::on_clearButton_clicked() { emit clearButtonClicked(); }
 
 void Menu::on_connectionSwitch_toggled(bool checked) { emit connectionButtonToggled(checked); }
 
 void Menu::on_copyButton_clicked() { emit copyButtonClicked(); }
+
+void Menu::on_statisticsButton_toggled(bool checked) { emit statisticsButtonToggled(checked); }
+
+void Menu::on_plotButton_toggled(bool checked) { emit plotButtonToggled(checked); }
+
+void Menu::on_memoryButton_toggled(bool checked) { emit memoryButtonToggled(checked); }
+
+void Menu::on_searchButton_toggled(bool checked) { emit searchButtonToggled(checked); }
+
+void Menu::on_exactButton_toggled(bool checked)
+{
+    if (checked)
+        ui->integerButton->setChecked(false);
+    emit arithmeticChanged(arithmetic());
+}
+
+void Menu::on_integerButton_toggled(bool checked)
+{
+    if (checked)
+        ui->exactButton->setChecked(false);
+    ui->baseButton->setEnabled(checked);
+    emit arithmeticChanged(arithmetic());
+}
+
+void Menu::on_baseButton_clicked()
+{
+    _baseIndex = (_baseIndex + 1) % std::size(g_bases);
+    ui->baseButton->setText(g_baseNames[_baseIndex]);
+    emit baseChanged(g_bases[_baseIndex]);
+}
+
+core::Arithmetic Menu::arithmetic() const
+{
+    if (ui->integerButton->isChecked())
+        return core::Arithmetic::Integer;
+    return ui->exactButton->isChecked() ? core::Arithmetic::Exact : core::Arithmetic::Double;
+}
@@ -4,12 +4,17 @@
 #include <QWidget>
 #include <QFrame>
 
+#include "core/equation.h"
+
 namespace Ui {
 class Menu;
 }
 
 class QAbstractButton;
 
+// Style of the menu and its tool buttons.
+extern const QString g_menuStyleSheet;
+
 class Menu : public QFrame
 {
     Q_OBJECT
@@ -17,19 +22,41 @@ class Menu : public QFrame
 public:
     explicit Menu(QWidget* parent = nullptr);
     ~Menu();
+    // Raises the copy button's bubble, which lives in the parent, above its other children.
+    void raiseBubble();
+
+protected:
+    void moveEvent(QMoveEvent* event) override;
 
 signals:
     void copyButtonClicked();
     void connectionButtonToggled(bool checked);
     void clearButtonClicked();
+    void statisticsButtonToggled(bool checked);
+    void plotButtonToggled(bool checked);
+    void memoryButtonToggled(bool checked);
+    void searchButtonToggled(bool checked);
+    // Exact and programmer mode exclude each other, Double when neither is checked.
+    void arithmeticChanged(core::Arithmetic arithmetic);
+    void baseChanged(core::Base base);
 
 private slots:
     void on_clearButton_clicked();
     void on_connectionSwitch_toggled(bool checked);
     void on_copyButton_clicked();
+    void on_statisticsButton_toggled(bool checked);
+    void on_plotButton_toggled(bool checked);
+    void on_memoryButton_toggled(bool checked);
+    void on_searchButton_toggled(bool checked);
+    void on_exactButton_toggled(bool checked);
+    void on_integerButton_toggled(bool checked);
+    void on_baseButton_clicked();
 
 private:
+    core::Arithmetic arithmetic() const;
+
     Ui::Menu* ui;
+    size_t _baseIndex = 0;
 };
 
 #endif // MENU_H
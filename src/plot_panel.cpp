@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <cmath>
+
+#include <QEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPolygonF>
+#include <QWheelEvent>
+
+#include "core/result_series.h"
+#include "display.h"
+#include "plot_panel.h"
+
+namespace {
+constexpr int g_panelMargin = 6;
+constexpr int g_plotPadding = 8;
+constexpr int g_minPanelHeight = 120;
+constexpr double g_panelHeightRatio = 0.4;
+constexpr double g_zoomPerStep = 0.8;
+// The fewest results a view zooms in to.
+constexpr double g_minSpan = 2;
+constexpr QColor g_backgroundColor(241, 241, 241, 230);
+constexpr QColor g_borderColor(196, 199, 199);
+constexpr QColor g_textColor(68, 68, 68);
+constexpr QColor g_lineColor(41, 98, 255);
+const QString g_emptyText("No results to plot");
+
+QString formatValue(double v) { return QString::number(v, 'g', 10); }
+} // namespace
+
+PlotPanel::PlotPanel(Display* display, QWidget* parent) : QWidget(parent), _display(display)
+{
+    setCursor(Qt::OpenHandCursor);
+    parent->installEventFilter(this);
+    connect(display, &Display::linesChanged, this, &PlotPanel::refresh);
+}
+
+void PlotPanel::refresh()
+{
+    if (isVisible())
+        update();
+}
+
+const core::ResultSeries* PlotPanel::series() const
+{
+    if (!_display || !_display->equations())
+        return nullptr;
+    return &_display->equations()->resultSeries();
+}
+
+QRectF PlotPanel::plotArea() const
+{
+    const int textHeight = fontMetrics().height();
+    return QRectF(rect()).adjusted(g_plotPadding, g_plotPadding + textHeight, -g_plotPadding,
+                                   -g_plotPadding - textHeight);
+}
+
+void PlotPanel::view(double* first, double* span) const
+{
+    const double count = series() ? double(series()->size()) : 0;
+    if (_showAll || _span >= count) {
+        *first = 0;
+        *span = std::max(count, 1.0);
+    } else {
+        *span = _span;
+        *first = _follow ? count - _span : std::clamp(_first, 0.0, count - _span);
+    }
+}
+
+void PlotPanel::setView(double first, double span)
+{
+    const double count = series() ? double(series()->size()) : 0;
+    span = std::max(span, std::min(g_minSpan, count));
+    _showAll = span >= count;
+    if (!_showAll) {
+        _span = span;
+        _first = std::clamp(first, 0.0, count - span);
+        _follow = _first + _span >= count;
+    }
+    update();
+}
+
+void PlotPanel::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(g_borderColor);
+    painter.setBrush(g_backgroundColor);
+    painter.drawRoundedRect(QRectF(rect()).adjusted(0.5, 0.5, -0.5, -0.5), 6, 6);
+
+    const core::ResultSeries* results = series();
+    const QRectF area = plotArea();
+    double first = 0;
+    double span = 1;
+    view(&first, &span);
+    const size_t begin = size_t(first);
+    const size_t end = size_t(std::ceil(first + span));
+    const core::Extent range = results ? results->extent(begin, end) : core::Extent();
+    painter.setPen(g_textColor);
+    if (range.empty() || area.width() < 1 || area.height() < 1) {
+        painter.drawText(rect(), Qt::AlignCenter, g_emptyText);
+        return;
+    }
+
+    double low = range.min;
+    double high = range.max;
+    if (high - low <= 0) {
+        const double pad = std::max(std::abs(low) * 0.5, 1.0);
+        low -= pad;
+        high += pad;
+    }
+    const auto toY = [&](double v) {
+        return area.bottom() - (v - low) / (high - low) * area.height();
+    };
+    const QRectF textArea = QRectF(rect()).adjusted(g_plotPadding, g_plotPadding / 2,
+                                                    -g_plotPadding, -g_plotPadding / 2);
+    painter.drawText(textArea, Qt::AlignTop | Qt::AlignLeft, formatValue(range.max));
+    painter.drawText(textArea, Qt::AlignBottom | Qt::AlignLeft, formatValue(range.min));
+    painter.drawText(textArea, Qt::AlignBottom | Qt::AlignRight,
+                     QStringLiteral("#%1 – #%2").arg(begin + 1).arg(end));
+
+    painter.setPen(QPen(g_lineColor, 1));
+    const int columns = int(area.width());
+    if (span <= columns) {
+        // Few enough results for each to get its own point, joined while they are finite.
+        const double step = area.width() / span;
+        QPolygonF line;
+        const auto flush = [&] {
+            if (line.size() == 1)
+                painter.drawPoint(line.front());
+            else if (line.size() > 1)
+                painter.drawPolyline(line);
+            line.clear();
+        };
+        for (size_t i = begin; i < end; ++i) {
+            const double v = (*results)[i];
+            if (!std::isfinite(v)) {
+                flush();
+                continue;
+            }
+            line << QPointF(area.left() + (double(i) - first + 0.5) * step, toY(v));
+        }
+        flush();
+        return;
+    }
+
+    // One vertical line per pixel column spanning the results it covers, from the pyramid.
+    painter.setRenderHint(QPainter::Antialiasing, false);
+    const double perColumn = span / columns;
+    for (int column = 0; column < columns; ++column) {
+        const size_t a = size_t(first + column * perColumn);
+        const size_t b = std::max(a + 1, size_t(first + (column + 1) * perColumn));
+        const core::Extent extent = results->extent(a, b);
+        if (extent.empty())
+            continue;
+        const double x = area.left() + column + 0.5;
+        const double top = toY(extent.max);
+        const double bottom = std::max(toY(extent.min), top + 1);
+        painter.drawLine(QLineF(x, top, x, bottom));
+    }
+}
+
+void PlotPanel::wheelEvent(QWheelEvent* event)
+{
+    const QRectF area = plotArea();
+    double first = 0;
+    double span = 1;
+    view(&first, &span);
+    const double factor = std::pow(g_zoomPerStep, event->angleDelta().y() / 120.0);
+    // The result under the cursor stays under it.
+    const double anchor =
+        first + std::clamp((event->position().x() - area.left()) / area.width(), 0.0, 1.0) * span;
+    setView(anchor - (anchor - first) * factor, span * factor);
+    event->accept();
+}
+
+void PlotPanel::mousePressEvent(QMouseEvent* event)
+{
+    double span = 1;
+    view(&_dragFirst, &span);
+    _dragX = event->position().x();
+    setCursor(Qt::ClosedHandCursor);
+}
+
+void PlotPanel::mouseMoveEvent(QMouseEvent* event)
+{
+    if (!(event->buttons() & Qt::LeftButton))
+        return;
+    double first = 0;
+    double span = 1;
+    view(&first, &span);
+    setView(_dragFirst - (event->position().x() - _dragX) / plotArea().width() * span, span);
+}
+
+void PlotPanel::mouseReleaseEvent(QMouseEvent*)
+{
+    setCursor(Qt::OpenHandCursor);
+}
+
+void PlotPanel::mouseDoubleClickEvent(QMouseEvent*)
+{
+    _showAll = true;
+    update();
+}
+
+void PlotPanel::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
+    placeInParent();
+}
+
+bool PlotPanel::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == parent() && event->type() == QEvent::Resize)
+        placeInParent();
+    return false;
+}
+
+void PlotPanel::placeInParent()
+{
+    const QWidget* parent = parentWidget();
+    const int height = std::max(g_minPanelHeight, int(parent->height() * g_panelHeightRatio));
+    setGeometry(g_panelMargin, parent->height() - height - g_panelMargin,
+                parent->width() - 2 * g_panelMargin, height);
+}
+
+#include "moc_plot_panel.cpp"
@@ -0,0 +1,56 @@
+#ifndef PLOT_PANEL_H
+#define PLOT_PANEL_H
+
+#include <QPointer>
+#include <QWidget>
+
+namespace core {
+class ResultSeries;
+}
+
+class Display;
+
+// Graphs the results of the lines completed in this session, see
+// EquationQueue::resultSeries(). Each pixel column draws the extent of the results it covers,
+// taken from the series' min/max pyramid, so a frame costs the same for a thousand results as
+// for millions. The wheel zooms around the cursor, dragging pans and a double click shows all
+// results again; a view that reaches the last result follows new ones.
+class PlotPanel : public QWidget
+{
+    Q_OBJECT
+public:
+    PlotPanel(Display* display, QWidget* parent);
+
+public slots:
+    void refresh();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    const core::ResultSeries* series() const;
+    QRectF plotArea() const;
+    // The visible range of result indexes, [*first, *first + *span).
+    void view(double* first, double* span) const;
+    // Clamps the range to the results; one that covers them all shows all from then on.
+    void setView(double first, double span);
+    void placeInParent();
+
+    QPointer<Display> _display;
+    bool _showAll = true;
+    double _first = 0;
+    double _span = 0;
+    // Keeps the end of the view on the last result as results are added.
+    bool _follow = true;
+    double _dragX = 0;
+    double _dragFirst = 0;
+};
+
+#endif // PLOT_PANEL_H
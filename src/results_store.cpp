@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+#include <QDebug>
+
+#include "core/equation.h"
+#include "core/number_text.h"
+#include "results_store.h"
+
+namespace {
+constexpr char g_storeMagic[8] = {'C', 'W', 'H', 'R', 'E', 'S', 'S', 'T'};
+constexpr uint32_t g_storeVersion = 3;
+constexpr uint64_t g_columnAlignment = 64;
+constexpr size_t g_scanLanes = 4;
+
+uint64_t alignedOffset(uint64_t offset)
+{
+    return (offset + g_columnAlignment - 1) / g_columnAlignment * g_columnAlignment;
+}
+
+bool operatorCode(core::Op op, uint8_t* code)
+{
+    switch (op) {
+    case core::Op::Plus:
+        *code = static_cast<uint8_t>(OperatorCode::Plus);
+        return true;
+    case core::Op::Minus:
+        *code = static_cast<uint8_t>(OperatorCode::Minus);
+        return true;
+    case core::Op::Multiply:
+        *code = static_cast<uint8_t>(OperatorCode::Multiply);
+        return true;
+    case core::Op::Divide:
+        *code = static_cast<uint8_t>(OperatorCode::Divide);
+        return true;
+    case core::Op::Open:
+        *code = static_cast<uint8_t>(OperatorCode::Open);
+        return true;
+    case core::Op::Close:
+        *code = static_cast<uint8_t>(OperatorCode::Close);
+        return true;
+    case core::Op::And:
+        *code = static_cast<uint8_t>(OperatorCode::And);
+        return true;
+    case core::Op::Or:
+        *code = static_cast<uint8_t>(OperatorCode::Or);
+        return true;
+    case core::Op::Xor:
+        *code = static_cast<uint8_t>(OperatorCode::Xor);
+        return true;
+    case core::Op::ShiftLeft:
+        *code = static_cast<uint8_t>(OperatorCode::ShiftLeft);
+        return true;
+    case core::Op::ShiftRight:
+        *code = static_cast<uint8_t>(OperatorCode::ShiftRight);
+        return true;
+    case core::Op::Equal:
+        break;
+    }
+    return false;
+}
+
+// Writes a column at the next 64 byte boundary, which with a segment starting on one is the
+// column's boundary within the segment.
+bool writeColumn(QFile& file, const void* data, uint64_t bytes)
+{
+    const qint64 padding = alignedOffset(file.pos()) - file.pos();
+    if (padding > 0 && file.write(QByteArray(padding, '\0')) != padding)
+        return false;
+    return bytes == 0 ||
+           file.write(static_cast<const char*>(data), static_cast<qint64>(bytes)) == qint64(bytes);
+}
+
+// Whether header starts a complete segment of this version within the available bytes.
+bool segmentHeaderValid(const ResultsStoreHeader& header, uint64_t available)
+{
+    return std::memcmp(header.magic, g_storeMagic, sizeof(header.magic)) == 0 &&
+           header.version == g_storeVersion && header.segmentSize >= sizeof(ResultsStoreHeader) &&
+           header.segmentSize % g_columnAlignment == 0 && header.segmentSize <= available;
+}
+
+// The end of the last complete segment, reading only the headers.
+qint64 segmentsEnd(QFile& file)
+{
+    const qint64 fileSize = file.size();
+    qint64 end = 0;
+    ResultsStoreHeader header;
+    while (fileSize - end >= qint64(sizeof(header)) && file.seek(end) &&
+           file.read(reinterpret_cast<char*>(&header), sizeof(header)) == sizeof(header) &&
+           segmentHeaderValid(header, uint64_t(fileSize - end)))
+        end += qint64(header.segmentSize);
+    return end;
+}
+
+// Whether count elements of elementSize bytes starting at offset end by end, without the sums
+// and products overflowing for the untrusted values of a header.
+bool columnFits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t end)
+{
+    return offset % g_columnAlignment == 0 && offset <= end &&
+           count <= (end - offset) / elementSize;
+}
+
+// Offsets of count equations into a column of total elements: they start at zero, never
+// decrease and end at total, so every equation's range lies within the column.
+bool offsetsValid(const uint64_t* offsets, uint64_t count, uint64_t total)
+{
+    if (offsets[0] != 0 || offsets[count] != total)
+        return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1])
+            return false;
+    }
+    return true;
+}
+
+// Whether the columns of the segment at base lie within it.
+bool segmentValid(const uchar* base, const ResultsStoreHeader& header)
+{
+    const uint64_t count = header.equationCount;
+    const uint64_t operandCount = header.operandCount;
+    const uint64_t operatorCount = header.operatorCount;
+    // Each column ends before the next one starts, so the last one ending within the segment
+    // keeps them all within it.
+    return header.resultsOffset >= sizeof(ResultsStoreHeader) &&
+           count < std::numeric_limits<uint64_t>::max() &&
+           columnFits(header.resultsOffset, count, sizeof(double), header.offsetsOffset) &&
+           columnFits(header.offsetsOffset, count + 1, sizeof(uint64_t), header.operandsOffset) &&
+           columnFits(header.operandsOffset, operandCount, sizeof(double),
+                      header.operatorOffsetsOffset) &&
+           columnFits(header.operatorOffsetsOffset, count + 1, sizeof(uint64_t),
+                      header.operatorsOffset) &&
+           columnFits(header.operatorsOffset, operatorCount, 1, header.segmentSize) &&
+           offsetsValid(reinterpret_cast<const uint64_t*>(base + header.offsetsOffset), count,
+                        operandCount) &&
+           offsetsValid(reinterpret_cast<const uint64_t*>(base + header.operatorOffsetsOffset),
+                        count, operatorCount);
+}
+
+bool isEqualWithEpsilon(double a, double b)
+{
+    return std::abs(a - b) < std::numeric_limits<double>::epsilon();
+}
+
+// The scans keep independent accumulators per lane so the loops carry no serial dependency
+// and stay limited by memory bandwidth rather than by floating point latency.
+double laneSum(const double* values, size_t count)
+{
+    double lanes[g_scanLanes] = {};
+    size_t i = 0;
+    for (; i + g_scanLanes <= count; i += g_scanLanes) {
+        for (size_t lane = 0; lane < g_scanLanes; ++lane)
+            lanes[lane] += values[i + lane];
+    }
+    for (; i < count; ++i)
+        lanes[0] += values[i];
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+// Widens [min, max] to the count values, at least one.
+void laneRange(const double* values, size_t count, double* min, double* max)
+{
+    double lanesMin[g_scanLanes];
+    double lanesMax[g_scanLanes];
+    std::fill(std::begin(lanesMin), std::end(lanesMin), values[0]);
+    std::fill(std::begin(lanesMax), std::end(lanesMax), values[0]);
+    size_t i = 0;
+    for (; i + g_scanLanes <= count; i += g_scanLanes) {
+        for (size_t lane = 0; lane < g_scanLanes; ++lane) {
+            lanesMin[lane] = std::min(lanesMin[lane], values[i + lane]);
+            lanesMax[lane] = std::max(lanesMax[lane], values[i + lane]);
+        }
+    }
+    for (; i < count; ++i) {
+        lanesMin[0] = std::min(lanesMin[0], values[i]);
+        lanesMax[0] = std::max(lanesMax[0], values[i]);
+    }
+    *min = std::min(*min, *std::min_element(std::begin(lanesMin), std::end(lanesMin)));
+    *max = std::max(*max, *std::max_element(std::begin(lanesMax), std::end(lanesMax)));
+}
+
+size_t laneCountInRange(const double* values, size_t count, double low, double high)
+{
+    size_t lanes[g_scanLanes] = {};
+    size_t i = 0;
+    for (; i + g_scanLanes <= count; i += g_scanLanes) {
+        for (size_t lane = 0; lane < g_scanLanes; ++lane) {
+            const double v = values[i + lane];
+            lanes[lane] += (v >= low) & (v <= high);
+        }
+    }
+    for (; i < count; ++i)
+        lanes[0] += (values[i] >= low) & (values[i] <= high);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+} // namespace
+
+ResultsStoreWriter::ResultsStoreWriter() : _offsets{0}, _operatorOffsets{0} {}
+
+bool ResultsStoreWriter::append(const core::Equation& equation)
+{
+    if (!equation.completed())
+        return false;
+    const size_t operandsBefore = _operands.size();
+    const size_t operatorsBefore = _operators.size();
+    // The last two tokens of a completed equation are "=" and the result.
+    for (size_t i = 0; i + 2 < equation.size(); ++i) {
+        const core::Token& token = equation.tokens()[i];
+        double value;
+        if (token.isNumber && core::parseNumber(token.text, &value)) {
+            _operands.push_back(value);
+            continue;
+        }
+        uint8_t code;
+        if (token.isNumber || !operatorCode(token.op, &code)) {
+            _operands.resize(operandsBefore);
+            _operators.resize(operatorsBefore);
+            ++_skipped;
+            return false;
+        }
+        _operators.push_back(code);
+    }
+    _results.push_back(equation.result());
+    _offsets.push_back(_operands.size());
+    _operatorOffsets.push_back(_operators.size());
+    return true;
+}
+
+void ResultsStoreWriter::clear()
+{
+    _results.clear();
+    _offsets.assign(1, 0);
+    _operands.clear();
+    _operatorOffsets.assign(1, 0);
+    _operators.clear();
+    _skipped = 0;
+}
+
+bool ResultsStoreWriter::save(const QString& path)
+{
+    if (_results.empty() && _skipped == 0)
+        return true;
+    if (!_file.isOpen() || _file.fileName() != path) {
+        _file.close();
+        _file.setFileName(path);
+        if (!_file.open(QIODevice::ReadWrite))
+            return false;
+        _end = segmentsEnd(_file);
+        if (_end == 0 && _file.size() > 0)
+            qWarning() << "Replacing unreadable results store" << path;
+    }
+
+    // Offsets are relative to the segment, the magic stays zero until the columns are written.
+    ResultsStoreHeader header{};
+    header.version = g_storeVersion;
+    header.equationCount = _results.size();
+    header.operandCount = _operands.size();
+    header.operatorCount = _operators.size();
+    header.skippedCount = _skipped;
+    header.resultsOffset = alignedOffset(sizeof(header));
+    header.offsetsOffset =
+        alignedOffset(header.resultsOffset + _results.size() * sizeof(double));
+    header.operandsOffset =
+        alignedOffset(header.offsetsOffset + _offsets.size() * sizeof(uint64_t));
+    header.operatorOffsetsOffset =
+        alignedOffset(header.operandsOffset + _operands.size() * sizeof(double));
+    header.operatorsOffset = alignedOffset(header.operatorOffsetsOffset +
+                                           _operatorOffsets.size() * sizeof(uint64_t));
+    header.segmentSize = alignedOffset(header.operatorsOffset + _operators.size());
+
+    const bool written =
+        _file.resize(_end) && _file.seek(_end) &&
+        _file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header) &&
+        writeColumn(_file, _results.data(), _results.size() * sizeof(double)) &&
+        writeColumn(_file, _offsets.data(), _offsets.size() * sizeof(uint64_t)) &&
+        writeColumn(_file, _operands.data(), _operands.size() * sizeof(double)) &&
+        writeColumn(_file, _operatorOffsets.data(), _operatorOffsets.size() * sizeof(uint64_t)) &&
+        writeColumn(_file, _operators.data(), _operators.size()) &&
+        writeColumn(_file, nullptr, 0) && _file.flush() && _file.seek(_end) &&
+        _file.write(g_storeMagic, sizeof(g_storeMagic)) == qint64(sizeof(g_storeMagic)) &&
+        _file.flush();
+    if (!written) {
+        _file.resize(_end);
+        return false;
+    }
+    _end += qint64(header.segmentSize);
+    clear();
+    return true;
+}
+
+ResultsStore::~ResultsStore() { close(); }
+
+bool ResultsStore::open(const QString& path)
+{
+    close();
+    _file.setFileName(path);
+    if (!_file.open(QIODevice::ReadOnly))
+        return false;
+    const uint64_t fileSize = _file.size();
+    const uchar* base = fileSize >= sizeof(ResultsStoreHeader) ? _file.map(0, fileSize) : nullptr;
+    if (!base) {
+        _file.close();
+        return false;
+    }
+    _base = base;
+    uint64_t end = 0;
+    while (fileSize - end >= sizeof(ResultsStoreHeader)) {
+        const auto* header = reinterpret_cast<const ResultsStoreHeader*>(base + end);
+        // An interrupted save ends the store.
+        if (!segmentHeaderValid(*header, fileSize - end))
+            break;
+        if (!segmentValid(base + end, *header)) {
+            close();
+            return false;
+        }
+        const uchar* segment = base + end;
+        _segments.push_back({_size, size_t(header->equationCount),
+                             reinterpret_cast<const double*>(segment + header->resultsOffset),
+                             reinterpret_cast<const uint64_t*>(segment + header->offsetsOffset),
+                             reinterpret_cast<const double*>(segment + header->operandsOffset),
+                             reinterpret_cast<const uint64_t*>(segment +
+                                                               header->operatorOffsetsOffset),
+                             reinterpret_cast<const OperatorCode*>(segment +
+                                                                   header->operatorsOffset)});
+        _size += header->equationCount;
+        _skipped += header->skippedCount;
+        end += header->segmentSize;
+    }
+    if (_segments.empty()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ResultsStore::close()
+{
+    if (_base)
+        _file.unmap(const_cast<uchar*>(_base));
+    _file.close();
+    _base = nullptr;
+    _segments.clear();
+    _size = 0;
+    _skipped = 0;
+}
+
+const ResultsStore::Segment& ResultsStore::segmentOf(size_t equation) const
+{
+    const auto next = std::upper_bound(
+        _segments.begin(), _segments.end(), equation,
+        [](size_t index, const Segment& segment) { return index < segment.first; });
+    return *std::prev(next);
+}
+
+double ResultsStore::result(size_t equation) const
+{
+    if (equation >= size())
+        return 0;
+    const Segment& segment = segmentOf(equation);
+    return segment.results[equation - segment.first];
+}
+
+const double* ResultsStore::operandsOf(size_t equation, size_t* count) const
+{
+    if (equation >= size()) {
+        *count = 0;
+        return nullptr;
+    }
+    const Segment& segment = segmentOf(equation);
+    const size_t i = equation - segment.first;
+    *count = segment.offsets[i + 1] - segment.offsets[i];
+    return segment.operands + segment.offsets[i];
+}
+
+const OperatorCode* ResultsStore::operatorsOf(size_t equation, size_t* count) const
+{
+    if (equation >= size()) {
+        *count = 0;
+        return nullptr;
+    }
+    const Segment& segment = segmentOf(equation);
+    const size_t i = equation - segment.first;
+    *count = segment.operatorOffsets[i + 1] - segment.operatorOffsets[i];
+    return segment.operators + segment.operatorOffsets[i];
+}
+
+double ResultsStore::sum() const
+{
+    double sum = 0;
+    for (const Segment& segment : _segments)
+        sum += laneSum(segment.results, segment.count);
+    return sum;
+}
+
+bool ResultsStore::range(double* min, double* max) const
+{
+    if (size() == 0)
+        return false;
+    *min = std::numeric_limits<double>::infinity();
+    *max = -std::numeric_limits<double>::infinity();
+    for (const Segment& segment : _segments) {
+        if (segment.count > 0)
+            laneRange(segment.results, segment.count, min, max);
+    }
+    return true;
+}
+
+size_t ResultsStore::countInRange(double low, double high) const
+{
+    size_t count = 0;
+    for (const Segment& segment : _segments)
+        count += laneCountInRange(segment.results, segment.count, low, high);
+    return count;
+}
+
+size_t ResultsStore::indexOf(double value, size_t from) const
+{
+    for (const Segment& segment : _segments) {
+        for (size_t i = from > segment.first ? from - segment.first : 0; i < segment.count; ++i) {
+            if (isEqualWithEpsilon(segment.results[i], value))
+                return segment.first + i;
+        }
+    }
+    return size();
+}
@@ -0,0 +1,135 @@
+#ifndef RESULTS_STORE_H
+#define RESULTS_STORE_H
+
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+namespace core {
+class Equation;
+} // namespace core
+
+// Columnar on-disk layout of completed equations. A store is a sequence of segments, each one
+// appended whole by a save of the equations completed since the previous one:
+//   header | results (double) | offsets (uint64, count + 1) | operands (double)
+//          | operator offsets (uint64, count + 1) | operators (uint8)
+// Every column starts on a 64 byte boundary relative to its segment, which itself starts on
+// one, and is stored in native byte order so it can be scanned straight out of the mapping.
+// segmentSize covers the header and the padded columns, the next segment starts right after.
+// Equation i of a segment owns operands [offsets[i], offsets[i + 1]) and operators
+// [operatorOffsets[i], operatorOffsets[i + 1]), parentheses included, in the order they were
+// typed. skippedCount counts completed equations with a number that could not be stored. The
+// magic is written last, so a segment without it, or one reaching past the end of the file, is
+// an interrupted save: it ends the store and the next save overwrites it.
+struct ResultsStoreHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t segmentSize;
+    uint64_t equationCount;
+    uint64_t operandCount;
+    uint64_t operatorCount;
+    uint64_t skippedCount;
+    uint64_t resultsOffset;
+    uint64_t offsetsOffset;
+    uint64_t operandsOffset;
+    uint64_t operatorOffsetsOffset;
+    uint64_t operatorsOffset;
+};
+
+enum class OperatorCode : uint8_t {
+    Plus = 0,
+    Minus,
+    Multiply,
+    Divide,
+    Open,
+    Close,
+    And,
+    Or,
+    Xor,
+    ShiftLeft,
+    ShiftRight
+};
+
+// Collects the equations completed since the last save in memory. Saving appends them to the
+// store file as one segment and starts over, so neither the file nor the equations of earlier
+// sessions are read or rewritten.
+class ResultsStoreWriter
+{
+public:
+    ResultsStoreWriter();
+
+    bool append(const core::Equation& equation);
+    // Equations appended since the last save, stored and skipped.
+    size_t size() const { return _results.size(); }
+    size_t skipped() const { return _skipped; }
+    void clear();
+    // Appends the collected equations as a segment of the store at path and clears them, or
+    // keeps them for the next attempt on failure. An interrupted save at the end of the file is
+    // overwritten, and a file that does not start with a segment of this version is replaced.
+    bool save(const QString& path);
+
+private:
+    std::vector<double> _results;
+    std::vector<uint64_t> _offsets;
+    std::vector<double> _operands;
+    std::vector<uint64_t> _operatorOffsets;
+    std::vector<uint8_t> _operators;
+    size_t _skipped = 0;
+    QFile _file;
+    // Where the next segment goes, once _file is open.
+    qint64 _end = 0;
+};
+
+// Maps a store file and reads its segments in place.
+class ResultsStore
+{
+public:
+    ResultsStore() = default;
+    ~ResultsStore();
+    ResultsStore(const ResultsStore&) = delete;
+    ResultsStore& operator=(const ResultsStore&) = delete;
+
+    // Fails unless the header and both offset columns of every segment describe columns within
+    // it, so the accessors below never read outside the mapping.
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return _base != nullptr; }
+
+    size_t size() const { return _size; }
+    size_t skipped() const { return _skipped; }
+    double result(size_t equation) const;
+    const double* operandsOf(size_t equation, size_t* count) const;
+    const OperatorCode* operatorsOf(size_t equation, size_t* count) const;
+
+    double sum() const;
+    bool range(double* min, double* max) const;
+    size_t countInRange(double low, double high) const;
+    size_t indexOf(double value, size_t from = 0) const;
+
+private:
+    struct Segment
+    {
+        // Index of the segment's first equation in the store.
+        size_t first;
+        size_t count;
+        const double* results;
+        const uint64_t* offsets;
+        const double* operands;
+        const uint64_t* operatorOffsets;
+        const OperatorCode* operators;
+    };
+
+    // The segment holding equation, which has to be below size().
+    const Segment& segmentOf(size_t equation) const;
+
+    QFile _file;
+    const uchar* _base = nullptr;
+    std::vector<Segment> _segments;
+    size_t _size = 0;
+    size_t _skipped = 0;
+};
+
+#endif // RESULTS_STORE_H
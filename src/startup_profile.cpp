@@ -0,0 +1,94 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QTimer>
+#include <QWidget>
+#include <vector>
+
+#include "startup_profile.h"
+
+namespace {
+const char g_startupProfileVariable[] = "CALCULATOR_STARTUP_PROFILE";
+const char g_firstFramePhase[] = "first frame";
+const char g_exitAfterProfile[] = "exit";
+
+struct StartupPhase
+{
+    const char* name;
+    qint64 endNs;
+};
+
+struct StartupProfile
+{
+    bool enabled = false;
+    bool exitAfterFirstFrame = false;
+    QElapsedTimer timer;
+    std::vector<StartupPhase> phases;
+};
+
+StartupProfile& profile()
+{
+    static StartupProfile instance;
+    return instance;
+}
+
+void logProfile()
+{
+    qint64 previousNs = 0;
+    for (const StartupPhase& phase : profile().phases) {
+        qInfo("startup %-16s %8.2f ms, done at %8.2f ms", phase.name,
+              (phase.endNs - previousNs) / 1e6, phase.endNs / 1e6);
+        previousNs = phase.endNs;
+    }
+    profile().phases.clear();
+    profile().enabled = false;
+}
+
+// Sees the first paint event before the window handles it, so the frame counts as done when the
+// event loop next gets to its timers.
+class FirstFrameFilter : public QObject
+{
+public:
+    using QObject::QObject;
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        if (event->type() != QEvent::Paint)
+            return false;
+        watched->removeEventFilter(this);
+        deleteLater();
+        QTimer::singleShot(0, [] {
+            markStartupPhase(g_firstFramePhase);
+            const bool exit = profile().exitAfterFirstFrame;
+            logProfile();
+            if (exit)
+                QCoreApplication::quit();
+        });
+        return false;
+    }
+};
+} // namespace
+
+void startStartupProfile()
+{
+    StartupProfile& p = profile();
+    p.enabled = qEnvironmentVariableIsSet(g_startupProfileVariable);
+    p.exitAfterFirstFrame = qEnvironmentVariable(g_startupProfileVariable) == g_exitAfterProfile;
+    if (p.enabled)
+        p.timer.start();
+}
+
+void markStartupPhase(const char* phase)
+{
+    StartupProfile& p = profile();
+    if (p.enabled)
+        p.phases.push_back({phase, p.timer.nsecsElapsed()});
+}
+
+void finishStartupProfileOnFirstFrame(QWidget* window)
+{
+    if (profile().enabled)
+        window->installEventFilter(new FirstFrameFilter(window));
+}
@@ -0,0 +1,16 @@
+#ifndef STARTUP_PROFILE_H
+#define STARTUP_PROFILE_H
+
+class QWidget;
+
+// Startup phase timing, enabled by the CALCULATOR_STARTUP_PROFILE environment variable. Each
+// phase lasts from the end of the previous one; the phases, up to the first frame painted by the
+// main window, are logged once that frame is done. Set to "exit", the application quits right
+// after logging, so that scripted runs on the offscreen platform measure startup alone. Without
+// the variable every call returns at once.
+void startStartupProfile();
+void markStartupPhase(const char* phase);
+// Marks the "first frame" phase and logs the profile after the first paint of window.
+void finishStartupProfileOnFirstFrame(QWidget* window);
+
+#endif // STARTUP_PROFILE_H
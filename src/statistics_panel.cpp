@@ -0,0 +1,71 @@
+#include <vector>
+
+#include <QStringBuilder>
+
+#include "display.h"
+#include "statistics_panel.h"
+
+namespace {
+constexpr QPoint g_panelMargin(6, 4);
+const QString g_panelStyleSheet(QStringLiteral("QLabel{"
+                                               "background-color: rgba(241, 241, 241, 230);"
+                                               "border: 1px solid rgb(196, 199, 199);"
+                                               "border-radius: 6px;"
+                                               "padding: 3px;"
+                                               "color: rgb(68, 68, 68);}"));
+const QString g_allResultsTitle("All results");
+const QString g_selectionTitle("Selection");
+
+QString formatValue(double v) { return QString::number(v, 'g', 10); }
+} // namespace
+
+StatisticsPanel::StatisticsPanel(Display* display, QWidget* parent)
+    : QLabel(parent), _display(display)
+{
+    setStyleSheet(g_panelStyleSheet);
+    setTextFormat(Qt::PlainText);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    connect(display, &Display::linesChanged, this, &StatisticsPanel::refresh);
+    connect(display, &Display::selectionChanged, this, &StatisticsPanel::refresh);
+}
+
+void StatisticsPanel::refresh()
+{
+    if (!isVisible() || !_display || !_display->equations())
+        return;
+    const auto& equations = *_display->equations();
+    core::StatisticsSummary summary;
+    const auto& selection = _display->selection();
+    if (selection.empty()) {
+        summary = equations.statistics().summary();
+    } else {
+        std::vector<double> values;
+        values.reserve(selection.size());
+        for (size_t id : selection) {
+            const size_t index = id - equations.firstId();
+            if (index < equations.size() && equations[index].completed())
+                values.push_back(equations[index].result());
+        }
+        summary = core::computeStatistics(values.data(), values.size());
+    }
+
+    QString text = (selection.empty() ? g_allResultsTitle : g_selectionTitle) % QStringLiteral(" (") %
+                   QString::number(summary.count) % QStringLiteral(")");
+    if (summary.count > 0) {
+        text += QStringLiteral("\nΣ ") % formatValue(summary.sum) % QStringLiteral("\nmean ") %
+                formatValue(summary.mean) % QStringLiteral("\nmin ") % formatValue(summary.min) %
+                QStringLiteral("\nmax ") % formatValue(summary.max) % QStringLiteral("\ns ") %
+                formatValue(summary.standardDeviation);
+    }
+    setText(text);
+    adjustSize();
+    move(parentWidget()->width() - width() - g_panelMargin.x(), g_panelMargin.y());
+}
+
+void StatisticsPanel::showEvent(QShowEvent* event)
+{
+    QLabel::showEvent(event);
+    refresh();
+}
+
+#include "moc_statistics_panel.cpp"
@@ -0,0 +1,25 @@
+#ifndef STATISTICS_PANEL_H
+#define STATISTICS_PANEL_H
+
+#include <QLabel>
+#include <QPointer>
+
+class Display;
+
+class StatisticsPanel : public QLabel
+{
+    Q_OBJECT
+public:
+    StatisticsPanel(Display* display, QWidget* parent);
+
+public slots:
+    void refresh();
+
+protected:
+    void showEvent(QShowEvent* event) override;
+
+private:
+    QPointer<Display> _display;
+};
+
+#endif // STATISTICS_PANEL_H
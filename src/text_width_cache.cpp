@@ -0,0 +1,40 @@
+#include <QFontMetricsF>
+
+#include "text_width_cache.h"
+
+namespace {
+// Histories hold few distinct texts, the cache starts over rather than track their use.
+constexpr qsizetype g_maxCachedWidths = 65536;
+} // namespace
+
+qreal TextWidthCache::width(const QFont& font, const QString& text)
+{
+    const QString fontKey = font.key();
+    {
+        const QReadLocker locker(&_lock);
+        const auto widths = _widths.constFind(fontKey);
+        if (widths != _widths.constEnd()) {
+            const auto width = widths->constFind(text);
+            if (width != widths->constEnd())
+                return *width;
+        }
+    }
+    // Measured without the lock, two threads measuring the same text store the same width.
+    const qreal width = QFontMetricsF(font).size(0, text).width();
+    const QWriteLocker locker(&_lock);
+    if (_size >= g_maxCachedWidths) {
+        _widths.clear();
+        _size = 0;
+    }
+    QHash<QString, qreal>& widths = _widths[fontKey];
+    const qsizetype before = widths.size();
+    widths.insert(text, width);
+    _size += widths.size() - before;
+    return width;
+}
+
+TextWidthCache& textWidthCache()
+{
+    static TextWidthCache cache;
+    return cache;
+}
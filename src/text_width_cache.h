@@ -0,0 +1,27 @@
+#ifndef TEXT_WIDTH_CACHE_H
+#define TEXT_WIDTH_CACHE_H
+
+#include <QFont>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+
+// Widths of plain text, one or more lines, per font. QFontMetricsF may be used from any thread,
+// so lines added in bulk are measured on the thread pool and the display finds their widths
+// here when it lays them out; text measured on the GUI thread is kept the same way.
+class TextWidthCache
+{
+public:
+    qreal width(const QFont& font, const QString& text);
+
+private:
+    QReadWriteLock _lock;
+    // Font key to text to width.
+    QHash<QString, QHash<QString, qreal>> _widths;
+    qsizetype _size = 0;
+};
+
+// The cache shared by every display and the measuring workers.
+TextWidthCache& textWidthCache();
+
+#endif // TEXT_WIDTH_CACHE_H
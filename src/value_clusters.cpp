@@ -0,0 +1,46 @@
+#include <cmath>
+
+#include "value_clusters.h"
+
+namespace {
+// -0 and 0 compare equal but hash apart.
+double key(double value) { return value + 0.0; }
+} // namespace
+
+void ValueClusters::add(double value)
+{
+    if (std::isnan(value))
+        return;
+    const auto [cluster, inserted] = _clusters.try_emplace(key(value), Cluster{0, 0});
+    ++cluster->second.count;
+    if (!inserted)
+        return;
+    if (_freeIndices.empty()) {
+        cluster->second.paletteIndex = _nextIndex++;
+    } else {
+        cluster->second.paletteIndex = *_freeIndices.begin();
+        _freeIndices.erase(_freeIndices.begin());
+    }
+}
+
+void ValueClusters::remove(double value)
+{
+    const auto cluster = std::isnan(value) ? _clusters.end() : _clusters.find(key(value));
+    if (cluster == _clusters.end() || --cluster->second.count > 0)
+        return;
+    _freeIndices.insert(cluster->second.paletteIndex);
+    _clusters.erase(cluster);
+}
+
+void ValueClusters::clear()
+{
+    _clusters.clear();
+    _freeIndices.clear();
+    _nextIndex = 0;
+}
+
+int ValueClusters::paletteIndex(double value) const
+{
+    const auto cluster = std::isnan(value) ? _clusters.end() : _clusters.find(key(value));
+    return cluster == _clusters.end() ? -1 : cluster->second.paletteIndex;
+}
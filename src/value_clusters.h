@@ -0,0 +1,39 @@
+#ifndef VALUE_CLUSTERS_H
+#define VALUE_CLUSTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+
+// Groups the equal number values held anywhere in the history into clusters, counted so that
+// adding or removing a line only touches the clusters of its own numbers. Each cluster takes a
+// palette index when its value first appears and keeps it until the last occurrence goes, so
+// its color is stable; freed indices are reused smallest first, so live clusters never share an
+// index. NaN equals nothing and forms no cluster.
+class ValueClusters
+{
+public:
+    void add(double value);
+    void remove(double value);
+    void clear();
+    size_t size() const { return _clusters.size(); }
+
+    // Palette index of the cluster of value, or -1 when no line holds value.
+    int paletteIndex(double value) const;
+    // Whether two numbers belong to the same cluster.
+    static bool sameValue(double a, double b) { return a == b; }
+
+private:
+    struct Cluster
+    {
+        size_t count;
+        int paletteIndex;
+    };
+
+    std::unordered_map<double, Cluster> _clusters;
+    std::set<int> _freeIndices;
+    int _nextIndex = 0;
+};
+
+#endif // VALUE_CLUSTERS_H
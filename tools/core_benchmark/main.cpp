@@ -0,0 +1,901 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/column.h"
+#include "core/evaluation.h"
+#include "core/history.h"
+#include "core/number_text.h"
+#include "core/result_series.h"
+#include "core/statistics.h"
+
+namespace {
+constexpr size_t g_defaultIterations = 1000000;
+constexpr size_t g_expressionCount = 4096;
+constexpr size_t g_chainLength = 1000;
+constexpr size_t g_numberTextChecks = 200000;
+constexpr size_t g_numberTextSize = 32;
+constexpr size_t g_unfinishedEvery = 8;
+constexpr size_t g_nestedOperands = 5000;
+constexpr size_t g_columnChecks = 1000;
+constexpr size_t g_statisticsChecks = 100000;
+constexpr size_t g_statisticsWindow = 64;
+constexpr size_t g_columnRows = size_t(1) << 22;
+constexpr size_t g_plotColumns = 1920;
+constexpr size_t g_plotFrames = 100;
+constexpr size_t g_plotZoom = 1000;
+const char* const g_operatorTexts[] = {"+", "-", "*", "/"};
+const char* const g_integerOperatorTexts[] = {"+", "-", "*", "&", "|", "^"};
+
+using Clock = std::chrono::steady_clock;
+
+struct ConstantCase
+{
+    std::string_view text;
+    double value;
+};
+
+#define CONSTANT_CASE(text) {text, core::evaluateExpression(text)}
+// Evaluated by the compiler, checked against the runtime Equation below.
+constexpr ConstantCase g_constantCases[] = {
+    CONSTANT_CASE("1/3*3"),
+    CONSTANT_CASE("0.1+0.2"),
+    CONSTANT_CASE("2-3-4"),
+    CONSTANT_CASE("1+2*3-4/5"),
+    CONSTANT_CASE("-5*-2"),
+    CONSTANT_CASE("123456789*987654321"),
+    CONSTANT_CASE("0.000001/3"),
+    CONSTANT_CASE("7/9*9-1"),
+    CONSTANT_CASE("1.5*1.5*1.5*1.5"),
+    CONSTANT_CASE("99999999999999999+1"),
+    CONSTANT_CASE("3.14159265358979*2"),
+    CONSTANT_CASE("1/7+1/7+1/7"),
+    CONSTANT_CASE("-0.5-0.25 = -0.75"),
+    CONSTANT_CASE("0.0000001 * 0.0000001"),
+    CONSTANT_CASE("(1+2)*3"),
+    CONSTANT_CASE("2*(3+4)/(1-0.5)"),
+    CONSTANT_CASE("((((1/3))))*3"),
+    CONSTANT_CASE("-2-(3-(4-5))"),
+};
+#undef CONSTANT_CASE
+
+struct ExactCase
+{
+    const char* text;
+    const char* result;
+};
+
+// Results of exact arithmetic, where double arithmetic shows 0.999999999999999, 1e+40 and so on.
+const ExactCase g_exactCases[] = {
+    {"1/3*3", "1"},
+    {"0.1+0.2-0.3", "0"},
+    {"1/7*7-1", "0"},
+    {"99999999999999999999*99999999999999999999", "9999999999999999999800000000000000000001"},
+    {"123456789012345678*1000/1000", "123456789012345678"},
+    {"2/3", "0.666666666666667"},
+    {"1/1024", "0.0009765625"},
+    {"19.99*3-0.01", "59.96"},
+    {"(1/3+1/6)*2", "1"},
+    {"1/(0.1+0.2)*0.3", "1"},
+};
+
+struct IntegerCase
+{
+    const char* text;
+    const char* result;
+    core::Status status;
+};
+
+// Results of programmer mode: beyond 2^53, in other bases, with the bitwise operators below the
+// arithmetic ones and among themselves at C's levels, and the failures it reports.
+const IntegerCase g_integerCases[] = {
+    {"9007199254740993+1", "9007199254740994", core::Status::Ok},
+    {"123456789*1000000000+1", "123456789000000001", core::Status::Ok},
+    {"0xFF&0x0F", "0xF", core::Status::Ok},
+    {"0b1010|0b0101", "0b1111", core::Status::Ok},
+    {"0o17^0o5", "0o12", core::Status::Ok},
+    {"0xFFFFFFFFFFFFFFFF+1", "0x0", core::Status::Ok},
+    {"-1&255", "255", core::Status::Ok},
+    {"-0x1+0", "0xFFFFFFFFFFFFFFFF", core::Status::Ok},
+    {"1<<62", "4611686018427387904", core::Status::Ok},
+    {"-8>>1", "-4", core::Status::Ok},
+    {"1+2<<3", "24", core::Status::Ok},
+    {"6&3+1", "4", core::Status::Ok},
+    {"(1|2)*3", "9", core::Status::Ok},
+    {"1|2<<3", "17", core::Status::Ok},
+    {"12&10|1", "9", core::Status::Ok},
+    {"1|6^3", "5", core::Status::Ok},
+    {"6^3&5", "7", core::Status::Ok},
+    {"1<<2<<3", "32", core::Status::Ok},
+    {"1|2^4&6<<1+1", "3", core::Status::Ok},
+    {"(0xFF)+1", "0x100", core::Status::Ok},
+    {"-7/2", "-3", core::Status::Ok},
+    {"9223372036854775807+1", "-9223372036854775808", core::Status::Overflow},
+    {"-9223372036854775808/-1", "-9223372036854775808", core::Status::Overflow},
+    {"5/0", "0", core::Status::DivisionByZero},
+    {"1<<64", "0", core::Status::Invalid},
+};
+
+// Column mode formulas, x stands for the column.
+const char* const g_columnFormulas[] = {
+    "x+1.5-2",
+    "x*1.2+3",
+    "(x-0.5)/3*x",
+    "100/x-x/7",
+    "-2-(x-(4-x))*0.1",
+};
+const char g_columnSentinel[] = "0.000123456";
+
+static_assert(core::evaluateExpression("1/3*3") == 0.999999999999999, "× and ÷ round each step");
+static_assert(core::evaluateExpression("1+2*3") == 7, "× binds tighter than +");
+static_assert(core::evaluateExpression("0.1+0.2") == 0.3, "results keep 15 digits");
+static_assert(core::evaluateExpression("(1+2)*3") == 9, "parentheses group first");
+
+double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void report(const char* name, size_t operations, double seconds)
+{
+    std::printf("%-24s %10zu ops %8.3f s %12.0f ops/s\n", name, operations, seconds,
+                seconds > 0 ? operations / seconds : 0.0);
+}
+
+std::vector<std::string> makeExpressions(std::mt19937& random)
+{
+    std::vector<std::string> expressions;
+    expressions.reserve(g_expressionCount);
+    for (size_t i = 0; i < g_expressionCount; ++i) {
+        std::string expression = std::to_string(random() % 100000);
+        const size_t operators = 1 + random() % 6;
+        for (size_t j = 0; j < operators; ++j) {
+            expression += g_operatorTexts[random() % 4];
+            expression += std::to_string(1 + random() % 1000);
+            if (random() % 3 == 0)
+                expression += "." + std::to_string(random() % 100);
+        }
+        expressions.push_back(std::move(expression));
+    }
+    return expressions;
+}
+
+int checkConstantEvaluation()
+{
+    int mismatches = 0;
+    for (const ConstantCase& constant : g_constantCases) {
+        core::Equation equation;
+        const bool parsed = core::Equation::parse(constant.text, &equation);
+        const double value = parsed ? equation.result() : 0;
+        if (!parsed || std::memcmp(&value, &constant.value, sizeof(value)) != 0) {
+            std::printf("constexpr mismatch for %.*s: %.17g at compile time, %.17g at runtime\n",
+                        int(constant.text.size()), constant.text.data(), constant.value, value);
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+int checkExactEvaluation()
+{
+    int mismatches = 0;
+    for (const ExactCase& exact : g_exactCases) {
+        core::Equation equation;
+        const bool parsed = core::Equation::parse(exact.text, &equation, core::Arithmetic::Exact);
+        const std::string result = parsed ? equation.back().text : "";
+        if (result != exact.result) {
+            std::printf("exact mismatch for %s: %s instead of %s\n", exact.text, result.c_str(),
+                        exact.result);
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+int checkIntegerEvaluation()
+{
+    int mismatches = 0;
+    for (const IntegerCase& integer : g_integerCases) {
+        core::Equation equation;
+        const bool parsed =
+            core::Equation::parse(integer.text, &equation, core::Arithmetic::Integer);
+        const std::string result = parsed ? equation.back().text : "";
+        if (result != integer.result || (parsed && equation.status() != integer.status)) {
+            std::printf("integer mismatch for %s: %s instead of %s\n", integer.text,
+                        result.c_str(), integer.result);
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+std::string replaceColumn(std::string formula, const std::string& text)
+{
+    for (size_t i = formula.find('x'); i != std::string::npos; i = formula.find('x', i))
+        formula.replace(i, 1, text);
+    return formula;
+}
+
+// The formula with the column in place of each x, and a slot per x.
+bool makeColumnEquation(const char* formula, const std::vector<double>& column,
+                        core::Equation* equation, std::vector<core::ColumnOperand>* columns)
+{
+    if (!core::Equation::parse(replaceColumn(formula, g_columnSentinel), equation))
+        return false;
+    columns->clear();
+    for (size_t i = 0; i < equation->size(); ++i) {
+        if (equation->tokens()[i].text == g_columnSentinel)
+            columns->push_back({i, column.data()});
+    }
+    return true;
+}
+
+// Every row of a column evaluates to the result of the equation with that row's number typed
+// in, bit for bit, zeros dividing included. Half of the rows have all 15 digits, so that the
+// rounding of × and ÷ steps meets its near ties.
+int checkColumnEvaluation(std::mt19937& random)
+{
+    std::vector<double> column(g_columnChecks);
+    for (size_t row = 0; row < column.size(); ++row) {
+        const double value = row % 2 == 0 ? double(int(random() % 2001) - 1000) /
+                                                double(1 + random() % 8)
+                                          : std::ldexp(double(random()), -int(random() % 40));
+        column[row] = core::roundToDisplayPrecision(value);
+    }
+    std::vector<double> results(column.size());
+    int mismatches = 0;
+    for (const char* formula : g_columnFormulas) {
+        core::Equation equation;
+        std::vector<core::ColumnOperand> columns;
+        core::Status status = core::Status::Ok;
+        if (!makeColumnEquation(formula, column, &equation, &columns) ||
+            !core::evaluateColumn(equation, columns, 0, column.size(), results.data(), &status)) {
+            std::printf("column evaluation failed for %s\n", formula);
+            ++mismatches;
+            continue;
+        }
+        bool allOk = true;
+        for (size_t row = 0; row < column.size(); ++row) {
+            core::Equation expected;
+            const std::string text = replaceColumn(formula, core::formatNumber(column[row]));
+            if (!core::Equation::parse(text, &expected))
+                continue;
+            allOk &= expected.status() == core::Status::Ok;
+            const double value = expected.result();
+            if (std::memcmp(&value, &results[row], sizeof(value)) != 0) {
+                std::printf("column mismatch for %s: %.17g instead of %.17g\n", text.c_str(),
+                            results[row], value);
+                ++mismatches;
+            }
+        }
+        if (allOk != (status == core::Status::Ok)) {
+            std::printf("column status mismatch for %s\n", formula);
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+bool sameAggregate(double a, double b)
+{
+    if (std::isnan(a) || std::isnan(b) || std::isinf(a) || std::isinf(b))
+        return std::memcmp(&a, &b, sizeof(a)) == 0 || (std::isnan(a) && std::isnan(b));
+    return std::fabs(a - b) <= 1e-9 * std::max({std::fabs(a), std::fabs(b), 1.0});
+}
+
+bool sameSummary(const core::StatisticsSummary& a, const core::StatisticsSummary& b)
+{
+    return a.count == b.count && sameAggregate(a.sum, b.sum) && sameAggregate(a.mean, b.mean) &&
+           sameAggregate(a.min, b.min) && sameAggregate(a.max, b.max) &&
+           sameAggregate(a.standardDeviation, b.standardDeviation);
+}
+
+// The running statistics of a history against a recomputation over its completed results.
+bool historyStatisticsMatch(const core::History& history, const char* what)
+{
+    std::vector<double> values;
+    for (const core::Equation& equation : history.equations()) {
+        if (equation.completed())
+            values.push_back(equation.result());
+    }
+    const core::StatisticsSummary running = history.statistics().summary();
+    const core::StatisticsSummary recomputed =
+        core::computeStatistics(values.data(), values.size());
+    if (sameSummary(running, recomputed))
+        return true;
+    std::printf("statistics mismatch %s: sum %g mean %g sd %g instead of %g %g %g\n", what,
+                running.sum, running.mean, running.standardDeviation, recomputed.sum,
+                recomputed.mean, recomputed.standardDeviation);
+    return false;
+}
+
+double randomStatisticsValue(std::mt19937& random)
+{
+    switch (random() % 16) {
+    case 0:
+        return std::numeric_limits<double>::infinity();
+    case 1:
+        return -std::numeric_limits<double>::infinity();
+    case 2:
+        return std::nan("");
+    default:
+        return double(int(random() % 2001) - 1000) / 8;
+    }
+}
+
+// A "1/0" result must leave the running statistics once it is evicted or edited away, and a
+// window with infinities and NaN must summarize as the vectorized recomputation does.
+int checkStatistics(std::mt19937& random)
+{
+    int mismatches = 0;
+    std::vector<core::Equation> lines(11);
+    core::Equation::parse("1/0", &lines[0]);
+    for (size_t i = 1; i < lines.size(); ++i)
+        core::Equation::parse("2+3", &lines[i]);
+
+    core::History evicted(4);
+    evicted.appendCompleted({lines[0]});
+    mismatches += !historyStatisticsMatch(evicted, "with an inf result");
+    evicted.appendCompleted({lines.begin() + 1, lines.end()});
+    mismatches += !historyStatisticsMatch(evicted, "after evicting an inf result");
+    if (!std::isfinite(evicted.statistics().summary().sum)) {
+        std::printf("an evicted inf result left the sum at %g\n",
+                    evicted.statistics().summary().sum);
+        ++mismatches;
+    }
+
+    core::History edited;
+    edited.appendCompleted(lines);
+    std::vector<size_t> changedIds;
+    if (!edited.editNumber(edited.firstId(), 2, "4", &changedIds)) {
+        std::printf("1/0 could not be edited into 1/4\n");
+        ++mismatches;
+    }
+    mismatches += !historyStatisticsMatch(edited, "after editing an inf result away");
+
+    core::RunningStatistics running;
+    std::deque<double> window;
+    for (size_t i = 0; i < g_statisticsChecks && mismatches < 10; ++i) {
+        const unsigned action = random() % 4;
+        if (action == 0 && !window.empty()) {
+            running.popFront();
+            window.pop_front();
+        } else if (action == 1 && !window.empty()) {
+            const size_t index = random() % window.size();
+            window[index] = randomStatisticsValue(random);
+            running.replace(index, window[index]);
+        } else if (window.size() < g_statisticsWindow) {
+            window.push_back(randomStatisticsValue(random));
+            running.push(window.back());
+        }
+        const std::vector<double> values(window.begin(), window.end());
+        const core::StatisticsSummary recomputed =
+            core::computeStatistics(values.data(), values.size());
+        if (!sameSummary(running.summary(), recomputed)) {
+            std::printf("running statistics of %zu values do not match a recomputation\n",
+                        values.size());
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+// Any finite bit pattern, half of them integers and short decimals as the history holds them.
+double randomDouble(std::mt19937& random)
+{
+    if (random() % 2 == 0)
+        return double(int(random() % 2000001) - 1000000) / double(1 + random() % 1000);
+    for (;;) {
+        const uint64_t bits = uint64_t(random()) << 32 | random();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (std::isfinite(value))
+            return value;
+    }
+}
+
+// The core conversions against the C library: formatNumber must print what "%.15g" prints,
+// formatShortest must parse back to the same bits and parseNumber must agree with strtod.
+int checkNumberText(std::mt19937& random)
+{
+    int mismatches = 0;
+    char text[g_numberTextSize];
+    for (size_t i = 0; i < g_numberTextChecks && mismatches < 10; ++i) {
+        const double value = randomDouble(random);
+        std::snprintf(text, sizeof(text), "%.15g", value);
+        const std::string formatted = core::formatNumber(value);
+        if (formatted != text) {
+            std::printf("format mismatch: %s instead of %s\n", formatted.c_str(), text);
+            ++mismatches;
+        }
+        const std::string shortest = core::formatShortest(value);
+        double parsed = 0;
+        if (!core::parseNumber(shortest, &parsed) ||
+            std::memcmp(&parsed, &value, sizeof(value)) != 0) {
+            std::printf("%s does not round trip %.17g\n", shortest.c_str(), value);
+            ++mismatches;
+        }
+        std::snprintf(text, sizeof(text), "%.17g", value);
+        const double expected = std::strtod(text, nullptr);
+        if (!core::parseNumber(text, &parsed) ||
+            std::memcmp(&parsed, &expected, sizeof(value)) != 0) {
+            std::printf("parse mismatch for %s: %.17g\n", text, parsed);
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+int64_t randomInteger(std::mt19937& random)
+{
+    const uint64_t bits = uint64_t(random()) << 32 | random();
+    // Small magnitudes as often as full 64 bit patterns.
+    return int64_t(bits >> (random() % 64));
+}
+
+std::string binaryText(int64_t value)
+{
+    std::string digits;
+    for (uint64_t pattern = uint64_t(value); pattern != 0 || digits.empty(); pattern >>= 1)
+        digits.insert(digits.begin(), char('0' + (pattern & 1)));
+    return "0b" + digits;
+}
+
+// formatInteger must print what printf prints in each base, with the prefix, and parseInteger
+// must read it back.
+int checkIntegerText(std::mt19937& random)
+{
+    int mismatches = 0;
+    char text[core::g_maxIntegerText + 1];
+    for (size_t i = 0; i < g_numberTextChecks && mismatches < 10; ++i) {
+        int64_t value = randomInteger(random);
+        if (random() % 2 == 0)
+            value = -value;
+        const unsigned long long pattern = uint64_t(value);
+        std::string expected[4];
+        std::snprintf(text, sizeof(text), "%lld", static_cast<long long>(value));
+        expected[0] = text;
+        std::snprintf(text, sizeof(text), "0x%llX", pattern);
+        expected[1] = text;
+        std::snprintf(text, sizeof(text), "0o%llo", pattern);
+        expected[2] = text;
+        expected[3] = binaryText(value);
+        const core::Base bases[] = {core::Base::Decimal, core::Base::Hexadecimal,
+                                    core::Base::Octal, core::Base::Binary};
+        for (size_t b = 0; b < std::size(bases); ++b) {
+            const std::string formatted = core::formatInteger(value, bases[b]);
+            int64_t parsed = 0;
+            if (formatted != expected[b] || !core::parseInteger(formatted, &parsed) ||
+                parsed != value) {
+                std::printf("integer text mismatch: %s instead of %s\n", formatted.c_str(),
+                            expected[b].c_str());
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+// A machine-generated expression of g_nestedOperands operands with parentheses nested up to
+// hundreds deep, balanced at the end.
+std::string makeNestedExpression(std::mt19937& random)
+{
+    std::string expression;
+    size_t depth = 0;
+    for (size_t i = 0; i < g_nestedOperands; ++i) {
+        if (i > 0)
+            expression += g_operatorTexts[random() % 3];
+        for (; random() % 3 == 0; ++depth)
+            expression += '(';
+        expression += std::to_string(1 + random() % 100);
+        for (; depth > 0 && random() % 3 == 0; --depth)
+            expression += ')';
+    }
+    expression.append(depth, ')');
+    return expression;
+}
+
+// Guards the results against being optimized away.
+double g_sink = 0;
+
+double benchmarkParse(const std::vector<std::string>& expressions, size_t iterations,
+                      core::Arithmetic arithmetic, const char* name)
+{
+    const auto start = Clock::now();
+    core::Equation equation;
+    for (size_t i = 0; i < iterations; ++i) {
+        if (core::Equation::parse(expressions[i % expressions.size()], &equation, arithmetic))
+            g_sink += equation.result();
+    }
+    const double seconds = secondsSince(start);
+    report(name, iterations, seconds);
+    return seconds;
+}
+
+std::vector<std::string> makeIntegerExpressions(std::mt19937& random)
+{
+    std::vector<std::string> expressions;
+    expressions.reserve(g_expressionCount);
+    for (size_t i = 0; i < g_expressionCount; ++i) {
+        std::string expression = core::formatInteger(randomInteger(random) >> 8,
+                                                     core::Base::Hexadecimal);
+        const size_t operators = 1 + random() % 6;
+        for (size_t j = 0; j < operators; ++j) {
+            expression += g_integerOperatorTexts[random() % std::size(g_integerOperatorTexts)];
+            expression += std::to_string(1 + random() % 100000);
+        }
+        expressions.push_back(std::move(expression));
+    }
+    return expressions;
+}
+
+// Tokens per second stay flat from one to sixteen copies of the expression, as evaluation is
+// a single pass.
+void benchmarkNested(size_t iterations, std::mt19937& random)
+{
+    const std::string nested = makeNestedExpression(random);
+    core::Equation equation;
+    for (size_t copies = 1; copies <= 16; copies *= 4) {
+        std::string expression = nested;
+        for (size_t i = 1; i < copies; ++i)
+            expression += "+" + nested;
+        const size_t repeats = std::max<size_t>(1, iterations / 1000 / copies);
+        const auto start = Clock::now();
+        for (size_t i = 0; i < repeats; ++i) {
+            if (core::Equation::parse(expression, &equation))
+                g_sink += equation.result();
+        }
+        const std::string name = "parse nested x" + std::to_string(copies) + " tokens";
+        report(name.c_str(), repeats * equation.size(), secondsSince(start));
+    }
+}
+
+// Rows per second of column mode against copying the column, which bounds it from above: the
+// rounded × and ÷ steps cost more than memory traffic, + and - steps less.
+void benchmarkColumn(std::mt19937& random)
+{
+    std::vector<double> column(g_columnRows);
+    for (double& value : column)
+        value = double(1 + random() % 100000) / 100;
+    std::vector<double> results(column.size());
+    auto start = Clock::now();
+    std::copy(column.begin(), column.end(), results.begin());
+    report("column copy rows", column.size(), secondsSince(start));
+    g_sink += results.back();
+    for (const char* formula : g_columnFormulas) {
+        core::Equation equation;
+        std::vector<core::ColumnOperand> columns;
+        core::Status status = core::Status::Ok;
+        if (!makeColumnEquation(formula, column, &equation, &columns))
+            continue;
+        start = Clock::now();
+        core::evaluateColumn(equation, columns, 0, column.size(), results.data(), &status);
+        const std::string name = std::string("column ") + formula;
+        report(name.c_str(), column.size(), secondsSince(start));
+        g_sink += results.back();
+    }
+}
+
+// The extents of g_plotColumns pixel columns over [first, last) of series.
+void plotColumns(const core::ResultSeries& series, size_t first, size_t last,
+                 std::vector<core::Extent>* columns)
+{
+    const size_t span = last - first;
+    columns->resize(g_plotColumns);
+    for (size_t x = 0; x < g_plotColumns; ++x)
+        (*columns)[x] = series.extent(first + span * x / g_plotColumns,
+                                      first + span * (x + 1) / g_plotColumns);
+}
+
+// Appends four million results of a random walk, checks the extents of one plot against a scan
+// and draws frames of plot extents over all of them and over a window a thousandth as wide,
+// next to merely scanning every result once per frame.
+void benchmarkResultSeries(std::mt19937& random)
+{
+    std::normal_distribution<double> steps(0, 1);
+    std::vector<double> values(g_columnRows);
+    double walk = 0;
+    for (double& value : values)
+        value = walk += steps(random);
+    core::ResultSeries series;
+    auto start = Clock::now();
+    for (const double value : values)
+        series.append(value);
+    report("plot series append", values.size(), secondsSince(start));
+
+    std::vector<core::Extent> columns;
+    plotColumns(series, 0, values.size(), &columns);
+    for (size_t x = 0; x < g_plotColumns; ++x) {
+        const auto begin = values.begin() + ptrdiff_t(values.size() * x / g_plotColumns);
+        const auto end = values.begin() + ptrdiff_t(values.size() * (x + 1) / g_plotColumns);
+        const auto range = std::minmax_element(begin, end);
+        if (*range.first != columns[x].min || *range.second != columns[x].max) {
+            std::printf("plot column %zu does not match a scan\n", x);
+            return;
+        }
+    }
+    start = Clock::now();
+    for (size_t frame = 0; frame < g_plotFrames; ++frame) {
+        plotColumns(series, frame, values.size(), &columns);
+        g_sink += columns.back().max;
+    }
+    report("plot frame, all", g_plotFrames, secondsSince(start));
+    const size_t window = values.size() / g_plotZoom;
+    start = Clock::now();
+    for (size_t frame = 0; frame < g_plotFrames; ++frame) {
+        const size_t first = frame * (values.size() - window) / g_plotFrames;
+        plotColumns(series, first, first + window, &columns);
+        g_sink += columns.back().max;
+    }
+    report("plot frame, zoomed", g_plotFrames, secondsSince(start));
+    start = Clock::now();
+    for (size_t frame = 0; frame < g_plotFrames; ++frame)
+        g_sink += *std::max_element(values.begin() + ptrdiff_t(frame), values.end());
+    report("plot frame, scan", g_plotFrames, secondsSince(start));
+}
+
+void benchmarkKeystrokes(size_t iterations, std::mt19937& random)
+{
+    core::History history;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        const unsigned key = random() % 20;
+        if (key < 12) {
+            history.append(uint8_t(key % 10));
+        } else if (key < 16) {
+            history.append(core::Op(key - 12));
+        } else if (key < 18) {
+            history.append(core::Op::Equal);
+        } else if (key == 18) {
+            history.tryPopLastCharacter();
+        } else {
+            history.appendDecimal();
+        }
+    }
+    g_sink += history.statistics().summary().sum;
+    report("history keystrokes", iterations, secondsSince(start));
+}
+
+void benchmarkAppendCompleted(const std::vector<std::string>& expressions, size_t iterations)
+{
+    std::vector<core::Equation> equations(expressions.size());
+    for (size_t i = 0; i < expressions.size(); ++i)
+        core::Equation::parse(expressions[i], &equations[i]);
+    core::History history;
+    const auto start = Clock::now();
+    for (size_t done = 0; done < iterations; done += equations.size())
+        history.appendCompleted(equations);
+    g_sink += history.statistics().summary().sum;
+    report("history append completed",
+           (iterations + equations.size() - 1) / equations.size() * equations.size(),
+           secondsSince(start));
+}
+
+// A chain of "+1=" lines, each continuing from the previous result, whose first line is
+// edited so that every later line is recomputed.
+void benchmarkEditChain(size_t iterations)
+{
+    core::History history(g_chainLength + 1);
+    history.append(uint8_t(0));
+    for (size_t i = 0; i < g_chainLength; ++i) {
+        history.append(core::Op::Plus);
+        history.append(uint8_t(1));
+        history.append(core::Op::Equal);
+    }
+    const size_t edits = std::max<size_t>(iterations / g_chainLength, 1);
+    std::vector<size_t> changedIds;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < edits; ++i) {
+        changedIds.clear();
+        history.editNumber(history.firstId(), 0, std::to_string(i % 2 + 1), &changedIds);
+    }
+    const double seconds = secondsSince(start);
+    if (history.back().result() != double((edits - 1) % 2 + 1 + g_chainLength))
+        std::fprintf(stderr, "edited chain ends with %s\n", history.back().text().c_str());
+    g_sink += history.statistics().summary().sum;
+    report("recomputed lines after edits", edits * changedIds.size(), seconds);
+}
+
+void benchmarkFormat(size_t iterations, std::mt19937& random)
+{
+    std::uniform_real_distribution<double> values(-1e6, 1e6);
+    double value = values(random);
+    const auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        const std::string text = core::formatNumber(value);
+        double parsed = 0;
+        core::parseNumber(text, &parsed);
+        value = parsed * 1.000001 + 1;
+    }
+    g_sink += value;
+    report("format and parse", iterations, secondsSince(start));
+}
+
+// Calculates a mix of completed lines and unfinished ones such as "7+", once through the
+// throwing calculate() and once through tryCalculate().
+void benchmarkStatus(const std::vector<std::string>& expressions, size_t iterations)
+{
+    std::vector<core::Equation> equations(expressions.size());
+    for (size_t i = 0; i < expressions.size(); ++i) {
+        if (i % g_unfinishedEvery == 0) {
+            equations[i].append(uint8_t(i % 10));
+            equations[i].append(core::Op::Plus);
+        } else {
+            core::Equation::parse(expressions[i], &equations[i]);
+        }
+    }
+    size_t failures = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        try {
+            g_sink += equations[i % equations.size()].calculate();
+        } catch (const std::invalid_argument&) {
+            ++failures;
+        }
+    }
+    const double throwingSeconds = secondsSince(start);
+    report("calculate, throwing", iterations, throwingSeconds);
+    start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        core::Evaluation evaluation;
+        if (equations[i % equations.size()].tryCalculate(&evaluation))
+            g_sink += evaluation.value;
+        else
+            ++failures;
+    }
+    const double statusSeconds = secondsSince(start);
+    report("calculate, status", iterations, statusSeconds);
+    std::printf("with every %zuth line unfinished, status codes take %.2fx the time of exceptions\n",
+                g_unfinishedEvery, throwingSeconds > 0 ? statusSeconds / throwingSeconds : 0.0);
+    g_sink += double(failures);
+}
+
+void benchmarkIntegerText(size_t iterations, std::mt19937& random)
+{
+    std::vector<int64_t> values(g_expressionCount);
+    for (int64_t& value : values)
+        value = randomInteger(random);
+    char text[core::g_maxIntegerText + 1];
+    const char* const names[][2] = {{"snprintf %lld", "formatInteger decimal"},
+                                    {"snprintf 0x%llX", "formatInteger hex"}};
+    for (size_t hex = 0; hex < 2; ++hex) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            const long long value = values[i % values.size()];
+            if (hex)
+                std::snprintf(text, sizeof(text), "0x%llX", static_cast<unsigned long long>(value));
+            else
+                std::snprintf(text, sizeof(text), "%lld", value);
+            g_sink += text[1];
+        }
+        const double printfSeconds = secondsSince(start);
+        report(names[hex][0], iterations, printfSeconds);
+        const core::Base base = hex ? core::Base::Hexadecimal : core::Base::Decimal;
+        start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+            g_sink += text[core::writeInteger(values[i % values.size()], base, text) - 1];
+        const double formatSeconds = secondsSince(start);
+        report(names[hex][1], iterations, formatSeconds);
+        std::printf("formatInteger takes %.2fx the time of snprintf\n",
+                    printfSeconds > 0 ? formatSeconds / printfSeconds : 0.0);
+    }
+}
+
+void benchmarkNumberText(size_t iterations, std::mt19937& random)
+{
+    std::vector<double> values(g_expressionCount);
+    for (double& value : values)
+        value = randomDouble(random);
+    std::vector<std::string> texts;
+    texts.reserve(values.size());
+    for (double value : values)
+        texts.push_back(core::formatShortest(value));
+    char text[g_numberTextSize];
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        std::snprintf(text, sizeof(text), "%.15g", values[i % values.size()]);
+        g_sink += text[0];
+    }
+    const double printfSeconds = secondsSince(start);
+    report("snprintf %.15g", iterations, printfSeconds);
+    start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        g_sink += core::formatNumber(values[i % values.size()])[0];
+    const double formatSeconds = secondsSince(start);
+    report("formatNumber", iterations, formatSeconds);
+    start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        std::snprintf(text, sizeof(text), "%.17g", values[i % values.size()]);
+        g_sink += text[0];
+    }
+    report("snprintf %.17g", iterations, secondsSince(start));
+    start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        g_sink += core::formatShortest(values[i % values.size()])[0];
+    report("formatShortest", iterations, secondsSince(start));
+
+    start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        g_sink += std::strtod(texts[i % texts.size()].c_str(), nullptr);
+    const double strtodSeconds = secondsSince(start);
+    report("strtod", iterations, strtodSeconds);
+    start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        double value = 0;
+        core::parseNumber(texts[i % texts.size()], &value);
+        g_sink += value;
+    }
+    const double parseSeconds = secondsSince(start);
+    report("parseNumber", iterations, parseSeconds);
+    std::printf("formatting takes %.2fx the time of snprintf, parsing %.2fx the time of strtod\n",
+                printfSeconds > 0 ? formatSeconds / printfSeconds : 0.0,
+                strtodSeconds > 0 ? parseSeconds / strtodSeconds : 0.0);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t iterations =
+        argc > 1 ? std::strtoull(argv[1], nullptr, 10) : g_defaultIterations;
+    if (iterations == 0) {
+        std::fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 2;
+    }
+    if (checkConstantEvaluation() > 0 || checkExactEvaluation() > 0 ||
+        checkIntegerEvaluation() > 0)
+        return 1;
+    std::printf("constexpr evaluation matches runtime for %zu expressions\n",
+                sizeof(g_constantCases) / sizeof(g_constantCases[0]));
+    std::printf("exact arithmetic matches for %zu expressions\n",
+                sizeof(g_exactCases) / sizeof(g_exactCases[0]));
+    std::printf("integer arithmetic matches for %zu expressions\n", std::size(g_integerCases));
+    std::mt19937 random(1);
+    if (checkNumberText(random) > 0)
+        return 1;
+    std::printf("number text matches the C library for %zu values\n", g_numberTextChecks);
+    if (checkIntegerText(random) > 0)
+        return 1;
+    std::printf("integer text matches the C library for %zu values in 4 bases\n",
+                g_numberTextChecks);
+    if (checkColumnEvaluation(random) > 0)
+        return 1;
+    std::printf("column mode matches single equations for %zu rows of %zu formulas\n",
+                g_columnChecks, std::size(g_columnFormulas));
+    if (checkStatistics(random) > 0)
+        return 1;
+    std::printf("running statistics match recomputation over %zu updates with inf and NaN\n",
+                g_statisticsChecks);
+    const std::vector<std::string> expressions = makeExpressions(random);
+    const double doubleSeconds =
+        benchmarkParse(expressions, iterations, core::Arithmetic::Double, "parse and evaluate");
+    const double exactSeconds =
+        benchmarkParse(expressions, iterations, core::Arithmetic::Exact, "parse and evaluate exact");
+    std::printf("exact arithmetic takes %.2fx the time of double\n",
+                doubleSeconds > 0 ? exactSeconds / doubleSeconds : 0.0);
+    benchmarkParse(makeIntegerExpressions(random), iterations, core::Arithmetic::Integer,
+                   "parse and evaluate int64");
+    benchmarkNested(iterations, random);
+    benchmarkColumn(random);
+    benchmarkResultSeries(random);
+    benchmarkKeystrokes(iterations, random);
+    benchmarkAppendCompleted(expressions, iterations);
+    benchmarkEditChain(iterations);
+    benchmarkStatus(expressions, iterations);
+    benchmarkFormat(iterations, random);
+    benchmarkNumberText(iterations, random);
+    benchmarkIntegerText(iterations, random);
+    std::printf("checksum %g\n", g_sink);
+    return 0;
+}
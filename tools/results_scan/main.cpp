@@ -0,0 +1,63 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QtNumeric>
+
+#include "core/number_text.h"
+#include "results_store.h"
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Scans a results store written by CalculatorWithHistory."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("store"), QStringLiteral("Results store file."));
+    const QCommandLineOption findOption(QStringLiteral("find"),
+                                        QStringLiteral("Print the indexes of <value>."),
+                                        QStringLiteral("value"));
+    const QCommandLineOption lowOption(QStringLiteral("low"),
+                                       QStringLiteral("Lower bound of the counted range."),
+                                       QStringLiteral("value"));
+    const QCommandLineOption highOption(QStringLiteral("high"),
+                                        QStringLiteral("Upper bound of the counted range."),
+                                        QStringLiteral("value"));
+    parser.addOptions({findOption, lowOption, highOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+    ResultsStore store;
+    if (!store.open(parser.positionalArguments().first())) {
+        err << "Cannot open results store " << parser.positionalArguments().first() << '\n';
+        return 1;
+    }
+
+    out << "count " << store.size() << '\n';
+    if (store.skipped() > 0)
+        out << "skipped " << store.skipped() << '\n';
+    out << "sum " << QString::fromStdString(core::formatShortest(store.sum())) << '\n';
+    double min;
+    double max;
+    if (store.range(&min, &max)) {
+        out << "min " << QString::fromStdString(core::formatShortest(min)) << '\n';
+        out << "max " << QString::fromStdString(core::formatShortest(max)) << '\n';
+    }
+    if (parser.isSet(lowOption) || parser.isSet(highOption)) {
+        const double low = parser.isSet(lowOption) ? parser.value(lowOption).toDouble() : -qInf();
+        const double high = parser.isSet(highOption) ? parser.value(highOption).toDouble() : qInf();
+        out << "in range " << store.countInRange(low, high) << '\n';
+    }
+    if (parser.isSet(findOption)) {
+        const double value = parser.value(findOption).toDouble();
+        out << "found";
+        for (size_t i = store.indexOf(value); i < store.size(); i = store.indexOf(value, i + 1))
+            out << ' ' << i;
+        out << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPushButton>
+#include <QTest>
+#include <QTextStream>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+#include "core/equation.h"
+#include "display.h"
+#include "equation_inbox.h"
+#include "main_window.h"
+#include "memory_accounting.h"
+
+namespace {
+enum class Action { Digit, Operator, Equal, Decimal, Backspace, Clear, Sign, Percent, Count };
+
+const std::array<const char*, size_t(Action::Count)> g_actionNames = {
+    "digit", "operator", "equal", "decimal", "backspace", "clear", "sign", "percent"};
+const QString g_defaultMix("digit=50,operator=15,equal=10,decimal=5,backspace=8,clear=4,sign=4,"
+                           "percent=4");
+constexpr std::array<Qt::Key, 4> g_operatorKeys = {Qt::Key_Plus, Qt::Key_Minus, Qt::Key_Asterisk,
+                                                   Qt::Key_Slash};
+constexpr int g_reportIntervalMs = 10000;
+constexpr int g_warmupKeystrokes = 10000;
+
+struct Limits
+{
+    double maxLatencyMs = 250;
+    double maxP99LatencyMs = 20;
+    double maxRssGrowthMb = 64;
+    int maxElementDisplays = 1000;
+    int maxElementPaths = 1000;
+    double maxAccountedMb = 16;
+    size_t maxQueueSize = 32;
+    double maxDrainLatencyMs = 100;
+};
+
+// Pushes rate equations per second into inbox from its own thread, as the evaluation server
+// does, until stop is set.
+void pushEquations(EquationInbox* inbox, double rate, const std::atomic<bool>* stop)
+{
+    const auto interval = std::chrono::duration<double>(1 / rate);
+    auto next = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; !stop->load(std::memory_order_relaxed); ++i) {
+        core::Equation equation;
+        if (core::Equation::parse(std::to_string(i) + "*2", &equation))
+            inbox->push(std::move(equation));
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+        std::this_thread::sleep_until(next);
+    }
+}
+
+qint64 residentSetSize()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.WorkingSetSize);
+    return 0;
+#elif defined(Q_OS_LINUX)
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return 0;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+bool parseMix(const QString& text, std::vector<double>* weights)
+{
+    weights->assign(size_t(Action::Count), 0);
+    for (const QString& item : text.split(QChar(','), Qt::SkipEmptyParts)) {
+        const QStringList pair = item.split(QChar('='));
+        if (pair.size() != 2)
+            return false;
+        const auto name = std::find(g_actionNames.begin(), g_actionNames.end(),
+                                    pair[0].trimmed().toLatin1());
+        bool ok;
+        const double weight = pair[1].toDouble(&ok);
+        if (name == g_actionNames.end() || !ok || weight < 0)
+            return false;
+        (*weights)[name - g_actionNames.begin()] = weight;
+    }
+    return std::any_of(weights->begin(), weights->end(), [](double w) { return w > 0; });
+}
+
+double percentile(std::vector<double>& samples, double fraction)
+{
+    if (samples.empty())
+        return 0;
+    const size_t n = std::min(samples.size() - 1, size_t(fraction * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+    return samples[n];
+}
+
+class SoakDriver
+{
+public:
+    SoakDriver(MainWindow* window, std::vector<double> weights, quint32 seed)
+        : _window(window), _mix(weights.begin(), weights.end()), _random(seed)
+    {
+        _equal = window->findChild<QPushButton*>(QStringLiteral("equal"));
+        _sign = window->findChild<QPushButton*>(QStringLiteral("sign"));
+    }
+
+    // Digits, operators, decimal, clear and percent travel through the button shortcuts like
+    // real key presses, backspace through MainWindow::keyPressEvent. Equal and sign have no
+    // shortcut and Enter animates the click with a delay, so those buttons are clicked.
+    void step()
+    {
+        switch (Action(_mix(_random))) {
+        case Action::Digit:
+            QTest::keyClick(_window, Qt::Key(Qt::Key_0 + _random() % 10));
+            break;
+        case Action::Operator:
+            QTest::keyClick(_window, g_operatorKeys[_random() % g_operatorKeys.size()]);
+            break;
+        case Action::Equal:
+            _equal->click();
+            break;
+        case Action::Decimal:
+            QTest::keyClick(_window, Qt::Key_Period);
+            break;
+        case Action::Backspace:
+            QTest::keyClick(_window, Qt::Key_Backspace);
+            break;
+        case Action::Clear:
+            QTest::keyClick(_window, Qt::Key_C);
+            break;
+        case Action::Sign:
+            _sign->click();
+            break;
+        case Action::Percent:
+            QTest::keyClick(_window, Qt::Key_Percent);
+            break;
+        case Action::Count:
+            break;
+        }
+    }
+
+private:
+    MainWindow* _window;
+    QPushButton* _equal;
+    QPushButton* _sign;
+    std::discrete_distribution<int> _mix;
+    std::mt19937 _random;
+};
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Drives MainWindow with synthetic keystrokes and checks resource limits."));
+    parser.addHelpOption();
+    const QCommandLineOption durationOption(QStringLiteral("duration"),
+                                            QStringLiteral("Run time in seconds."),
+                                            QStringLiteral("seconds"), QStringLiteral("60"));
+    const QCommandLineOption mixOption(QStringLiteral("mix"),
+                                       QStringLiteral("Keystroke weights, e.g. ") + g_defaultMix,
+                                       QStringLiteral("weights"), g_defaultMix);
+    const QCommandLineOption seedOption(QStringLiteral("seed"), QStringLiteral("Random seed."),
+                                        QStringLiteral("seed"), QStringLiteral("1"));
+    const QCommandLineOption latencyOption(QStringLiteral("max-latency-ms"),
+                                           QStringLiteral("Worst keystroke latency."),
+                                           QStringLiteral("ms"), QStringLiteral("250"));
+    const QCommandLineOption p99Option(QStringLiteral("max-p99-ms"),
+                                       QStringLiteral("99th percentile keystroke latency."),
+                                       QStringLiteral("ms"), QStringLiteral("20"));
+    const QCommandLineOption rssOption(QStringLiteral("max-rss-growth-mb"),
+                                       QStringLiteral("Resident memory growth after warm-up."),
+                                       QStringLiteral("mb"), QStringLiteral("64"));
+    const QCommandLineOption displaysOption(QStringLiteral("max-element-displays"),
+                                            QStringLiteral("Live ElementDisplay widgets."),
+                                            QStringLiteral("count"), QStringLiteral("1000"));
+    const QCommandLineOption pathsOption(QStringLiteral("max-element-paths"),
+                                         QStringLiteral("Live ElementPath objects."),
+                                         QStringLiteral("count"), QStringLiteral("1000"));
+    const QCommandLineOption accountedOption(
+        QStringLiteral("max-accounted-mb"),
+        QStringLiteral("Estimated memory of elements, columns, displays and paths."),
+        QStringLiteral("mb"), QStringLiteral("16"));
+    const QCommandLineOption queueOption(QStringLiteral("max-queue-size"),
+                                         QStringLiteral("Equations held by EquationQueue."),
+                                         QStringLiteral("count"), QStringLiteral("32"));
+    const QCommandLineOption inboxRateOption(
+        QStringLiteral("inbox-rate"),
+        QStringLiteral("Equations per second pushed into the inbox from another thread."),
+        QStringLiteral("rate"), QStringLiteral("0"));
+    const QCommandLineOption drainLatencyOption(
+        QStringLiteral("max-drain-latency-ms"),
+        QStringLiteral("Time from an inbox push until its drain is applied."),
+        QStringLiteral("ms"), QStringLiteral("100"));
+    parser.addOptions({durationOption, mixOption, seedOption, latencyOption, p99Option, rssOption,
+                       displaysOption, pathsOption, accountedOption, queueOption, inboxRateOption,
+                       drainLatencyOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    std::vector<double> weights;
+    if (!parseMix(parser.value(mixOption), &weights)) {
+        out << "Invalid keystroke mix " << parser.value(mixOption) << Qt::endl;
+        return 2;
+    }
+    Limits limits;
+    limits.maxLatencyMs = parser.value(latencyOption).toDouble();
+    limits.maxP99LatencyMs = parser.value(p99Option).toDouble();
+    limits.maxRssGrowthMb = parser.value(rssOption).toDouble();
+    limits.maxElementDisplays = parser.value(displaysOption).toInt();
+    limits.maxElementPaths = parser.value(pathsOption).toInt();
+    limits.maxAccountedMb = parser.value(accountedOption).toDouble();
+    limits.maxQueueSize = parser.value(queueOption).toULongLong();
+    limits.maxDrainLatencyMs = parser.value(drainLatencyOption).toDouble();
+    const double inboxRate = parser.value(inboxRateOption).toDouble();
+    const qint64 durationMs = qint64(parser.value(durationOption).toDouble() * 1000);
+
+    MainWindow window;
+    window.show();
+    window.activateWindow();
+    if (!QTest::qWaitForWindowActive(&window)) {
+        out << "MainWindow did not become active" << Qt::endl;
+        return 2;
+    }
+
+    SoakDriver driver(&window, weights, parser.value(seedOption).toUInt());
+    std::atomic<bool> stopPushing{false};
+    std::thread pusher;
+    if (inboxRate > 0)
+        pusher = std::thread(pushEquations, window.inbox(), inboxRate, &stopPushing);
+    QElapsedTimer total;
+    QElapsedTimer keystroke;
+    total.start();
+    qint64 nextReportMs = g_reportIntervalMs;
+    qint64 keystrokes = 0;
+    qint64 baselineRss = 0;
+    double worstLatencyMs = 0;
+    std::vector<double> intervalLatencies;
+    QStringList failures;
+
+    while (failures.isEmpty() && total.elapsed() < durationMs) {
+        keystroke.start();
+        driver.step();
+        QCoreApplication::processEvents();
+        const double latencyMs = keystroke.nsecsElapsed() / 1e6;
+        ++keystrokes;
+        intervalLatencies.push_back(latencyMs);
+        worstLatencyMs = std::max(worstLatencyMs, latencyMs);
+        if (keystrokes == g_warmupKeystrokes)
+            baselineRss = residentSetSize();
+
+        if (latencyMs > limits.maxLatencyMs)
+            failures << QStringLiteral("keystroke latency %1 ms").arg(latencyMs);
+        if (ElementDisplay::liveCount() > limits.maxElementDisplays)
+            failures << QStringLiteral("%1 live ElementDisplay").arg(ElementDisplay::liveCount());
+        if (ElementPath::liveCount() > limits.maxElementPaths)
+            failures << QStringLiteral("%1 live ElementPath").arg(ElementPath::liveCount());
+        const double accountedMb = totalMemoryUsage().bytes / 1048576.0;
+        if (accountedMb > limits.maxAccountedMb)
+            failures << QStringLiteral("%1 MB accounted").arg(accountedMb);
+        if (window.equations()->size() > limits.maxQueueSize)
+            failures << QStringLiteral("EquationQueue size %1").arg(window.equations()->size());
+
+        if (total.elapsed() >= nextReportMs || !failures.isEmpty() ||
+            total.elapsed() >= durationMs) {
+            nextReportMs += g_reportIntervalMs;
+            const qint64 rss = residentSetSize();
+            const double rssGrowthMb = baselineRss > 0 ? (rss - baselineRss) / 1048576.0 : 0;
+            const double p99 = percentile(intervalLatencies, 0.99);
+            const EquationInboxMetrics inbox = window.inbox()->metrics();
+            const double maxDrainLatencyMs = inbox.maxDrainLatencyNs / 1e6;
+            out << total.elapsed() / 1000 << "s keystrokes " << keystrokes << " p99 " << p99
+                << " ms worst " << worstLatencyMs << " ms rss " << rss / 1048576.0
+                << " MB growth " << rssGrowthMb << " MB displays " << ElementDisplay::liveCount()
+                << " paths " << ElementPath::liveCount() << " accounted " << accountedMb
+                << " MB queue " << window.equations()->size() << " inbox depth " << inbox.depth
+                << " drained " << inbox.drained << " in " << inbox.drains << " drains, worst "
+                << maxDrainLatencyMs << " ms" << Qt::endl;
+            if (p99 > limits.maxP99LatencyMs)
+                failures << QStringLiteral("p99 keystroke latency %1 ms").arg(p99);
+            if (rssGrowthMb > limits.maxRssGrowthMb)
+                failures << QStringLiteral("resident memory grew by %1 MB").arg(rssGrowthMb);
+            if (maxDrainLatencyMs > limits.maxDrainLatencyMs)
+                failures << QStringLiteral("inbox drain latency %1 ms").arg(maxDrainLatencyMs);
+            intervalLatencies.clear();
+        }
+    }
+    stopPushing.store(true, std::memory_order_relaxed);
+    if (pusher.joinable())
+        pusher.join();
+
+    for (const QString& failure : failures)
+        out << "FAIL: " << failure << Qt::endl;
+    if (failures.isEmpty())
+        out << "PASS: " << keystrokes << " keystrokes" << Qt::endl;
+    return failures.isEmpty() ? 0 : 1;
+}